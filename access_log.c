@@ -0,0 +1,201 @@
+/// @file access_log.c
+/// @brief Contains functions for the access log.
+/// @details This file includes functions to record served requests into a log ring, whose background thread writes them to the
+/// log file as JSON lines.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "access_log.h"
+#include "log_ring.h"
+
+// Number of records the ring holds, a power of two.
+#define ACCESS_LOG_RING_SIZE 4096
+
+// Size of the buffer the writer formats lines into before writing them out.
+#define ACCESS_LOG_FLUSH_SIZE (64 * 1024)
+
+// The longest line a record formats to, with every path byte escaped.
+#define ACCESS_LOG_LINE_MAX (ACCESS_LOG_PATH_MAX * 6 + 256)
+
+static size_t format_record(const void* data, char* line);
+
+static access_record_t records[ACCESS_LOG_RING_SIZE];
+static char lines[ACCESS_LOG_FLUSH_SIZE];
+
+static log_ring_t ring = {
+    .records = records,
+    .record_size = sizeof(access_record_t),
+    .slot_count = ACCESS_LOG_RING_SIZE,
+    .out = lines,
+    .out_size = ACCESS_LOG_FLUSH_SIZE,
+    .line_max = ACCESS_LOG_LINE_MAX,
+    .format = format_record,
+};
+
+static int log_fd = -1;
+
+/**
+ * @brief Opens the access log and starts its writer thread.
+ * @param path The path of the log. Lines are appended if it exists.
+ * @return Returns 0 on success, or -1 if the log could not be opened.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int access_log_open(const char* path) {
+    log_fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log_fd < 0) {
+        perror("Opening access log failed");
+        return -1;
+    }
+
+    if (log_ring_start(&ring, log_fd) != 0) {
+        perror("Starting access log writer failed");
+        close(log_fd);
+        log_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Checks whether access logging is enabled.
+ * @return Returns true if the access log is open, false otherwise.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool access_log_enabled() {
+    return log_fd >= 0;
+}
+
+/**
+ * @brief Marks the arrival of the first byte of a request.
+ * @details Later calls for the same request leave the start time alone, so it can be called on every receive.
+ * @param record The record of the request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void access_log_start(access_record_t* record) {
+    if (log_fd < 0 || record->start.tv_sec != 0 || record->start.tv_nsec != 0) return;
+
+    clock_gettime(CLOCK_MONOTONIC, &record->start);
+    record->time = time(NULL);
+}
+
+/**
+ * @brief Stores the method and path of a request in its record.
+ * @details Both are truncated to the fixed size of the record.
+ * @param record The record of the request.
+ * @param method The HTTP method.
+ * @param path The requested path.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void access_log_set_request(access_record_t* record, const char* method, const char* path) {
+    if (log_fd < 0) return;
+
+    snprintf(record->method, sizeof(record->method), "%s", method);
+    snprintf(record->path, sizeof(record->path), "%s", path);
+}
+
+/**
+ * @brief Stores the error a connection failed with in its record.
+ * @param record The record of the request.
+ * @param error The errno of the failed receive.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void access_log_set_error(access_record_t* record, int error) {
+    if (log_fd < 0) return;
+
+    access_log_start(record);
+    record->error = error;
+}
+
+/**
+ * @brief Hands the record of a finished request to the writer.
+ * @details Connections that closed without a response or an error are not logged. If the ring is full, the record is dropped and counted.
+ * @param record The record of the request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void access_log_finish(access_record_t* record) {
+    if (log_fd < 0 || (record->status == 0 && record->error == 0)) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    record->latency_us = (now.tv_sec - record->start.tv_sec) * 1000000 + (now.tv_nsec - record->start.tv_nsec) / 1000;
+
+    access_record_t* slot = log_ring_claim(&ring);
+    if (!slot) return;
+
+    *slot = *record;
+    log_ring_push(&ring);
+}
+
+/**
+ * @brief Gets the number of records dropped because the ring was full.
+ * @return Returns the number of dropped records.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t access_log_get_drops() {
+    return ring.drops;
+}
+
+/**
+ * @brief Closes the access log.
+ * @details This function lets the writer drain the ring, waits for it and closes the log.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of pending records. Space complexity: O(1).
+ */
+void access_log_close() {
+    if (log_fd < 0) return;
+
+    log_ring_stop(&ring);
+
+    close(log_fd);
+    log_fd = -1;
+}
+
+/**
+ * @brief Formats a record as a JSON line.
+ * @details Quotes, backslashes and control characters in the method and path are escaped. The error of a failed connection is
+ * added as its description.
+ * @param data The record, an access_record_t.
+ * @param line A buffer of at least ACCESS_LOG_LINE_MAX bytes.
+ * @return Returns the length of the line, including the newline.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static size_t format_record(const void* data, char* line) {
+    const access_record_t* record = data;
+    char escaped[2][ACCESS_LOG_PATH_MAX * 6];
+    const char* fields[2] = { record->method, record->path };
+
+    for (int i = 0; i < 2; i++) {
+        char* out = escaped[i];
+        for (const unsigned char* c = (const unsigned char*)fields[i]; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                *out++ = '\\';
+                *out++ = *c;
+            } else if (*c < 0x20) {
+                out += sprintf(out, "\\u%04x", *c);
+            } else {
+                *out++ = *c;
+            }
+        }
+        *out = '\0';
+    }
+
+    size_t length = sprintf(line,
+        "{\"time\":%lld,\"method\":\"%s\",\"path\":\"%s\",\"status\":%d,\"bytes\":%llu,\"latency_us\":%u",
+        (long long)record->time, escaped[0], escaped[1], record->status, (unsigned long long)record->bytes, record->latency_us
+    );
+    if (record->error) {
+        length += sprintf(line + length, ",\"error\":\"%s\"", strerror(record->error));
+    }
+    line[length++] = '}';
+    line[length++] = '\n';
+    return length;
+}
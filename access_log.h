@@ -0,0 +1,38 @@
+#ifndef ACCESS_LOG_H
+#define ACCESS_LOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/// @file access_log.h
+/// @brief Contains function declarations for the access log.
+/// @details The event loop hands a fixed-size record per request to a lock-free ring, and a background thread formats the records
+/// as JSON lines and writes them in batches. When the ring is full, records are dropped and counted rather than waited for.
+
+#define ACCESS_LOG_METHOD_MAX 8
+#define ACCESS_LOG_PATH_MAX 64
+
+// The access log record of a request, filled in as the request is served.
+typedef struct {
+    struct timespec start;  // When the first byte of the request arrived, on the monotonic clock.
+    time_t time;            // When the first byte of the request arrived, on the wall clock.
+    uint32_t latency_us;
+    int status;             // 0 until a response has been sent.
+    int error;              // The errno of a failed receive, 0 if none.
+    uint64_t bytes;
+    char method[ACCESS_LOG_METHOD_MAX];
+    char path[ACCESS_LOG_PATH_MAX];
+} access_record_t;
+
+int access_log_open(const char* path);
+bool access_log_enabled();
+void access_log_start(access_record_t* record);
+void access_log_set_request(access_record_t* record, const char* method, const char* path);
+void access_log_set_error(access_record_t* record, int error);
+void access_log_finish(access_record_t* record);
+size_t access_log_get_drops();
+void access_log_close();
+
+#endif
@@ -0,0 +1,123 @@
+/// @file arena.c
+/// @brief Contains a bump-pointer arena allocator.
+/// @details This file includes functions to allocate short-lived scratch memory from an arena and to discard all of it at once.
+/// Arena blocks are taken from the buffer pool, so a warmed-up arena never calls malloc.
+
+#include <string.h>
+
+#include "arena.h"
+#include "buffer_pool.h"
+
+#define ARENA_BLOCK_SIZE 4096
+#define ARENA_ALIGNMENT 16
+
+// Header at the start of every block, linking it to the block that was current before it.
+typedef struct {
+    char* previous;
+    size_t previous_capacity;
+} arena_header_t;
+
+/**
+ * @brief Rounds a size up to the arena alignment.
+ * @param size The size to round.
+ * @return Returns the rounded size.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Allocates memory from the arena.
+ * @details This function bumps the offset of the current block. When the block is exhausted, a new block at least twice as large is
+ * taken from the buffer pool and the old block is chained behind it until the arena is reset.
+ * @param arena Pointer to the arena.
+ * @param size The number of bytes to allocate.
+ * @return Returns a pointer to the allocated memory, aligned to ARENA_ALIGNMENT bytes.
+ * @note Time complexity: O(1). Space complexity: O(n) where n is the size.
+ */
+void* arena_alloc(arena_t* arena, size_t size) {
+    size = align_up(size);
+
+    if (!arena->block || arena->offset + size > arena->capacity) {
+        size_t header_size = align_up(sizeof(arena_header_t));
+        size_t block_size = (arena->capacity * 2 > ARENA_BLOCK_SIZE) ? arena->capacity * 2 : ARENA_BLOCK_SIZE;
+        if (block_size < header_size + size) block_size = header_size + size;
+
+        size_t capacity;
+        char* block = buffer_acquire(block_size, &capacity);
+
+        arena_header_t* header = (arena_header_t*)block;
+        header->previous = arena->block;
+        header->previous_capacity = arena->capacity;
+
+        arena->block = block;
+        arena->capacity = capacity;
+        arena->offset = header_size;
+    }
+
+    void* ptr = arena->block + arena->offset;
+    arena->offset += size;
+    return ptr;
+}
+
+/**
+ * @brief Releases every block except the current one.
+ * @param arena Pointer to the arena.
+ * @return This function does not return a value.
+ * @note Time complexity: O(b) where b is the number of chained blocks, O(1) in the common single-block case. Space complexity: O(1).
+ */
+static void release_previous_blocks(arena_t* arena) {
+    arena_header_t* header = (arena_header_t*)arena->block;
+    char* block = header->previous;
+    size_t capacity = header->previous_capacity;
+
+    while (block) {
+        arena_header_t* previous = (arena_header_t*)block;
+        char* next = previous->previous;
+        size_t next_capacity = previous->previous_capacity;
+
+        buffer_release(block, capacity);
+        block = next;
+        capacity = next_capacity;
+    }
+
+    header->previous = NULL;
+    header->previous_capacity = 0;
+}
+
+/**
+ * @brief Discards everything allocated from the arena.
+ * @details This function keeps the current block for reuse and rewinds its offset if it is a block of ARENA_BLOCK_SIZE bytes. Blocks
+ * chained behind it go back to the pool, and so does a larger current block, which only a large request needed and which would
+ * otherwise be kept, outside of the pool's limits, by an arena that is idle.
+ * @param arena Pointer to the arena.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1) in the common single-block case. Space complexity: O(1).
+ */
+void arena_reset(arena_t* arena) {
+    if (!arena->block) return;
+
+    if (arena->capacity > ARENA_BLOCK_SIZE) {
+        arena_release(arena);
+        return;
+    }
+
+    release_previous_blocks(arena);
+    arena->offset = align_up(sizeof(arena_header_t));
+}
+
+/**
+ * @brief Returns all arena blocks to the pool.
+ * @param arena Pointer to the arena.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1) in the common single-block case. Space complexity: O(1).
+ */
+void arena_release(arena_t* arena) {
+    if (!arena->block) return;
+
+    release_previous_blocks(arena);
+    buffer_release(arena->block, arena->capacity);
+
+    memset(arena, 0x00, sizeof(arena_t));
+}
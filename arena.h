@@ -0,0 +1,17 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump-pointer allocator backed by pooled buffers. Older blocks are chained through a header at their start.
+typedef struct {
+    char* block;
+    size_t capacity;
+    size_t offset;
+} arena_t;
+
+void* arena_alloc(arena_t* arena, size_t size);
+void arena_reset(arena_t* arena);
+void arena_release(arena_t* arena);
+
+#endif
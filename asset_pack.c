@@ -0,0 +1,183 @@
+/// @file asset_pack.c
+/// @brief Contains functions for serving responses from an asset pack.
+/// @details This file includes functions to map a pack built by pack_gen and to look request paths up in its index. Opening a pack
+/// only checks its header, entries are checked when they are looked up, so startup takes the same time for any number of files.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "asset_pack.h"
+#include "network_utils.h"
+
+static int fd = -1;
+static const char* map = NULL;
+static size_t map_size = 0;
+static const pack_header_t* header = NULL;
+static const pack_slot_t* slots = NULL;
+static const pack_entry_t* entries = NULL;
+
+// Cache entries wrapping the responses sent from memory, built on their first request and never evicted.
+static cached_response_t** pinned = NULL;
+
+static bool entry_valid(const pack_entry_t* entry);
+
+/**
+ * @brief Maps an asset pack.
+ * @param path The path of the pack.
+ * @return Returns 0 on success, or -1 if the pack could not be opened or is not a valid pack.
+ * @note Time complexity: O(1). Space complexity: O(n) where n is the number of entries, in zeroed pages touched on demand.
+ */
+int pack_open(const char* path) {
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Opening asset pack failed");
+        return -1;
+    }
+
+    struct stat pack_stat;
+    if (fstat(fd, &pack_stat) < 0 || (size_t)pack_stat.st_size < sizeof(pack_header_t)) {
+        fprintf(stderr, "%s: not an asset pack\n", path);
+        pack_close();
+        return -1;
+    }
+    map_size = pack_stat.st_size;
+
+    map = mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("Mapping asset pack failed");
+        map = NULL;
+        pack_close();
+        return -1;
+    }
+
+    header = (const pack_header_t*)map;
+    size_t tables = sizeof(pack_header_t) + (size_t)header->slot_count * sizeof(pack_slot_t)
+        + (size_t)header->entry_count * sizeof(pack_entry_t);
+    if (memcmp(header->magic, PACK_MAGIC, sizeof(header->magic)) != 0 || header->size != map_size || header->slot_count == 0
+        || (header->slot_count & (header->slot_count - 1)) != 0 || tables > map_size) {
+        fprintf(stderr, "%s: not an asset pack, or a truncated one\n", path);
+        pack_close();
+        return -1;
+    }
+    slots = (const pack_slot_t*)(map + sizeof(pack_header_t));
+    entries = (const pack_entry_t*)(slots + header->slot_count);
+
+    size_t pinned_size = (header->entry_count ? header->entry_count : 1) * sizeof(cached_response_t*);
+    pinned = Malloc(pinned_size);
+    memset(pinned, 0x00, pinned_size);
+
+    return 0;
+}
+
+/**
+ * @brief Looks the response of a path up.
+ * @param path The request path.
+ * @param gzip Whether the client accepts gzip, in which case the compressed variant is preferred if there is one.
+ * @return Returns the entry of the response, or NULL if the path is not packed or no pack is open.
+ * @note Time complexity: O(n) where n is the length of the path. Space complexity: O(1).
+ */
+const pack_entry_t* pack_lookup(const char* path, bool gzip) {
+    if (!map) return NULL;
+
+    size_t length = strlen(path);
+    uint32_t hash = pack_hash(path, length);
+    uint32_t mask = header->slot_count - 1;
+
+    for (uint32_t slot = hash & mask, probes = 0; probes <= mask; slot = (slot + 1) & mask, probes++) {
+        if (slots[slot].entry == 0) return NULL;
+        if (slots[slot].hash != hash || slots[slot].entry > header->entry_count) continue;
+
+        const pack_entry_t* entry = &entries[slots[slot].entry - 1];
+        if (!entry_valid(entry) || entry->path_length != length || memcmp(map + entry->path_offset, path, length) != 0) continue;
+
+        if (gzip && entry->variant && entry->variant <= header->entry_count && entry_valid(&entries[entry->variant - 1])) {
+            return &entries[entry->variant - 1];
+        }
+        return entry;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Gets the bytes of a response.
+ * @param entry The entry of the response.
+ * @return Returns the header of the response, followed by its body.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+const char* pack_response(const pack_entry_t* entry) {
+    return map + entry->response_offset;
+}
+
+/**
+ * @brief Pins a response as a cache entry, which Send and HTTP/2 streams send from memory.
+ * @details The entry points into the pack. It is built on the first request of the response and kept until the pack is closed.
+ * @param entry The entry of the response.
+ * @return Returns the pinned cache entry, released with response_cache_release.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+cached_response_t* pack_pin(const pack_entry_t* entry) {
+    size_t index = entry - entries;
+
+    if (!pinned[index]) {
+        cached_response_t* response = Malloc(sizeof(cached_response_t) + 1);
+        memset(response, 0x00, sizeof(cached_response_t) + 1);
+        response->bytes = (char*)pack_response(entry);
+        response->length = entry->header_length + entry->body_length;
+        // The pack's own reference, so the entry is never freed by a release.
+        response->refcount = 1;
+        pinned[index] = response;
+    }
+
+    pinned[index]->refcount++;
+    return pinned[index];
+}
+
+/**
+ * @brief Gets the file descriptor of the pack, to send large bodies from with sendfile.
+ * @return Returns the file descriptor, or -1 if no pack is open.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int pack_fd() {
+    return fd;
+}
+
+/**
+ * @brief Unmaps the pack.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of entries. Space complexity: O(1).
+ */
+void pack_close() {
+    if (pinned) {
+        for (uint32_t i = 0; i < header->entry_count; i++) {
+            free(pinned[i]);
+        }
+        free(pinned);
+        pinned = NULL;
+    }
+    if (map) {
+        munmap((void*)map, map_size);
+        map = NULL;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+/**
+ * @brief Checks that an entry lies within the pack.
+ * @param entry The entry.
+ * @return Returns true if its path and response are within the pack, false otherwise.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static bool entry_valid(const pack_entry_t* entry) {
+    return entry->path_offset <= map_size && entry->path_length <= map_size - entry->path_offset
+        && entry->response_offset <= map_size && entry->header_length <= map_size - entry->response_offset
+        && entry->body_length <= map_size - entry->response_offset - entry->header_length;
+}
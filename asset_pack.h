@@ -0,0 +1,72 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "response_cache.h"
+
+/// @file asset_pack.h
+/// @brief Contains the asset pack format shared by the packer and the server, and the server's function declarations.
+/// @details At build time pack_gen concatenates directories of static files into one pack: every file becomes a complete HTTP
+/// response, header and body, optionally with a gzip-compressed variant, and a hash index maps request paths to responses. The server
+/// maps the pack at startup and answers requests for packed paths straight from it, without opening or even looking up a file, and
+/// without any work per packed file at startup. Numbers are stored in the byte order of the machine that built the pack.
+///
+/// Layout: pack_header_t, slot_count slots, entry_count entries, then the paths and responses the entries point to.
+
+#define PACK_MAGIC "HTTPPAK1"
+
+typedef struct {
+    char magic[8];
+    uint32_t slot_count;    // Number of index slots, a power of two.
+    uint32_t entry_count;
+    uint64_t size;          // Size of the whole pack, to detect truncated packs.
+} pack_header_t;
+
+// An index slot, open addressing with linear probing.
+typedef struct {
+    uint32_t hash;
+    uint32_t entry;         // Index of the entry plus one, 0 for an empty slot.
+} pack_slot_t;
+
+// A packed response. Only plain responses are indexed, a compressed variant is reached from its plain response.
+typedef struct {
+    uint64_t path_offset;
+    uint64_t response_offset;
+    uint64_t body_length;
+    uint32_t path_length;
+    uint32_t header_length;  // The body follows the header.
+    uint32_t variant;        // Index of the gzip variant plus one, 0 if there is none.
+    uint32_t reserved;
+} pack_entry_t;
+
+/**
+ * @brief Hashes a request path.
+ * @details FNV-1a over the path, with the same finalizer as route_hash.
+ * @param path The path.
+ * @param length The length of the path.
+ * @return Returns the hash value.
+ * @note Time complexity: O(n) where n is the length of the path. Space complexity: O(1).
+ */
+static inline uint32_t pack_hash(const char* path, size_t length) {
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)path[i]) * 16777619u;
+    }
+
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+int pack_open(const char* path);
+const pack_entry_t* pack_lookup(const char* path, bool gzip);
+const char* pack_response(const pack_entry_t* entry);
+cached_response_t* pack_pin(const pack_entry_t* entry);
+int pack_fd();
+void pack_close();
+
+#endif
@@ -0,0 +1,164 @@
+/// @file latency.c
+/// @brief Loopback latency benchmark for the server.
+/// @details This program sends requests one at a time, each on its own connection as the server expects, and reports the latency
+/// percentiles of the round trips, the CPU time the benchmark spent per request and the requests per second it reached. The server
+/// is reached on a loopback port, or on a UNIX domain socket when given a path. Usage: latency <port or socket path> <requests> [path]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/resource.h>
+
+static uint64_t now_ns();
+static int compare_latencies(const void* a, const void* b);
+static uint64_t cpu_ns();
+static uint64_t round_trip(const struct sockaddr* address, socklen_t address_length, const char* request, size_t request_length);
+
+/**
+ * @brief Entry point of the benchmark.
+ * @param argc The number of command-line arguments.
+ * @param argv The port or socket path, the number of requests and optionally the path to request, /ping by default.
+ * @return Returns 0 on success, or 1 if the command line is invalid or a request fails.
+ * @note Time complexity: O(n log n) where n is the number of requests. Space complexity: O(n).
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s port|socket requests [path]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Anything that is not a port is the path of a UNIX domain socket.
+    struct sockaddr_in inet_address;
+    struct sockaddr_un unix_address;
+    const struct sockaddr* address;
+    socklen_t address_length;
+    if (strspn(argv[1], "0123456789") == strlen(argv[1])) {
+        memset(&inet_address, 0, sizeof(inet_address));
+        inet_address.sin_family = AF_INET;
+        inet_address.sin_port = htons(atoi(argv[1]));
+        inet_pton(AF_INET, "127.0.0.1", &inet_address.sin_addr);
+        address = (const struct sockaddr*)&inet_address;
+        address_length = sizeof(inet_address);
+    } else {
+        memset(&unix_address, 0, sizeof(unix_address));
+        unix_address.sun_family = AF_UNIX;
+        snprintf(unix_address.sun_path, sizeof(unix_address.sun_path), "%s", argv[1]);
+        address = (const struct sockaddr*)&unix_address;
+        address_length = sizeof(unix_address);
+    }
+
+    size_t count = strtoull(argv[2], NULL, 10);
+    char request[256];
+    int request_length = snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\n\r\n", argc > 3 ? argv[3] : "/ping");
+
+    uint64_t* latencies = malloc(count * sizeof(uint64_t));
+    if (!latencies) return EXIT_FAILURE;
+
+    // Warm up the server and the connection path.
+    for (size_t i = 0; i < count / 10; i++) {
+        if (round_trip(address, address_length, request, request_length) == 0) return EXIT_FAILURE;
+    }
+
+    uint64_t cpu_start = cpu_ns();
+    uint64_t start = now_ns();
+    for (size_t i = 0; i < count; i++) {
+        latencies[i] = round_trip(address, address_length, request, request_length);
+        if (latencies[i] == 0) return EXIT_FAILURE;
+    }
+    uint64_t elapsed = now_ns() - start;
+    uint64_t cpu = cpu_ns() - cpu_start;
+
+    qsort(latencies, count, sizeof(uint64_t), compare_latencies);
+
+    printf("requests: %zu\n", count);
+    printf("p50: %.1f us\n", latencies[count * 50 / 100] / 1000.0);
+    printf("p90: %.1f us\n", latencies[count * 90 / 100] / 1000.0);
+    printf("p99: %.1f us\n", latencies[count * 99 / 100] / 1000.0);
+    printf("p99.9: %.1f us\n", latencies[count * 999 / 1000] / 1000.0);
+    printf("max: %.1f us\n", latencies[count - 1] / 1000.0);
+    printf("client cpu: %.1f us/request\n", cpu / 1000.0 / count);
+    printf("throughput: %.0f requests/s\n", count / (elapsed / 1e9));
+
+    free(latencies);
+    return 0;
+}
+
+/**
+ * @brief Connects, sends a request and reads the response until the server closes the connection.
+ * @param address The address of the server.
+ * @param address_length The length of the address.
+ * @param request The request.
+ * @param request_length The length of the request.
+ * @return Returns the round trip time in nanoseconds, or 0 if the request failed.
+ * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(1).
+ */
+static uint64_t round_trip(const struct sockaddr* address, socklen_t address_length, const char* request, size_t request_length) {
+    char response[4096];
+    uint64_t start = now_ns();
+
+    int fd = socket(address->sa_family, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, address, address_length) < 0) {
+        perror("connect");
+        if (fd >= 0) close(fd);
+        return 0;
+    }
+    if (address->sa_family == AF_INET) {
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+
+    if (write(fd, request, request_length) != (ssize_t)request_length) {
+        perror("write");
+        close(fd);
+        return 0;
+    }
+    while (read(fd, response, sizeof(response)) > 0) {
+    }
+    close(fd);
+
+    uint64_t elapsed = now_ns() - start;
+    return elapsed ? elapsed : 1;
+}
+
+/**
+ * @brief Orders latencies for qsort.
+ * @param a The first latency.
+ * @param b The second latency.
+ * @return Returns a negative, zero or positive value as a is less than, equal to or greater than b.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int compare_latencies(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Returns the current time in nanoseconds.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+/**
+ * @brief Reads the CPU time the benchmark has used.
+ * @return Returns the user and system time in nanoseconds.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint64_t cpu_ns() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((uint64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000u
+        + ((uint64_t)usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000u;
+}
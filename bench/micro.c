@@ -0,0 +1,102 @@
+/// @file micro.c
+/// @brief Microbenchmarks of the server's hot paths, without a network in between.
+/// @details This program is linked against the server's objects and times a fixed number of iterations of one operation, printing the
+/// operations per second as a single number, as the perf category of runtests.sh expects. Usage: micro parser|sessions
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "http_parser.h"
+#include "client_session.h"
+
+// Iterations of each benchmark, enough for a run of a few hundred milliseconds at -O0.
+#define MICRO_PARSER_ITERATIONS 4000000
+#define MICRO_SESSION_ITERATIONS 4000000
+
+static uint64_t now_ns();
+static double bench_parser();
+static double bench_sessions();
+
+/**
+ * @brief Entry point of the microbenchmarks.
+ * @param argc The number of command-line arguments.
+ * @param argv The name of the benchmark to run.
+ * @return Returns 0 on success, or 1 if the command line is invalid or the benchmark fails.
+ * @note Time complexity: O(n) where n is the number of iterations. Space complexity: O(1).
+ */
+int main(int argc, char* argv[]) {
+    double rate;
+
+    if (argc == 2 && strcmp(argv[1], "parser") == 0) {
+        rate = bench_parser();
+    } else if (argc == 2 && strcmp(argv[1], "sessions") == 0) {
+        rate = bench_sessions();
+    } else {
+        fprintf(stderr, "usage: %s parser|sessions\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (rate <= 0) return EXIT_FAILURE;
+    printf("%.0f\n", rate);
+    return 0;
+}
+
+/**
+ * @brief Parses the request line, the headers and the content length of a typical write.
+ * @return Returns the requests parsed per second, or 0 if parsing failed.
+ * @note Time complexity: O(n) where n is the number of iterations. Space complexity: O(1).
+ */
+static double bench_parser() {
+    static const char request[] =
+        "POST /write/session-token HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "User-Agent: curl/7.88.1\r\n"
+        "Accept: */*\r\n"
+        "Content-Length: 16\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "\r\n"
+        "0123456789abcdef";
+    char method[16];
+    char path[256];
+    char headers[HMAX + 1];
+
+    uint64_t start = now_ns();
+    for (int i = 0; i < MICRO_PARSER_ITERATIONS; i++) {
+        if (parse_request(request, method, sizeof(method), path, sizeof(path)) < 0
+            || parse_headers(request, headers, sizeof(headers)) < 0
+            || extract_content_length(request) != 16) {
+            fprintf(stderr, "parser: the request did not parse\n");
+            return 0;
+        }
+    }
+    return MICRO_PARSER_ITERATIONS / ((now_ns() - start) / 1e9);
+}
+
+/**
+ * @brief Creates a session, gives it a request buffer and destroys it, as every connection does.
+ * @return Returns the sessions per second.
+ * @note Time complexity: O(n) where n is the number of iterations. Space complexity: O(1).
+ */
+static double bench_sessions() {
+    uint64_t start = now_ns();
+    for (int i = 0; i < MICRO_SESSION_ITERATIONS; i++) {
+        // Sessions without a socket, like the exchanges of HTTP/2 streams, so destroying one closes nothing.
+        client_session_t* session = session_create(-1, -1);
+        session_reserve_request(session, 1);
+        session_destroy(session);
+    }
+    return MICRO_SESSION_ITERATIONS / ((now_ns() - start) / 1e9);
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Returns the current time in nanoseconds.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
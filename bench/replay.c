@@ -0,0 +1,359 @@
+/// @file replay.c
+/// @brief Replays a captured request trace against the server.
+/// @details This program reads a trace written by the server's -t option and sends every request on its own connection, at the time it
+/// arrived at in the capture divided by the speed, whether or not earlier requests have been answered. Latency is measured from when a
+/// request was due, so requests held back by a slow server count the time they waited. Speed 0 sends the requests as fast as the
+/// connection limit allows. The server is reached on a loopback port, or on a UNIX domain socket when given a path.
+/// Usage: replay <port or socket path> <trace> [speed] [connections]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Connections open at once by default, within the server's listen backlog. Requests due while the limit is reached wait for a
+// connection to close.
+#define REPLAY_CONNECTIONS 8
+
+// A request of the trace.
+typedef struct {
+    uint64_t at_ns;   // When the request is due, relative to the first request at full speed.
+    char* data;
+    size_t length;
+} replay_request_t;
+
+// A connection sending a request and reading its response.
+typedef struct {
+    int fd;
+    const replay_request_t* request;
+    size_t sent;
+    uint64_t due_ns;
+    char head[16];    // The start of the response, which holds the status code.
+    size_t head_length;
+} replay_connection_t;
+
+static uint64_t now_ns();
+static int compare_latencies(const void* a, const void* b);
+static size_t load_trace(const char* path, replay_request_t** requests);
+static size_t unescape(const char* in, char* out);
+static int open_connection(int epfd, replay_connection_t* connection, const struct sockaddr* address, socklen_t address_length);
+static int advance(int epfd, replay_connection_t* connection);
+
+/**
+ * @brief Entry point of the replay.
+ * @param argc The number of command-line arguments.
+ * @param argv The port or socket path, the trace, optionally the speed, 1 by default, and the most connections open at once.
+ * @return Returns 0 on success, or 1 if the command line or the trace is invalid.
+ * @note Time complexity: O(n log n) where n is the number of requests. Space complexity: O(n).
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s port|socket trace [speed] [connections]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // Anything that is not a port is the path of a UNIX domain socket.
+    struct sockaddr_in inet_address;
+    struct sockaddr_un unix_address;
+    const struct sockaddr* address;
+    socklen_t address_length;
+    if (strspn(argv[1], "0123456789") == strlen(argv[1])) {
+        memset(&inet_address, 0, sizeof(inet_address));
+        inet_address.sin_family = AF_INET;
+        inet_address.sin_port = htons(atoi(argv[1]));
+        inet_pton(AF_INET, "127.0.0.1", &inet_address.sin_addr);
+        address = (const struct sockaddr*)&inet_address;
+        address_length = sizeof(inet_address);
+    } else {
+        memset(&unix_address, 0, sizeof(unix_address));
+        unix_address.sun_family = AF_UNIX;
+        snprintf(unix_address.sun_path, sizeof(unix_address.sun_path), "%s", argv[1]);
+        address = (const struct sockaddr*)&unix_address;
+        address_length = sizeof(unix_address);
+    }
+
+    replay_request_t* requests;
+    size_t count = load_trace(argv[2], &requests);
+    if (count == 0) {
+        fprintf(stderr, "%s: no requests in the trace\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+    double speed = argc > 3 ? atof(argv[3]) : 1.0;
+    size_t limit = argc > 4 ? strtoull(argv[4], NULL, 10) : REPLAY_CONNECTIONS;
+    if (limit == 0) limit = REPLAY_CONNECTIONS;
+
+    uint64_t* latencies = malloc(count * sizeof(uint64_t));
+    replay_connection_t* connections = calloc(limit, sizeof(replay_connection_t));
+    replay_connection_t** idle = malloc(limit * sizeof(replay_connection_t*));
+    int epfd = epoll_create1(0);
+    if (!latencies || !connections || !idle || epfd < 0) return EXIT_FAILURE;
+
+    for (size_t i = 0; i < limit; i++) {
+        idle[i] = &connections[limit - 1 - i];
+    }
+    size_t idle_count = limit;
+
+    size_t next = 0, answered = 0, failed = 0;
+    size_t classes[6] = { 0 };
+    struct epoll_event events[64];
+    uint64_t start = now_ns();
+
+    while (answered + failed < count) {
+        uint64_t now = now_ns();
+
+        // Open the connections of every request that is due.
+        while (next < count && idle_count > 0) {
+            uint64_t due = speed > 0 ? start + (uint64_t)(requests[next].at_ns / speed) : now;
+            if (due > now) break;
+
+            replay_connection_t* connection = idle[--idle_count];
+            connection->request = &requests[next++];
+            connection->due_ns = due;
+            if (open_connection(epfd, connection, address, address_length) < 0) {
+                failed++;
+                idle[idle_count++] = connection;
+            }
+        }
+
+        // Sleep until the next request is due, unless responses arrive first.
+        struct timespec timeout = { 0, 0 };
+        struct timespec* wait = NULL;
+        if (next < count && idle_count > 0 && speed > 0) {
+            uint64_t due = start + (uint64_t)(requests[next].at_ns / speed);
+            uint64_t delay = due > now ? due - now : 0;
+            timeout.tv_sec = delay / 1000000000u;
+            timeout.tv_nsec = delay % 1000000000u;
+            wait = &timeout;
+        } else if (next < count && idle_count > 0) {
+            wait = &timeout;
+        }
+
+        int ready = epoll_pwait2(epfd, events, 64, wait, NULL);
+        for (int i = 0; i < ready; i++) {
+            replay_connection_t* connection = events[i].data.ptr;
+            int status = advance(epfd, connection);
+            if (status == 0) continue;
+
+            if (status < 0) {
+                failed++;
+            } else {
+                latencies[answered++] = now_ns() - connection->due_ns;
+                classes[status / 100 < 6 ? status / 100 : 0]++;
+            }
+            close(connection->fd);
+            idle[idle_count++] = connection;
+        }
+    }
+    uint64_t elapsed = now_ns() - start;
+
+    printf("requests: %zu\n", count);
+    printf("answered: %zu\n", answered);
+    printf("2xx: %zu\n", classes[2]);
+    printf("4xx: %zu\n", classes[4]);
+    printf("5xx: %zu\n", classes[5]);
+    printf("failed: %zu\n", failed);
+    if (answered > 0) {
+        qsort(latencies, answered, sizeof(uint64_t), compare_latencies);
+        printf("throughput: %.0f requests/s\n", answered / (elapsed / 1e9));
+        printf("p50: %.1f us\n", latencies[answered * 50 / 100] / 1000.0);
+        printf("p90: %.1f us\n", latencies[answered * 90 / 100] / 1000.0);
+        printf("p99: %.1f us\n", latencies[answered * 99 / 100] / 1000.0);
+        printf("p99.9: %.1f us\n", latencies[answered * 999 / 1000] / 1000.0);
+        printf("max: %.1f us\n", latencies[answered - 1] / 1000.0);
+    }
+
+    return failed ? EXIT_FAILURE : 0;
+}
+
+/**
+ * @brief Loads the requests of a trace.
+ * @details Lines that hold no request are skipped. The due times are made relative to the first request.
+ * @param path The path of the trace.
+ * @param requests Set to the array of requests.
+ * @return Returns the number of requests, or 0 if the trace could not be read.
+ * @note Time complexity: O(n) where n is the size of the trace. Space complexity: O(n).
+ */
+static size_t load_trace(const char* path, replay_request_t** requests) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return 0;
+    }
+
+    size_t count = 0, capacity = 0;
+    replay_request_t* loaded = NULL;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    uint64_t first = 0;
+
+    while (getline(&line, &line_capacity, file) > 0) {
+        char* at = strstr(line, "\"at_us\":");
+        char* request = strstr(line, "\"request\":\"");
+        if (!at || !request) continue;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            loaded = realloc(loaded, capacity * sizeof(replay_request_t));
+            if (!loaded) exit(EXIT_FAILURE);
+        }
+
+        uint64_t at_us = strtoull(at + strlen("\"at_us\":"), NULL, 10);
+        if (count == 0) first = at_us;
+
+        request += strlen("\"request\":\"");
+        replay_request_t* loaded_request = &loaded[count++];
+        loaded_request->at_ns = (at_us - first) * 1000;
+        loaded_request->data = malloc(strlen(request) + 1);
+        if (!loaded_request->data) exit(EXIT_FAILURE);
+        loaded_request->length = unescape(request, loaded_request->data);
+    }
+
+    free(line);
+    fclose(file);
+    *requests = loaded;
+    return count;
+}
+
+/**
+ * @brief Decodes a JSON string as written by the capture, up to its closing quote.
+ * @details Every \u00XX escape stands for a single byte.
+ * @param in The string, after its opening quote.
+ * @param out A buffer at least as long as the string.
+ * @return Returns the number of decoded bytes.
+ * @note Time complexity: O(n) where n is the length of the string. Space complexity: O(1).
+ */
+static size_t unescape(const char* in, char* out) {
+    size_t length = 0;
+
+    for (; *in && *in != '"'; in++) {
+        if (*in != '\\') {
+            out[length++] = *in;
+            continue;
+        }
+
+        in++;
+        if (*in == 'r') {
+            out[length++] = '\r';
+        } else if (*in == 'n') {
+            out[length++] = '\n';
+        } else if (*in == 'u' && in[1] && in[2] && in[3] && in[4]) {
+            char hex[3] = { in[3], in[4], '\0' };
+            out[length++] = (char)strtoul(hex, NULL, 16);
+            in += 4;
+        } else if (*in) {
+            out[length++] = *in;
+        } else {
+            break;
+        }
+    }
+
+    return length;
+}
+
+/**
+ * @brief Opens a non-blocking connection for a request and waits for it to become writable.
+ * @param epfd The epoll file descriptor.
+ * @param connection The connection, holding its request.
+ * @param address The address of the server.
+ * @param address_length The length of the address.
+ * @return Returns 0 on success, or -1 if the connection could not be opened.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int open_connection(int epfd, replay_connection_t* connection, const struct sockaddr* address, socklen_t address_length) {
+    connection->fd = socket(address->sa_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (connection->fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    if (address->sa_family == AF_INET) {
+        int nodelay = 1;
+        setsockopt(connection->fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+    connection->sent = 0;
+    connection->head_length = 0;
+
+    if (connect(connection->fd, address, address_length) < 0 && errno != EINPROGRESS && errno != EAGAIN) {
+        perror("connect");
+        close(connection->fd);
+        return -1;
+    }
+
+    struct epoll_event event = { .events = EPOLLOUT, .data.ptr = connection };
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, connection->fd, &event) < 0) {
+        close(connection->fd);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Sends the request of a ready connection, or reads its response until the server closes the connection.
+ * @param epfd The epoll file descriptor.
+ * @param connection The connection.
+ * @return Returns 0 while the exchange goes on, the status code once the server has closed the connection, or -1 if it failed.
+ * @note Time complexity: O(n) where n is the size of the request or the response. Space complexity: O(1).
+ */
+static int advance(int epfd, replay_connection_t* connection) {
+    const replay_request_t* request = connection->request;
+
+    if (connection->sent < request->length) {
+        ssize_t sent = send(connection->fd, request->data + connection->sent, request->length - connection->sent, MSG_NOSIGNAL);
+        if (sent < 0) return errno == EAGAIN ? 0 : -1;
+        connection->sent += sent;
+
+        if (connection->sent == request->length) {
+            struct epoll_event event = { .events = EPOLLIN, .data.ptr = connection };
+            epoll_ctl(epfd, EPOLL_CTL_MOD, connection->fd, &event);
+        }
+        return 0;
+    }
+
+    char response[4096];
+    ssize_t received;
+    while ((received = recv(connection->fd, response, sizeof(response), 0)) > 0) {
+        size_t head = sizeof(connection->head) - 1 - connection->head_length;
+        size_t copied = (size_t)received < head ? (size_t)received : head;
+        memcpy(connection->head + connection->head_length, response, copied);
+        connection->head_length += copied;
+    }
+    if (received < 0) return errno == EAGAIN ? 0 : -1;
+
+    // "HTTP/1.1 200"
+    connection->head[connection->head_length] = '\0';
+    if (connection->head_length < 12 || strncmp(connection->head, "HTTP/", 5) != 0) return -1;
+    int status = atoi(connection->head + 9);
+    return status > 0 ? status : -1;
+}
+
+/**
+ * @brief Orders latencies for qsort.
+ * @param a The first latency.
+ * @param b The second latency.
+ * @return Returns a negative, zero or positive value as a is less than, equal to or greater than b.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int compare_latencies(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Returns the current time in nanoseconds.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
@@ -0,0 +1,30 @@
+#!/bin/bash
+
+# Compares the request latency of the default blocking event loop with low-latency mode on loopback.
+# usage: bench/run.sh [requests] [spin us] [path]
+# Run from the repository root. Spinning only pays off when the server has a core to itself: pin the server and the benchmark to
+# separate idle cores, e.g. with taskset. On a single core the spin competes with the benchmark and makes latency worse.
+
+REQUESTS=${1:-20000}
+SPIN=${2:-50}
+URL_PATH=${3:-/ping}
+PORT=$(( ($(cat port.txt 2>/dev/null || echo 12686) + 100) ))
+
+make -s all bench/latency || exit 1
+
+function run
+{
+    ./main "$@" $PORT &
+    SERVER=$!
+    until ./bench/latency $PORT 1 $URL_PATH >/dev/null 2>&1; do
+        sleep 0.1
+    done
+    ./bench/latency $PORT $REQUESTS $URL_PATH
+    kill -9 $SERVER
+    wait $SERVER 2>/dev/null || true
+}
+
+printf "== blocking epoll_wait\n"
+run
+printf "\n== low-latency mode, spinning up to $SPIN us\n"
+run -b $SPIN
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+# Compares the socket option profiles on small responses and on 10 MB downloads.
+# usage: bench/sockets.sh [requests] [downloads] [profiles...]
+# Run from the repository root. Each profile is served by a fresh server, "default" leaves the kernel defaults in place.
+
+REQUESTS=${1:-20000}
+DOWNLOADS=${2:-200}
+shift 2 2>/dev/null
+PROFILES=${@:-default latency throughput}
+PORT=$(( ($(cat port.txt 2>/dev/null || echo 12686) + 100) ))
+FILE=bench/sockets.bin
+
+make -s all bench/latency || exit 1
+head -c 10485760 /dev/urandom > $FILE
+
+for PROFILE in $PROFILES; do
+    if [[ $PROFILE == default ]]; then
+        ./main $PORT &
+    else
+        ./main -P $PROFILE $PORT &
+    fi
+    SERVER=$!
+    until ./bench/latency $PORT 1 >/dev/null 2>&1; do
+        sleep 0.1
+    done
+
+    printf "== $PROFILE, /ping\n"
+    ./bench/latency $PORT $REQUESTS
+    printf "\n== $PROFILE, 10 MB file\n"
+    ./bench/latency $PORT $DOWNLOADS /$FILE | awk '{ print } /^throughput:/ { printf "bandwidth: %.0f MB/s\n", $2 * 10 }'
+    printf "\n"
+
+    kill -9 $SERVER
+    wait $SERVER 2>/dev/null || true
+done
+
+rm -f $FILE
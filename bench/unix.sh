@@ -0,0 +1,42 @@
+#!/bin/bash
+
+# Compares the request latency and CPU time of loopback TCP with the UNIX domain socket listener.
+# usage: bench/unix.sh [requests] [path]
+# Run from the repository root. Both transports are served by the same server, so the only difference is the socket path.
+
+REQUESTS=${1:-20000}
+URL_PATH=${2:-/ping}
+PORT=$(( ($(cat port.txt 2>/dev/null || echo 12686) + 100) ))
+SOCKET=bench/unix.sock
+
+make -s all bench/latency || exit 1
+
+# CPU time the server has used so far, in clock ticks.
+function server_ticks
+{
+    awk '{ print $14 + $15 }' /proc/$SERVER/stat
+}
+
+function run
+{
+    until ./bench/latency $1 1 $URL_PATH >/dev/null 2>&1; do
+        sleep 0.1
+    done
+    BEFORE=$(server_ticks)
+    ./bench/latency $1 $REQUESTS $URL_PATH
+    AFTER=$(server_ticks)
+    awk -v ticks=$((AFTER - BEFORE)) -v hz=$(getconf CLK_TCK) -v requests=$REQUESTS \
+        'BEGIN { printf "server cpu: %.1f us/request\n", ticks * 1000000 / hz / requests }'
+}
+
+./main -u $SOCKET $PORT &
+SERVER=$!
+
+printf "== loopback TCP\n"
+run $PORT
+printf "\n== UNIX domain socket\n"
+run $SOCKET
+
+kill -9 $SERVER
+wait $SERVER 2>/dev/null || true
+rm -f $SOCKET
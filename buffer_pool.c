@@ -0,0 +1,127 @@
+/// @file buffer_pool.c
+/// @brief Contains a tiered pool of reusable buffers.
+/// @details This file includes functions to take buffers from and return buffers to a pool of free lists,
+/// one per size class, so that session buffers can be recycled between requests instead of being reallocated.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer_pool.h"
+#include "network_utils.h"
+
+#define POOL_CLASSES 3
+
+// A free buffer stores the link to the next free buffer of its class in its first bytes.
+typedef struct pool_buffer {
+    struct pool_buffer* next;
+} pool_buffer_t;
+
+static const size_t class_sizes[POOL_CLASSES] = {512, 4096, 65536};
+
+// Maximum number of idle buffers kept per class, anything beyond is handed back to malloc.
+static const size_t class_limits[POOL_CLASSES] = {1024, 256, 16};
+
+static pool_buffer_t* free_lists[POOL_CLASSES];
+static size_t free_counts[POOL_CLASSES];
+
+/**
+ * @brief Finds the size class of a buffer size.
+ * @param size The requested buffer size.
+ * @return Returns the index of the smallest class that fits the size, or -1 if the size is larger than every class.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int size_class(size_t size) {
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        if (size <= class_sizes[i]) return i;
+    }
+    return -1;
+}
+
+/**
+ * @brief Takes a buffer from the pool.
+ * @details This function returns an idle buffer of the smallest size class that fits the requested size, allocating a new one if the
+ * class has none. Sizes above the largest class are rounded up to a multiple of it and allocated directly.
+ * @param size The minimum size of the buffer.
+ * @param capacity Output for the actual size of the returned buffer, which must be passed back to buffer_release.
+ * @return Returns a pointer to the buffer.
+ * @note Time complexity: O(1). Space complexity: O(n) where n is the buffer size.
+ */
+char* buffer_acquire(size_t size, size_t* capacity) {
+    int index = size_class(size);
+
+    if (index < 0) {
+        size_t largest = class_sizes[POOL_CLASSES - 1];
+        *capacity = (size + largest - 1) / largest * largest;
+        return Malloc(*capacity);
+    }
+
+    *capacity = class_sizes[index];
+
+    pool_buffer_t* buffer = free_lists[index];
+    if (!buffer) return Malloc(*capacity);
+
+    free_lists[index] = buffer->next;
+    free_counts[index]--;
+    return (char*)buffer;
+}
+
+/**
+ * @brief Moves the contents of a buffer into a larger one.
+ * @details This function takes a buffer that fits the requested size from the pool, copies the used part of the old buffer into it and
+ * returns the old buffer to the pool.
+ * @param buffer The buffer to grow, or NULL.
+ * @param length The number of bytes in use in the buffer.
+ * @param size The minimum size of the new buffer.
+ * @param capacity Pointer to the capacity of the buffer, updated to the capacity of the new buffer.
+ * @return Returns a pointer to the new buffer.
+ * @note Time complexity: O(n) where n is the number of bytes in use. Space complexity: O(n) where n is the buffer size.
+ */
+char* buffer_grow(char* buffer, size_t length, size_t size, size_t* capacity) {
+    size_t new_capacity;
+    char* grown = buffer_acquire(size, &new_capacity);
+
+    if (buffer) {
+        memcpy(grown, buffer, length);
+        buffer_release(buffer, *capacity);
+    }
+
+    *capacity = new_capacity;
+    return grown;
+}
+
+/**
+ * @brief Returns a buffer to the pool.
+ * @details This function puts the buffer on the free list of its size class. Buffers larger than every class, or beyond the idle limit
+ * of their class, are freed.
+ * @param buffer The buffer to return, or NULL.
+ * @param capacity The capacity reported when the buffer was acquired.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void buffer_release(char* buffer, size_t capacity) {
+    if (!buffer) return;
+
+    int index = size_class(capacity);
+    if (index < 0 || class_sizes[index] != capacity || free_counts[index] >= class_limits[index]) {
+        free(buffer);
+        return;
+    }
+
+    pool_buffer_t* node = (pool_buffer_t*)buffer;
+    node->next = free_lists[index];
+    free_lists[index] = node;
+    free_counts[index]++;
+}
+
+/**
+ * @brief Gets the memory held by idle pooled buffers.
+ * @return Returns the total size of the buffers sitting on the free lists.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t buffer_pool_get_idle_memory() {
+    size_t total = 0;
+    for (int i = 0; i < POOL_CLASSES; i++) {
+        total += free_counts[i] * class_sizes[i];
+    }
+    return total;
+}
@@ -0,0 +1,11 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <stddef.h>
+
+char* buffer_acquire(size_t size, size_t* capacity);
+char* buffer_grow(char* buffer, size_t length, size_t size, size_t* capacity);
+void buffer_release(char* buffer, size_t capacity);
+size_t buffer_pool_get_idle_memory();
+
+#endif
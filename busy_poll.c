@@ -0,0 +1,78 @@
+/// @file busy_poll.c
+/// @brief Contains functions for the low-latency event wait.
+/// @details This file includes the adaptive spin in front of the blocking epoll_wait and the socket option that lets the kernel busy
+/// poll the device queue of a client socket. Without a configured spin, waiting is a plain blocking epoll_wait.
+
+#include <stdint.h>
+#include <sys/socket.h>
+
+#include "busy_poll.h"
+#include "overload.h"
+
+// The spin never shrinks below this, so that it can grow back.
+#define BUSY_POLL_MIN_US 1
+
+static unsigned spin_limit_us = 0;
+static unsigned spin_budget_us = 0;
+
+/**
+ * @brief Enables low-latency mode.
+ * @param spin_us The longest time in microseconds to poll for events before blocking, or 0 to always block.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void busy_poll_configure(unsigned spin_us) {
+    spin_limit_us = spin_us;
+    spin_budget_us = spin_us;
+}
+
+/**
+ * @brief Waits for events, spinning first in low-latency mode.
+ * @details A spin that finds events keeps the full budget. A spin that finds nothing halves it, so an idle server soon stops spinning.
+ * When a blocking wait returns within the full budget, events are arriving close enough together for spinning to catch them, and the
+ * budget is restored.
+ * @param epfd The epoll file descriptor.
+ * @param events The array receiving the events.
+ * @param max_events The size of the array.
+ * @param timeout The timeout of the blocking wait in milliseconds, or -1 to wait indefinitely.
+ * @return Returns the number of events, 0 on timeout, or -1 on error, like epoll_wait.
+ * @note Time complexity: O(1) plus the spin. Space complexity: O(1).
+ */
+int busy_poll_wait(int epfd, struct epoll_event* events, int max_events, int timeout) {
+    if (!spin_limit_us) {
+        return epoll_wait(epfd, events, max_events, timeout);
+    }
+
+    uint64_t start = overload_now_us();
+    do {
+        int num_events = epoll_wait(epfd, events, max_events, 0);
+        if (num_events != 0) {
+            spin_budget_us = spin_limit_us;
+            return num_events;
+        }
+    } while (overload_now_us() - start < spin_budget_us);
+
+    spin_budget_us = spin_budget_us / 2 > BUSY_POLL_MIN_US ? spin_budget_us / 2 : BUSY_POLL_MIN_US;
+
+    uint64_t blocked = overload_now_us();
+    int num_events = epoll_wait(epfd, events, max_events, timeout);
+    if (num_events > 0 && overload_now_us() - blocked < spin_limit_us) {
+        spin_budget_us = spin_limit_us;
+    }
+    return num_events;
+}
+
+/**
+ * @brief Lets the kernel busy poll the device queue when reading from a socket in low-latency mode.
+ * @details Raising SO_BUSY_POLL above net.core.busy_read needs CAP_NET_ADMIN, and devices without NAPI polling, like loopback,
+ * ignore it, so failing to set it is not an error.
+ * @param fd The client socket.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void busy_poll_socket(int fd) {
+    if (!spin_limit_us) return;
+
+    int busy_poll_us = spin_limit_us;
+    setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_us, sizeof(busy_poll_us));
+}
@@ -0,0 +1,16 @@
+#ifndef BUSY_POLL_H
+#define BUSY_POLL_H
+
+#include <sys/epoll.h>
+
+/// @file busy_poll.h
+/// @brief Contains function declarations for the low-latency event wait.
+/// @details In low-latency mode the event loop polls epoll without blocking for a short while before it goes to sleep, so a request
+/// arriving shortly after the previous one is picked up without a wakeup. The spin adapts to the load: it shrinks while it finds
+/// nothing and grows back when events arrive close together.
+
+void busy_poll_configure(unsigned spin_us);
+int busy_poll_wait(int epfd, struct epoll_event* events, int max_events, int timeout);
+void busy_poll_socket(int fd);
+
+#endif
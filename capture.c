@@ -0,0 +1,160 @@
+/// @file capture.c
+/// @brief Contains functions for capturing request traces.
+/// @details This file includes functions to copy sampled requests into a log ring, whose background thread writes them to the
+/// trace. Every line holds the time the request arrived at, in microseconds since the capture
+/// started, and the request as a JSON string. Bytes outside printable ASCII are written as \u00XX escapes, one per byte.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+
+#include "capture.h"
+#include "http_parser.h"
+#include "log_ring.h"
+
+// Number of requests the ring holds, a power of two.
+#define CAPTURE_RING_SIZE 256
+
+// The longest line a request formats to, with every byte escaped.
+#define CAPTURE_LINE_MAX (CAPTURE_REQUEST_MAX * 6 + 64)
+
+// Size of the buffer the writer formats lines into before writing them out.
+#define CAPTURE_FLUSH_SIZE (4 * CAPTURE_LINE_MAX)
+
+// A captured request.
+typedef struct {
+    uint64_t at_us;     // When the request arrived, in microseconds since the capture started.
+    size_t length;
+    char request[CAPTURE_REQUEST_MAX];
+} capture_record_t;
+
+static size_t format_record(const void* data, char* line);
+
+static capture_record_t records[CAPTURE_RING_SIZE];
+static char lines[CAPTURE_FLUSH_SIZE];
+
+static log_ring_t ring = {
+    .records = records,
+    .record_size = sizeof(capture_record_t),
+    .slot_count = CAPTURE_RING_SIZE,
+    .out = lines,
+    .out_size = CAPTURE_FLUSH_SIZE,
+    .line_max = CAPTURE_LINE_MAX,
+    .format = format_record,
+};
+
+static int capture_fd = -1;
+static struct timespec started;
+static unsigned sample_every = 1;
+static unsigned sample_count = 0;
+
+/**
+ * @brief Opens the trace and starts its writer thread.
+ * @param path The path of the trace. It is truncated if it exists.
+ * @param sample Captures one in this many requests, 0 and 1 capture every request.
+ * @return Returns 0 on success, or -1 if the trace could not be opened.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int capture_open(const char* path, unsigned sample) {
+    capture_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (capture_fd < 0) {
+        perror("Opening capture trace failed");
+        return -1;
+    }
+
+    sample_every = sample ? sample : 1;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+
+    if (log_ring_start(&ring, capture_fd) != 0) {
+        perror("Starting capture writer failed");
+        close(capture_fd);
+        capture_fd = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Captures a request if it is sampled.
+ * @details Requests with a chunked body are not captured, since the rest of their body arrives after the request is served, and
+ * neither are requests larger than CAPTURE_REQUEST_MAX. If the ring is full, the request is dropped and counted.
+ * @param request The request, null-terminated.
+ * @param length The length of the request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of a sampled request, O(1) otherwise. Space complexity: O(1).
+ */
+void capture_request(const char* request, size_t length) {
+    if (capture_fd < 0 || ++sample_count < sample_every) return;
+    sample_count = 0;
+
+    if (length > CAPTURE_REQUEST_MAX || is_chunked_transfer(request)) return;
+
+    capture_record_t* record = log_ring_claim(&ring);
+    if (!record) return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    record->at_us = (now.tv_sec - started.tv_sec) * 1000000 + (now.tv_nsec - started.tv_nsec) / 1000;
+    record->length = length;
+    memcpy(record->request, request, length);
+    log_ring_push(&ring);
+}
+
+/**
+ * @brief Gets the number of sampled requests dropped because the ring was full.
+ * @return Returns the number of dropped requests.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t capture_get_drops() {
+    return ring.drops;
+}
+
+/**
+ * @brief Closes the trace.
+ * @details This function lets the writer drain the ring, waits for it and closes the trace.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the pending requests. Space complexity: O(1).
+ */
+void capture_close() {
+    if (capture_fd < 0) return;
+
+    log_ring_stop(&ring);
+
+    close(capture_fd);
+    capture_fd = -1;
+}
+
+/**
+ * @brief Formats a captured request as a JSON line.
+ * @param data The captured request, a capture_record_t.
+ * @param line A buffer of at least CAPTURE_LINE_MAX bytes.
+ * @return Returns the length of the line, including the newline.
+ * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(1).
+ */
+static size_t format_record(const void* data, char* line) {
+    const capture_record_t* record = data;
+    char* out = line + sprintf(line, "{\"at_us\":%llu,\"request\":\"", (unsigned long long)record->at_us);
+
+    for (size_t i = 0; i < record->length; i++) {
+        unsigned char c = record->request[i];
+        if (c == '"' || c == '\\') {
+            *out++ = '\\';
+            *out++ = c;
+        } else if (c == '\r') {
+            out += sprintf(out, "\\r");
+        } else if (c == '\n') {
+            out += sprintf(out, "\\n");
+        } else if (c < 0x20 || c >= 0x7f) {
+            out += sprintf(out, "\\u%04x", c);
+        } else {
+            *out++ = c;
+        }
+    }
+
+    return out - line + sprintf(out, "\"}\n");
+}
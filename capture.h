@@ -0,0 +1,20 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stddef.h>
+
+/// @file capture.h
+/// @brief Contains function declarations for capturing request traces.
+/// @details A sample of the served requests is copied, with the time it arrived at, into a lock-free ring, and a background thread
+/// writes the ring out as JSON lines. bench/replay sends such a trace to a server at its original pace or faster, so changes can be
+/// measured against a real request mix. When the ring is full, requests are dropped and counted rather than waited for.
+
+// Requests larger than this are not captured.
+#define CAPTURE_REQUEST_MAX 4096
+
+int capture_open(const char* path, unsigned sample);
+void capture_request(const char* request, size_t length);
+size_t capture_get_drops();
+void capture_close();
+
+#endif
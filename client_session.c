@@ -0,0 +1,225 @@
+/// @file client_session.c
+/// @brief Contains functions for managing client sessions.
+/// @details This file includes functions to create and destroy client sessions and to manage their pooled request, header and body buffers.
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include "buffer_pool.h"
+#include "network_utils.h"
+#include "client_session.h"
+#include "tls.h"
+#include "probes.h"
+
+// Maximum number of destroyed sessions kept for reuse.
+#define SESSION_CACHE_MAX 1024
+
+// Destroyed sessions are kept on a free list, linked through their first bytes.
+typedef struct cached_session {
+    struct cached_session* next;
+} cached_session_t;
+
+static cached_session_t* session_cache = NULL;
+static size_t session_cache_count = 0;
+static size_t active_sessions = 0;
+
+/**
+ * @brief Creates a client session.
+ * @details This function takes a session from the session cache, or allocates one, for an accepted connection.
+ * No buffers are attached until the client sends data, except the scratch arena a recycled session keeps.
+ * @param fd The file descriptor of the client connection, or -1 for the exchange of an HTTP/2 stream.
+ * @param epfd The epoll file descriptor monitoring the connection.
+ * @return Returns a pointer to the new session.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+client_session_t* session_create(int fd, int epfd) {
+    client_session_t* client_info;
+    arena_t scratch;
+
+    if (session_cache) {
+        client_info = (client_session_t*)session_cache;
+        session_cache = session_cache->next;
+        session_cache_count--;
+        scratch = client_info->scratch;
+    } else {
+        client_info = Malloc(sizeof(client_session_t));
+        memset(&scratch, 0x00, sizeof(scratch));
+    }
+
+    memset(client_info, 0x00, sizeof(client_session_t));
+    client_info->scratch = scratch;
+
+    client_info->fd = fd;
+    client_info->epfd = epfd;
+    active_sessions++;
+
+    return client_info;
+}
+
+/**
+ * @brief Destroys a client session.
+ * @details This function closes the client connection, returns the session buffers to the pool and keeps the session for reuse. A kept
+ * session keeps the block of its scratch arena too, rewound in O(1), so the next connection's scratch memory needs no trip to the pool,
+ * unless a large request grew the arena beyond a single block, which then goes back.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void session_destroy(client_session_t* client_info) {
+    PROBE_RESPONSE_FINISH(client_info);
+    TRACE_FINISH(client_info);
+    access_log_finish(&client_info->log_record);
+    if (client_info->client_limit) {
+        rate_limit_release(client_info->client_limit);
+    }
+#ifdef HTTP_TLS
+    tls_end(client_info);
+#endif
+    // The exchange of an HTTP/2 stream has no socket of its own.
+    if (client_info->fd >= 0) {
+        close(client_info->fd);
+    }
+    session_release_buffers(client_info);
+    active_sessions--;
+
+    if (session_cache_count >= SESSION_CACHE_MAX) {
+        arena_release(&client_info->scratch);
+        free(client_info);
+        return;
+    }
+    arena_reset(&client_info->scratch);
+
+    cached_session_t* cached = (cached_session_t*)client_info;
+    cached->next = session_cache;
+    session_cache = cached;
+    session_cache_count++;
+}
+
+/**
+ * @brief Ensures the request buffer can hold the given number of bytes.
+ * @details This function grows the request buffer to a pool buffer of at least the given size, keeping the bytes received so far.
+ * @param client_info Pointer to the client session information.
+ * @param size The minimum size of the request buffer.
+ * @return Returns a pointer to the request buffer.
+ * @note Time complexity: O(n) where n is the request size. Space complexity: O(n).
+ */
+char* session_reserve_request(client_session_t* client_info, size_t size) {
+    if (size > client_info->request_capacity) {
+        size_t length = client_info->request ? client_info->request_size : 0;
+        client_info->request = buffer_grow(client_info->request, length, size, &client_info->request_capacity);
+    }
+    return client_info->request;
+}
+
+/**
+ * @brief Ensures the body buffer can hold the given number of bytes.
+ * @details This function replaces the body buffer with a pool buffer of at least the given size. The previous contents are not kept.
+ * @param client_info Pointer to the client session information.
+ * @param size The minimum size of the body buffer.
+ * @return Returns a pointer to the body buffer.
+ * @note Time complexity: O(1). Space complexity: O(n) where n is the size.
+ */
+char* session_reserve_body(client_session_t* client_info, size_t size) {
+    if (size > client_info->body_capacity) {
+        buffer_release(client_info->body, client_info->body_capacity);
+        client_info->body = buffer_acquire(size, &client_info->body_capacity);
+    }
+    return client_info->body;
+}
+
+/**
+ * @brief Allocates scratch memory for the current request.
+ * @details This function allocates from the session arena. The memory stays valid until the response has been sent,
+ * after which the whole arena is discarded at once, so callers never free it.
+ * @param client_info Pointer to the client session information.
+ * @param size The number of bytes to allocate.
+ * @return Returns a pointer to the scratch memory.
+ * @note Time complexity: O(1). Space complexity: O(n) where n is the size.
+ */
+void* session_scratch(client_session_t* client_info, size_t size) {
+    return arena_alloc(&client_info->scratch, size);
+}
+
+/**
+ * @brief Formats the response header.
+ * @details This function formats the response header into the header buffer, growing the buffer if the header does not fit, and sets HSIZE.
+ * @param client_info Pointer to the client session information.
+ * @param format The printf style format of the header.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the header length. Space complexity: O(n).
+ */
+void session_set_header(client_session_t* client_info, const char* format, ...) {
+    va_list args;
+
+    if (!client_info->header) {
+        client_info->header = buffer_acquire(1, &client_info->header_capacity);
+    }
+
+    va_start(args, format);
+    int length = vsnprintf(client_info->header, client_info->header_capacity, format, args);
+    va_end(args);
+
+    if (length >= 0 && (size_t)length >= client_info->header_capacity) {
+        buffer_release(client_info->header, client_info->header_capacity);
+        client_info->header = buffer_acquire(length + 1, &client_info->header_capacity);
+
+        va_start(args, format);
+        length = vsnprintf(client_info->header, client_info->header_capacity, format, args);
+        va_end(args);
+    }
+
+    client_info->HSIZE = length;
+}
+
+/**
+ * @brief Returns the session buffers to the pool.
+ * @details This function releases the request, header and body buffers, and unpins the cached response and stored value,
+ * once a response no longer needs them.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void session_release_buffers(client_session_t* client_info) {
+    buffer_release(client_info->request, client_info->request_capacity);
+    buffer_release(client_info->header, client_info->header_capacity);
+    buffer_release(client_info->body, client_info->body_capacity);
+
+    if (client_info->cached_response) {
+        response_cache_release(client_info->cached_response);
+        client_info->cached_response = NULL;
+    }
+
+    if (client_info->body_value) {
+        storage_value_release(client_info->body_value);
+        client_info->body_value = NULL;
+    }
+
+    client_info->request = client_info->header = client_info->body = NULL;
+    client_info->request_capacity = client_info->header_capacity = client_info->body_capacity = 0;
+}
+
+/**
+ * @brief Closes the file a response body was sent from.
+ * @details A file shared with other responses is only released, the last of them closes it.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void session_close_file(client_session_t* client_info) {
+    if (client_info->open_file) {
+        open_file_release(client_info->open_file);
+        client_info->open_file = NULL;
+    } else {
+        close(client_info->file_fd);
+    }
+}
+
+/**
+ * @brief Gets the number of open client sessions.
+ * @return Returns the number of sessions created and not yet destroyed.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t session_get_active() {
+    return active_sessions;
+}
@@ -4,21 +4,69 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/socket.h>
 #include "constants.h"
+#include "http_parser.h"
+#include "storage.h"
+#include "arena.h"
+#include "response_cache.h"
+#include "open_files.h"
+#include "access_log.h"
+#include "trace.h"
+#include "rate_limit.h"
 
-typedef struct {
+// Request, header and body buffers and the scratch arena come from the buffer pool on demand and go back to it
+// after each response, so a connection that has not sent anything yet holds no buffer at all.
+typedef struct client_session {
     int fd;
     int epfd;
+    client_limit_t* client_limit;  // Admission entry of the client address, NULL if the connection was rejected.
+    int rejection;                 // Status to answer the request with instead of serving it, 0 if admitted.
+    struct ucred peer;             // Credentials of a client of the UNIX socket listener, pid 0 for a TCP client.
     size_t bytes_sent;
     int file_fd;
+    off_t file_offset;             // Offset of the body in file_fd, non-zero for bodies sent from the asset pack.
     size_t file_size;
+    open_file_t* open_file;        // Shared entry file_fd belongs to, NULL if the session owns file_fd.
     bool body_chunking_enabled;
-    char request[RMAX];
+    bool body_streaming_enabled;
+    chunk_decoder_t chunk_decoder;
+    storage_stream_t upload;
+    const char* upload_key;
+    bool wal_sync_pending;
+    struct client_session* next_pending;
+    char* request;
+    size_t request_capacity;
     ssize_t request_size;
-    char header[HMAX];
+    char* header;
+    size_t header_capacity;
     int HSIZE;
-    char body[BMAX];
+    char* body;
+    size_t body_capacity;
+    storage_value_t* body_value;
     int BSIZE;
+    cached_response_t* cached_response;
+    arena_t scratch;
+    access_record_t log_record;
+    struct http2_connection* http2;  // HTTP/2 state of the connection, NULL for an HTTP/1.1 one.
+    struct http2_stream* stream;     // Stream whose request an exchange serves, NULL for a session of a connection.
+#ifdef HTTP_TRACE
+    trace_t trace;
+#endif
+#ifdef HTTP_TLS
+    struct ssl_st* ssl;     // TLS state of an HTTPS connection, NULL for a plain one.
+    bool tls_handshaking;
+#endif
 } client_session_t;
 
-#endif
\ No newline at end of file
+client_session_t* session_create(int fd, int epfd);
+void session_destroy(client_session_t* client_info);
+char* session_reserve_request(client_session_t* client_info, size_t size);
+char* session_reserve_body(client_session_t* client_info, size_t size);
+void* session_scratch(client_session_t* client_info, size_t size);
+void session_set_header(client_session_t* client_info, const char* format, ...) __attribute__((format(printf, 2, 3)));
+void session_release_buffers(client_session_t* client_info);
+void session_close_file(client_session_t* client_info);
+size_t session_get_active();
+
+#endif
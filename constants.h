@@ -2,16 +2,32 @@
 #define CONSTANTS_H
 
 #define RMAX 4096
+#define REQUEST_MAX (64 * 1024)
 #define HMAX 1024
 #define BMAX 1024
+#define CHUNK_LINE_MAX 64
+#define FILE_CHUNK (64 * 1024)
+#define KEY_MAX 64
+#define CHUNKED_BODY_MAX (1024 * 1024)
+#define BATCH_MAX (32 * 1024)
+#define BATCH_PAIRS_MAX 1024
+#define MGET_KEYS_MAX 256
+#define MGET_BODY_MAX (1024 * 1024)
 #define BACKLOG 10
+#define CLIENT_CONNECTIONS_MAX 256
 #define PORT 12686
 #define OK 200
 #define BAD_REQUEST 400
+#define FORBIDDEN 403
 #define NOT_FOUND 404
 #define ENTITY_TOO_LARGE 413
+#define TOO_MANY_REQUESTS 429
+#define INSUFFICIENT_STORAGE 507
 #define INTERNAL_SERVER_ERROR 500
+#define SERVICE_UNAVAILABLE 503
 #define MAX_EVENTS 10
 #define TIME_OUT -1
+#define IDLE_POLL_MS 100
+#define DRAIN_TIMEOUT 30
 
 #endif
\ No newline at end of file
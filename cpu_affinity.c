@@ -0,0 +1,114 @@
+/// @file cpu_affinity.c
+/// @brief Contains functions for placing the server on a core and its NUMA node.
+/// @details This file includes functions to pin the event loop to a core, to find the cores of its NUMA node from sysfs, and to place
+/// helper threads on those cores.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "cpu_affinity.h"
+
+static int loop_cpu = -1;
+static int loop_node = -1;
+
+static void node_cpus(int node, cpu_set_t* cpus);
+
+/**
+ * @brief Pins the calling thread, the event loop, to a core.
+ * @details This must be called before the server allocates its buffers, so that they are placed on the memory of the core's node.
+ * @param cpu The core.
+ * @return Returns 0 on success, or -1 if the core does not exist or is not allowed.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int affinity_pin_loop(int cpu) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        fprintf(stderr, "Pinning event loop failed: no core %d\n", cpu);
+        return -1;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) < 0) {
+        perror("Pinning event loop failed");
+        return -1;
+    }
+
+    unsigned current_cpu, node;
+    loop_cpu = cpu;
+    loop_node = getcpu(&current_cpu, &node) == 0 ? (int)node : -1;
+    return 0;
+}
+
+/**
+ * @brief Gets the core the event loop is pinned to.
+ * @return Returns the core, or -1 if the event loop is not pinned.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int affinity_loop_cpu() {
+    return loop_cpu;
+}
+
+/**
+ * @brief Keeps a helper thread off the event loop's core, on the same NUMA node.
+ * @details A thread created by the pinned event loop inherits its single core and would compete with it. It is moved to the other
+ * cores of the node, or to any other core if the node has no other core. On a single core it is left where it is.
+ * @param thread The helper thread.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of cores. Space complexity: O(1).
+ */
+void affinity_place_helper(pthread_t thread) {
+    if (loop_cpu < 0) return;
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    if (loop_node >= 0) {
+        node_cpus(loop_node, &cpus);
+    }
+    CPU_CLR(loop_cpu, &cpus);
+
+    if (CPU_COUNT(&cpus) == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        for (long cpu = 0; cpu < online && cpu < CPU_SETSIZE; cpu++) {
+            if (cpu != loop_cpu) CPU_SET(cpu, &cpus);
+        }
+        if (CPU_COUNT(&cpus) == 0) return;
+    }
+
+    pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+}
+
+/**
+ * @brief Reads the cores of a NUMA node from sysfs.
+ * @details The list has the form "0-3,8-11". Cores are left out if the list cannot be read.
+ * @param node The node.
+ * @param cpus The set receiving the cores.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of cores. Space complexity: O(1).
+ */
+static void node_cpus(int node, cpu_set_t* cpus) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+
+    FILE* list = fopen(path, "r");
+    if (!list) return;
+
+    int first, last;
+    while (fscanf(list, "%d", &first) == 1) {
+        last = first;
+        int separator = fgetc(list);
+        if (separator == '-') {
+            if (fscanf(list, "%d", &last) != 1) break;
+            separator = fgetc(list);
+        }
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, cpus);
+        }
+        if (separator != ',') break;
+    }
+
+    fclose(list);
+}
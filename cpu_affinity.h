@@ -0,0 +1,16 @@
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <pthread.h>
+
+/// @file cpu_affinity.h
+/// @brief Contains function declarations for placing the server on a core and its NUMA node.
+/// @details The event loop is pinned to one core before anything is allocated, so under the default first-touch policy the session
+/// cache, the buffer pool and the stored values all live on the memory of that core's node. Helper threads are kept on the other
+/// cores of the same node.
+
+int affinity_pin_loop(int cpu);
+int affinity_loop_cpu();
+void affinity_place_helper(pthread_t thread);
+
+#endif
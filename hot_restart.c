@@ -0,0 +1,224 @@
+/// @file hot_restart.c
+/// @brief Contains functions for handing the server over to a new process.
+/// @details This file includes the two sides of the handoff. The new process asks for the listening socket over the control socket,
+/// and the old process answers with the socket and, if asked for, a memfd holding a snapshot of the stored values.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "network_utils.h"
+#include "wal.h"
+#include "hot_restart.h"
+
+// Requests sent by the new process.
+#define RESTART_LISTENER_ONLY 'L'
+#define RESTART_WITH_STORAGE 'S'
+
+// How long the old server waits for the request of a process that connected, which a new server sends right away.
+#define RESTART_REQUEST_TIMEOUT_US (100 * 1000)
+
+static int control_address(const char* path, struct sockaddr_un* address);
+
+/**
+ * @brief Takes the listening sockets over from the server running on a control socket.
+ * @details If a server answers on the control socket, this function receives its listening sockets and loads the snapshot of its
+ * stored values. The old server stops accepting as soon as it has answered.
+ * @param path The path of the control socket.
+ * @param want_storage Whether to take the stored values over as well. A server with a write-ahead log recovers them from the log.
+ * @param listenfds An array of RESTART_MAX_LISTENERS entries receiving the listening sockets, in the order they were handed over.
+ * @return Returns the number of listening sockets received, or -1 if no server could hand them over.
+ * @note Time complexity: O(n) where n is the size of the snapshot. Space complexity: O(n).
+ */
+int restart_take_over(const char* path, bool want_storage, int* listenfds) {
+    struct sockaddr_un address;
+    if (control_address(path, &address) < 0) return -1;
+
+    int controlfd = Socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(controlfd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+        close(controlfd);
+        return -1;
+    }
+
+    char request = want_storage ? RESTART_WITH_STORAGE : RESTART_LISTENER_ONLY;
+    if (write(controlfd, &request, 1) != 1) {
+        close(controlfd);
+        return -1;
+    }
+
+    char reply;
+    int fds[RESTART_MAX_LISTENERS + 1];
+    union {
+        char buffer[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    struct iovec vector = { .iov_base = &reply, .iov_len = 1 };
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    ssize_t received = recvmsg(controlfd, &message, MSG_CMSG_CLOEXEC);
+    close(controlfd);
+
+    struct cmsghdr* header = received == 1 ? CMSG_FIRSTHDR(&message) : NULL;
+    if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+        fprintf(stderr, "Hot restart handoff failed\n");
+        return -1;
+    }
+    // The reply is the number of listening sockets, a snapshot follows them if there is one.
+    int count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    int listeners = reply < count ? reply : count;
+    if (listeners > RESTART_MAX_LISTENERS) listeners = RESTART_MAX_LISTENERS;
+    memcpy(fds, CMSG_DATA(header), count * sizeof(int));
+    memcpy(listenfds, fds, listeners * sizeof(int));
+
+    if (count > listeners) {
+        if (wal_import(fds[listeners]) < 0) {
+            perror("Loading storage snapshot failed");
+        }
+        close(fds[listeners]);
+    }
+
+    return listeners;
+}
+
+/**
+ * @brief Listens on the control socket for the next server to hand over to.
+ * @details A socket file left behind at the path is replaced, anything else there is left alone. The socket is created with mode 0600, so only the user the server runs
+ * as can connect to it.
+ * @param path The path of the control socket.
+ * @return Returns the control socket, or -1 if it could not be created.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int restart_listen(const char* path) {
+    struct sockaddr_un address;
+    if (control_address(path, &address) < 0) return -1;
+
+    int controlfd = Socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink_socket(path);
+
+    // The mode of a socket file is set by the umask when it is bound.
+    mode_t mask = umask(0177);
+    int bound = bind(controlfd, (struct sockaddr*)&address, sizeof(address));
+    umask(mask);
+
+    if (bound < 0 || listen(controlfd, 1) < 0) {
+        perror("Opening control socket failed");
+        close(controlfd);
+        return -1;
+    }
+
+    return controlfd;
+}
+
+/**
+ * @brief Closes the control socket of a server that stops without handing over.
+ * @param controlfd The control socket.
+ * @param path The path of the control socket, which is removed.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void restart_close(int controlfd, const char* path) {
+    close(controlfd);
+    unlink_socket(path);
+}
+
+/**
+ * @brief Hands the listening sockets over to a new server connecting to the control socket.
+ * @details Only a process of the same user is answered, and only if its request arrives within RESTART_REQUEST_TIMEOUT_US, so a
+ * process that connects and sends nothing holds the event loop up for no longer than that. The snapshot of the stored values is
+ * written to a memfd, so it is passed without touching the filesystem. The caller stops accepting once this function succeeds, and
+ * should not write to storage anymore.
+ * @param controlfd The control socket with a pending connection.
+ * @param listenfds The listening sockets.
+ * @param count The number of listening sockets, at most RESTART_MAX_LISTENERS.
+ * @return Returns 0 if the listening sockets were handed over, or -1 otherwise.
+ * @note Time complexity: O(n) where n is the size of the stored values. Space complexity: O(n).
+ */
+int restart_hand_over(int controlfd, const int* listenfds, int count) {
+    int peerfd = accept(controlfd, NULL, NULL);
+    if (peerfd < 0) return -1;
+
+    struct ucred peer;
+    socklen_t length = sizeof(peer);
+    if (getsockopt(peerfd, SOL_SOCKET, SO_PEERCRED, &peer, &length) < 0 || peer.uid != geteuid()) {
+        close(peerfd);
+        return -1;
+    }
+
+    struct timeval timeout = { .tv_sec = 0, .tv_usec = RESTART_REQUEST_TIMEOUT_US };
+    setsockopt(peerfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char request;
+    if (read(peerfd, &request, 1) != 1) {
+        close(peerfd);
+        return -1;
+    }
+
+    int fds[RESTART_MAX_LISTENERS + 1];
+    memcpy(fds, listenfds, count * sizeof(int));
+    int snapshotfd = -1;
+    if (request == RESTART_WITH_STORAGE) {
+        snapshotfd = memfd_create("storage-snapshot", MFD_CLOEXEC);
+        if (snapshotfd < 0 || wal_export(snapshotfd) < 0) {
+            perror("Writing storage snapshot failed");
+            if (snapshotfd >= 0) close(snapshotfd);
+            close(peerfd);
+            return -1;
+        }
+        fds[count] = snapshotfd;
+    }
+
+    char reply = count;
+    int total = snapshotfd >= 0 ? count + 1 : count;
+    union {
+        char buffer[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec vector = { .iov_base = &reply, .iov_len = 1 };
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vector;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = CMSG_SPACE(total * sizeof(int));
+
+    struct cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(total * sizeof(int));
+    memcpy(CMSG_DATA(header), fds, total * sizeof(int));
+
+    ssize_t sent = sendmsg(peerfd, &message, 0);
+    if (snapshotfd >= 0) close(snapshotfd);
+    close(peerfd);
+
+    return sent == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Fills in the address of a control socket.
+ * @param path The path of the control socket.
+ * @param address The address to fill in.
+ * @return Returns 0 on success, or -1 if the path is too long.
+ * @note Time complexity: O(n) where n is the length of the path. Space complexity: O(1).
+ */
+static int control_address(const char* path, struct sockaddr_un* address) {
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "Control socket path too long: %s\n", path);
+        return -1;
+    }
+    strcpy(address->sun_path, path);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef HOT_RESTART_H
+#define HOT_RESTART_H
+
+#include <stdbool.h>
+
+/// @file hot_restart.h
+/// @brief Contains function declarations for handing the server over to a new process.
+/// @details A server started with a control socket path listens on a UNIX socket there. A new server started with the same path
+/// connects to it and receives the listening sockets, and optionally a snapshot of the stored values, with SCM_RIGHTS. The old
+/// server then stops accepting, finishes its open connections and exits, so the port is never unbound. The control socket is only
+/// open to the user the server runs as, and is removed by a server that is stopped without handing over.
+
+// The most listening sockets handed over at once, the plain, the HTTPS and the UNIX one.
+#define RESTART_MAX_LISTENERS 3
+
+int restart_take_over(const char* path, bool want_storage, int* listenfds);
+int restart_listen(const char* path);
+void restart_close(int controlfd, const char* path);
+int restart_hand_over(int controlfd, const int* listenfds, int count);
+
+#endif
@@ -0,0 +1,467 @@
+/// @file hpack.c
+/// @brief Contains functions for HPACK header compression.
+/// @details This file includes the static table and Huffman code of RFC 7541, the dynamic table of a decoder, the decoder of request
+/// header blocks, and the stateless encoder of response headers.
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "buffer_pool.h"
+#include "network_utils.h"
+#include "hpack.h"
+
+#define STATIC_ENTRIES 61
+
+// Longest code of the Huffman code, only used by the end-of-string symbol.
+#define HUFFMAN_LENGTH_MAX 30
+
+typedef struct {
+    const char* name;
+    const char* value;
+} static_entry_t;
+
+// The static table, entry i has index i + 1.
+static const static_entry_t static_table[STATIC_ENTRIES] = {
+    { ":authority", "" }, { ":method", "GET" }, { ":method", "POST" }, { ":path", "/" }, { ":path", "/index.html" },
+    { ":scheme", "http" }, { ":scheme", "https" }, { ":status", "200" }, { ":status", "204" }, { ":status", "206" },
+    { ":status", "304" }, { ":status", "400" }, { ":status", "404" }, { ":status", "500" }, { "accept-charset", "" },
+    { "accept-encoding", "gzip, deflate" }, { "accept-language", "" }, { "accept-ranges", "" }, { "accept", "" },
+    { "access-control-allow-origin", "" }, { "age", "" }, { "allow", "" }, { "authorization", "" }, { "cache-control", "" },
+    { "content-disposition", "" }, { "content-encoding", "" }, { "content-language", "" }, { "content-length", "" },
+    { "content-location", "" }, { "content-range", "" }, { "content-type", "" }, { "cookie", "" }, { "date", "" }, { "etag", "" },
+    { "expect", "" }, { "expires", "" }, { "from", "" }, { "host", "" }, { "if-match", "" }, { "if-modified-since", "" },
+    { "if-none-match", "" }, { "if-range", "" }, { "if-unmodified-since", "" }, { "last-modified", "" }, { "link", "" },
+    { "location", "" }, { "max-forwards", "" }, { "proxy-authenticate", "" }, { "proxy-authorization", "" }, { "range", "" },
+    { "referer", "" }, { "refresh", "" }, { "retry-after", "" }, { "server", "" }, { "set-cookie", "" },
+    { "strict-transport-security", "" }, { "transfer-encoding", "" }, { "user-agent", "" }, { "vary", "" }, { "via", "" },
+    { "www-authenticate", "" },
+};
+
+// Code lengths of the Huffman code by symbol. The code is canonical, so the codes follow from the lengths.
+static const uint8_t huffman_lengths[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+
+// The canonical code by length: the first code of each length, how many codes have it, and where their symbols start in
+// huffman_symbols, which lists the symbols by code.
+static uint32_t huffman_first[HUFFMAN_LENGTH_MAX + 1];
+static uint16_t huffman_count[HUFFMAN_LENGTH_MAX + 1];
+static uint16_t huffman_offset[HUFFMAN_LENGTH_MAX + 1];
+static uint8_t huffman_symbols[256];
+static bool huffman_ready = false;
+
+static void huffman_build();
+static int huffman_decode(const uint8_t* data, size_t length, char* out, size_t* out_length);
+static int decode_integer(const uint8_t** cursor, const uint8_t* end, int prefix_bits, uint32_t* value);
+static int decode_string(const uint8_t** cursor, const uint8_t* end, char* scratch, const char** string, size_t* length);
+static int lookup(const hpack_table_t* table, uint32_t index, const char** name, size_t* name_length, const char** value, size_t* value_length);
+static void table_add(hpack_table_t* table, const char* name, size_t name_length, const char* value, size_t value_length);
+static void table_evict(hpack_table_t* table, size_t max_size);
+static size_t encode_integer(uint8_t* out, uint8_t first, int prefix_bits, size_t value);
+static size_t encode_string(uint8_t* out, const char* string, size_t length, bool lowercase);
+
+/**
+ * @brief Initializes an empty dynamic table.
+ * @param table The table.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void hpack_table_init(hpack_table_t* table) {
+    memset(table, 0, sizeof(*table));
+    table->max_size = HPACK_TABLE_SIZE;
+}
+
+/**
+ * @brief Frees the entries of a dynamic table.
+ * @param table The table.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of entries. Space complexity: O(1).
+ */
+void hpack_table_free(hpack_table_t* table) {
+    table_evict(table, 0);
+}
+
+/**
+ * @brief Decodes a header block.
+ * @details This function walks the representations of the block, updates the dynamic table as they require and hands every field to
+ * `on_field` in order. Huffman coded strings are decoded into a pooled scratch buffer, plain strings are handed over in place.
+ * @param table The dynamic table of the connection.
+ * @param block The header block.
+ * @param length The length of the block.
+ * @param on_field Callback invoked with each field.
+ * @param ctx Context passed to the callback.
+ * @return Returns 0 on success, or -1 if the block is malformed, which is a compression error of the connection.
+ * @note Time complexity: O(n) where n is the length of the block. Space complexity: O(n).
+ */
+int hpack_decode(hpack_table_t* table, const uint8_t* block, size_t length, hpack_field_cb on_field, void* ctx) {
+    const uint8_t* cursor = block;
+    const uint8_t* end = block + length;
+
+    // A Huffman coded string decodes to at most 8/5 of its length, so twice the block holds any name and value.
+    size_t scratch_capacity;
+    char* scratch = buffer_acquire(length * 2 + 2, &scratch_capacity);
+    int status = 0;
+
+    while (cursor < end && status == 0) {
+        uint8_t first = *cursor;
+        uint32_t index;
+        const char *name, *value;
+        size_t name_length, value_length;
+
+        if (first & 0x80) {
+            // Indexed field.
+            status = decode_integer(&cursor, end, 7, &index);
+            if (status == 0) status = lookup(table, index, &name, &name_length, &value, &value_length);
+            if (status == 0) on_field(ctx, name, name_length, value, value_length);
+            continue;
+        }
+
+        if ((first & 0xe0) == 0x20) {
+            // Dynamic table size update, never beyond the size the server allows.
+            status = decode_integer(&cursor, end, 5, &index);
+            if (status == 0 && index > HPACK_TABLE_SIZE) status = -1;
+            if (status == 0) {
+                table_evict(table, index);
+                table->max_size = index;
+            }
+            continue;
+        }
+
+        // Literal field, added to the table with incremental indexing, left out of it otherwise.
+        bool indexing = (first & 0xc0) == 0x40;
+        status = decode_integer(&cursor, end, indexing ? 6 : 4, &index);
+        if (status < 0) break;
+
+        if (index == 0) {
+            status = decode_string(&cursor, end, scratch, &name, &name_length);
+        } else {
+            status = lookup(table, index, &name, &name_length, &value, &value_length);
+        }
+        if (status < 0) break;
+
+        status = decode_string(&cursor, end, scratch + (index == 0 ? name_length : 0), &value, &value_length);
+        if (status < 0) break;
+
+        on_field(ctx, name, name_length, value, value_length);
+        if (indexing) {
+            table_add(table, name, name_length, value, value_length);
+        }
+    }
+
+    buffer_release(scratch, scratch_capacity);
+    return status;
+}
+
+/**
+ * @brief Encodes the :status field of a response.
+ * @param out The output, at least 5 bytes.
+ * @param status The status code.
+ * @return Returns the number of bytes written.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t hpack_encode_status(uint8_t* out, int status) {
+    for (int i = 7; i < 14; i++) {
+        if (atoi(static_table[i].value) == status) {
+            return encode_integer(out, 0x80, 7, i + 1);
+        }
+    }
+
+    char digits[4];
+    size_t length = snprintf(digits, sizeof(digits), "%03d", status % 1000);
+    size_t used = encode_integer(out, 0x00, 4, 8);
+    return used + encode_string(out + used, digits, length, false);
+}
+
+/**
+ * @brief Encodes a response header field.
+ * @details The field is encoded as a literal without indexing, referring to its name in the static table if it is there. The name is
+ * lowercased as HTTP/2 requires.
+ * @param out The output, at least name_length + value_length + 16 bytes.
+ * @param name The name of the field.
+ * @param name_length The length of the name.
+ * @param value The value of the field.
+ * @param value_length The length of the value.
+ * @return Returns the number of bytes written.
+ * @note Time complexity: O(n) where n is the length of the field. Space complexity: O(1).
+ */
+size_t hpack_encode_field(uint8_t* out, const char* name, size_t name_length, const char* value, size_t value_length) {
+    size_t used = 0;
+
+    for (int i = 14; i < STATIC_ENTRIES; i++) {
+        if (strlen(static_table[i].name) == name_length && strncasecmp(static_table[i].name, name, name_length) == 0) {
+            used = encode_integer(out, 0x00, 4, i + 1);
+            break;
+        }
+    }
+
+    if (used == 0) {
+        out[used++] = 0x00;
+        used += encode_string(out + used, name, name_length, true);
+    }
+
+    return used + encode_string(out + used, value, value_length, false);
+}
+
+/**
+ * @brief Looks a field up by index.
+ * @details Indices 1 to 61 refer to the static table, the ones after it to the dynamic table from its newest entry on.
+ * @param table The dynamic table.
+ * @param index The index.
+ * @param name Output for the name.
+ * @param name_length Output for the length of the name.
+ * @param value Output for the value.
+ * @param value_length Output for the length of the value.
+ * @return Returns 0 on success, or -1 if no entry has the index.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int lookup(const hpack_table_t* table, uint32_t index, const char** name, size_t* name_length, const char** value, size_t* value_length) {
+    if (index == 0) return -1;
+
+    if (index <= STATIC_ENTRIES) {
+        *name = static_table[index - 1].name;
+        *name_length = strlen(*name);
+        *value = static_table[index - 1].value;
+        *value_length = strlen(*value);
+        return 0;
+    }
+
+    index -= STATIC_ENTRIES + 1;
+    if (index >= table->count) return -1;
+
+    const hpack_entry_t* entry = &table->entries[(table->newest + index) % HPACK_ENTRIES_MAX];
+    *name = entry->field;
+    *name_length = entry->name_length;
+    *value = entry->field + entry->name_length;
+    *value_length = entry->value_length;
+    return 0;
+}
+
+/**
+ * @brief Adds a field to the dynamic table.
+ * @details Older entries are evicted until the field fits. A field larger than the whole table empties it and is not added. The field
+ * is copied before evicting, since its name may refer to an entry about to be evicted.
+ * @param table The dynamic table.
+ * @param name The name of the field.
+ * @param name_length The length of the name.
+ * @param value The value of the field.
+ * @param value_length The length of the value.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the field. Space complexity: O(n).
+ */
+static void table_add(hpack_table_t* table, const char* name, size_t name_length, const char* value, size_t value_length) {
+    size_t size = name_length + value_length + 32;
+    if (size > table->max_size) {
+        table_evict(table, 0);
+        return;
+    }
+
+    char* field = Malloc(name_length + value_length);
+    memcpy(field, name, name_length);
+    memcpy(field + name_length, value, value_length);
+
+    table_evict(table, table->max_size - size);
+
+    table->newest = (table->newest + HPACK_ENTRIES_MAX - 1) % HPACK_ENTRIES_MAX;
+    table->entries[table->newest] = (hpack_entry_t){ .field = field, .name_length = name_length, .value_length = value_length };
+    table->count++;
+    table->size += size;
+}
+
+/**
+ * @brief Evicts the oldest entries of the dynamic table until it takes no more than the given size.
+ * @param table The dynamic table.
+ * @param max_size The size to shrink the table to.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of evicted entries. Space complexity: O(1).
+ */
+static void table_evict(hpack_table_t* table, size_t max_size) {
+    while (table->count > 0 && table->size > max_size) {
+        hpack_entry_t* oldest = &table->entries[(table->newest + table->count - 1) % HPACK_ENTRIES_MAX];
+        table->size -= oldest->name_length + oldest->value_length + 32;
+        free(oldest->field);
+        table->count--;
+    }
+}
+
+/**
+ * @brief Decodes a prefixed integer.
+ * @param cursor The position of the integer, moved past it.
+ * @param end The end of the block.
+ * @param prefix_bits The number of bits of the first byte that belong to the integer.
+ * @param value Output for the integer.
+ * @return Returns 0 on success, or -1 if the integer is truncated or does not fit in 28 bits.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int decode_integer(const uint8_t** cursor, const uint8_t* end, int prefix_bits, uint32_t* value) {
+    if (*cursor >= end) return -1;
+
+    uint32_t max = (1u << prefix_bits) - 1;
+    uint32_t result = *(*cursor)++ & max;
+
+    if (result == max) {
+        for (int shift = 0; ; shift += 7) {
+            if (*cursor >= end || shift > 21) return -1;
+            uint8_t byte = *(*cursor)++;
+            result += (uint32_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+    }
+
+    *value = result;
+    return 0;
+}
+
+/**
+ * @brief Decodes a string literal.
+ * @param cursor The position of the string, moved past it.
+ * @param end The end of the block.
+ * @param scratch Where a Huffman coded string is decoded to.
+ * @param string Output for the string, pointing into the block or into the scratch buffer.
+ * @param length Output for the length of the string.
+ * @return Returns 0 on success, or -1 if the string is truncated or its Huffman code is invalid.
+ * @note Time complexity: O(n) where n is the length of the string. Space complexity: O(1).
+ */
+static int decode_string(const uint8_t** cursor, const uint8_t* end, char* scratch, const char** string, size_t* length) {
+    if (*cursor >= end) return -1;
+
+    bool huffman = **cursor & 0x80;
+    uint32_t encoded_length;
+    if (decode_integer(cursor, end, 7, &encoded_length) < 0 || encoded_length > (size_t)(end - *cursor)) return -1;
+
+    if (huffman) {
+        if (huffman_decode(*cursor, encoded_length, scratch, length) < 0) return -1;
+        *string = scratch;
+    } else {
+        *string = (const char*)*cursor;
+        *length = encoded_length;
+    }
+
+    *cursor += encoded_length;
+    return 0;
+}
+
+/**
+ * @brief Decodes a Huffman coded string.
+ * @details The code is read a bit at a time and a symbol is emitted as soon as the code read so far is one of the codes of its length.
+ * The string may end in up to 7 padding bits, which must be the start of the end-of-string code, that is all ones.
+ * @param data The coded string.
+ * @param length The length of the coded string.
+ * @param out Output for the decoded string, at least 8/5 of the coded length.
+ * @param out_length Output for the length of the decoded string.
+ * @return Returns 0 on success, or -1 if the code is invalid.
+ * @note Time complexity: O(n) where n is the length of the coded string. Space complexity: O(1).
+ */
+static int huffman_decode(const uint8_t* data, size_t length, char* out, size_t* out_length) {
+    huffman_build();
+
+    uint32_t code = 0;
+    int bits = 0;
+    size_t used = 0;
+
+    for (size_t i = 0; i < length; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            code = code << 1 | ((data[i] >> bit) & 1);
+            bits++;
+
+            if (bits > HUFFMAN_LENGTH_MAX) return -1;
+            if (code - huffman_first[bits] < huffman_count[bits]) {
+                out[used++] = huffman_symbols[huffman_offset[bits] + code - huffman_first[bits]];
+                code = 0;
+                bits = 0;
+            }
+        }
+    }
+
+    if (bits > 7 || code != (1u << bits) - 1) return -1;
+
+    *out_length = used;
+    return 0;
+}
+
+/**
+ * @brief Derives the canonical Huffman code from the code lengths, once.
+ * @details Symbols are ordered by code length and then by value, and each code is the previous one plus one, shifted left whenever
+ * the length grows.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void huffman_build() {
+    if (huffman_ready) return;
+
+    uint32_t code = 0;
+    size_t next = 0;
+    for (int length = 1; length <= HUFFMAN_LENGTH_MAX; length++) {
+        huffman_first[length] = code;
+        huffman_offset[length] = next;
+        for (int symbol = 0; symbol < 256; symbol++) {
+            if (huffman_lengths[symbol] == length) {
+                huffman_symbols[next++] = symbol;
+                huffman_count[length]++;
+                code++;
+            }
+        }
+        code <<= 1;
+    }
+
+    huffman_ready = true;
+}
+
+/**
+ * @brief Encodes a prefixed integer.
+ * @param out The output.
+ * @param first The bits of the first byte that precede the prefix.
+ * @param prefix_bits The number of bits of the first byte that belong to the integer.
+ * @param value The integer.
+ * @return Returns the number of bytes written.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static size_t encode_integer(uint8_t* out, uint8_t first, int prefix_bits, size_t value) {
+    size_t max = (1u << prefix_bits) - 1;
+    if (value < max) {
+        out[0] = first | value;
+        return 1;
+    }
+
+    size_t used = 0;
+    out[used++] = first | max;
+    for (value -= max; value >= 0x80; value >>= 7) {
+        out[used++] = (value & 0x7f) | 0x80;
+    }
+    out[used++] = value;
+    return used;
+}
+
+/**
+ * @brief Encodes a string literal without Huffman coding.
+ * @param out The output.
+ * @param string The string.
+ * @param length The length of the string.
+ * @param lowercase Whether to lowercase the string.
+ * @return Returns the number of bytes written.
+ * @note Time complexity: O(n) where n is the length of the string. Space complexity: O(1).
+ */
+static size_t encode_string(uint8_t* out, const char* string, size_t length, bool lowercase) {
+    size_t used = encode_integer(out, 0x00, 7, length);
+    for (size_t i = 0; i < length; i++) {
+        out[used + i] = lowercase && string[i] >= 'A' && string[i] <= 'Z' ? string[i] - 'A' + 'a' : string[i];
+    }
+    return used + length;
+}
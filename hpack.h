@@ -0,0 +1,45 @@
+#ifndef HPACK_H
+#define HPACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file hpack.h
+/// @brief Contains function declarations for HPACK header compression.
+/// @details Request header blocks are decoded against the static table, the dynamic table of their connection and the Huffman code of
+/// RFC 7541. Response headers are encoded against the static table only, as literals the client does not index, so the encoder keeps
+/// no state per connection.
+
+// Size of the dynamic table. The server never announces another one, so clients may only shrink it.
+#define HPACK_TABLE_SIZE 4096
+
+// Every entry counts 32 bytes on top of its name and value, which bounds the number of entries.
+#define HPACK_ENTRIES_MAX (HPACK_TABLE_SIZE / 32)
+
+// A dynamic table entry, the value is stored right after the name.
+typedef struct {
+    char* field;
+    size_t name_length;
+    size_t value_length;
+} hpack_entry_t;
+
+// The dynamic table of a decoder, a ring of entries from the newest to the oldest.
+typedef struct {
+    hpack_entry_t entries[HPACK_ENTRIES_MAX];
+    size_t newest;
+    size_t count;
+    size_t size;      // Size of the entries as defined by RFC 7541.
+    size_t max_size;
+} hpack_table_t;
+
+/// @brief Callback invoked with each decoded header field.
+/// @details Name and value are only valid for the duration of the call.
+typedef void (*hpack_field_cb)(void* ctx, const char* name, size_t name_length, const char* value, size_t value_length);
+
+void hpack_table_init(hpack_table_t* table);
+void hpack_table_free(hpack_table_t* table);
+int hpack_decode(hpack_table_t* table, const uint8_t* block, size_t length, hpack_field_cb on_field, void* ctx);
+size_t hpack_encode_status(uint8_t* out, int status);
+size_t hpack_encode_field(uint8_t* out, const char* name, size_t name_length, const char* value, size_t value_length);
+
+#endif
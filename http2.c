@@ -0,0 +1,1619 @@
+/// @file http2.c
+/// @brief Contains functions for serving HTTP/2 connections.
+/// @details This file includes functions to switch a connection to HTTP/2, to act on the frames the client sends, to turn every
+/// request into an exchange session that is served like the request of a connection of its own, and to send the responses of all
+/// streams in turns within the flow control windows.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "constants.h"
+#include "network_utils.h"
+#include "buffer_pool.h"
+#include "server_config.h"
+#include "hpack.h"
+#include "http2.h"
+#include "probes.h"
+
+// The client connection preface, followed by the client's SETTINGS frame.
+#define HTTP2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define HTTP2_PREFACE_LENGTH (sizeof(HTTP2_PREFACE) - 1)
+
+#define FRAME_HEADER_SIZE 9
+
+// Largest frame payload the server receives, the protocol default, which it never raises.
+#define FRAME_PAYLOAD_MAX 16384
+
+// Flow control window every connection and stream starts with, and the largest one allowed.
+#define WINDOW_INITIAL 65535
+#define WINDOW_MAX 0x7fffffff
+
+// Streams a client may have open at once, announced in the server's SETTINGS frame.
+#define HTTP2_STREAMS_MAX 128
+
+// Room kept in a request for the Content-Length header added once its body is complete.
+#define CONTENT_LENGTH_LINE_MAX 32
+
+// Maximum number of finished streams kept for reuse.
+#define STREAM_CACHE_MAX 1024
+
+// Bytes of frames waiting for the client to read them beyond which no more frames are read from it.
+#define HTTP2_OUTPUT_MAX (64 * 1024)
+
+// PING, SETTINGS and RST_STREAM frames a client may send while output is waiting for it, beyond which the connection is failed.
+#define HTTP2_CONTROL_MAX 1024
+
+enum {
+    FRAME_DATA,
+    FRAME_HEADERS,
+    FRAME_PRIORITY,
+    FRAME_RST_STREAM,
+    FRAME_SETTINGS,
+    FRAME_PUSH_PROMISE,
+    FRAME_PING,
+    FRAME_GOAWAY,
+    FRAME_WINDOW_UPDATE,
+    FRAME_CONTINUATION
+};
+
+#define FLAG_END_STREAM 0x01
+#define FLAG_ACK 0x01
+#define FLAG_END_HEADERS 0x04
+#define FLAG_PADDED 0x08
+#define FLAG_PRIORITY 0x20
+
+enum {
+    SETTINGS_HEADER_TABLE_SIZE = 1,
+    SETTINGS_ENABLE_PUSH,
+    SETTINGS_MAX_CONCURRENT_STREAMS,
+    SETTINGS_INITIAL_WINDOW_SIZE,
+    SETTINGS_MAX_FRAME_SIZE,
+    SETTINGS_MAX_HEADER_LIST_SIZE
+};
+
+// Error codes of RST_STREAM and GOAWAY frames.
+enum {
+    H2_NO_ERROR = 0,
+    H2_PROTOCOL_ERROR = 1,
+    H2_FLOW_CONTROL_ERROR = 3,
+    H2_STREAM_CLOSED = 5,
+    H2_FRAME_SIZE_ERROR = 6,
+    H2_REFUSED_STREAM = 7,
+    H2_COMPRESSION_ERROR = 9,
+    H2_ENHANCE_YOUR_CALM = 11
+};
+
+typedef enum {
+    STREAM_RECEIVING,  // The request is still arriving.
+    STREAM_SERVING,    // The request is complete and the response not set yet, it waits for the write-ahead log.
+    STREAM_SENDING     // The response body is being sent.
+} stream_state_t;
+
+typedef struct http2_stream {
+    struct http2_stream* next;
+    struct http2_connection* connection;
+    client_session_t* exchange;   // The session serving the request of the stream.
+    uint32_t id;
+    stream_state_t state;
+    int64_t send_window;
+    const char* method;           // Pseudo-header fields, copied into the scratch arena of the exchange.
+    const char* path;
+    const char* authority;
+    size_t head_length;           // Length of the request head up to its empty line.
+    bool has_host;
+    bool has_length;              // Whether the request has a body, even an empty one, so it needs a Content-Length header.
+    bool malformed;
+    bool too_large;
+    bool reset;                   // Whether the client reset the stream while it was waiting for the write-ahead log.
+    const char* body;             // Response body in memory, NULL if it is a file.
+    size_t body_size;
+    size_t body_sent;
+} http2_stream_t;
+
+typedef struct http2_connection {
+    client_session_t* session;    // The session of the connection.
+    hpack_table_t decoder;
+    char* input;                  // Received bytes of frames that are not complete yet.
+    size_t input_length;
+    size_t input_capacity;
+    char* output;                 // Frames waiting to be sent, also those the socket did not take yet.
+    size_t output_length;
+    size_t output_capacity;
+    size_t control_frames;        // PING, SETTINGS and RST_STREAM frames received since the output was last empty.
+    char* block;                  // Header block continued in CONTINUATION frames.
+    size_t block_length;
+    size_t block_capacity;
+    uint32_t block_stream;        // Stream of the continued header block, 0 if there is none.
+    uint8_t block_flags;
+    size_t preface_remaining;     // Bytes of the client preface still expected after an upgrade.
+    http2_stream_t* streams;      // Open streams, oldest first.
+    size_t stream_count;
+    uint32_t last_stream_id;
+    int64_t send_window;
+    int64_t initial_window;       // Window the client grants every new stream.
+    uint32_t max_frame;           // Largest frame payload the client receives.
+    uint32_t events;              // Events the connection is monitored for.
+    bool processing;              // Whether frames are being handled, which defers sending until they all are.
+    bool failed;                  // Whether the connection has to be closed.
+    bool closed;                  // Whether the connection is closed and only waits for its streams on the write-ahead log.
+    bool goaway;                  // Whether the client is done opening streams.
+} http2_connection_t;
+
+static http2_stream_t* stream_cache = NULL;
+static size_t stream_cache_count = 0;
+
+static http2_connection_t* open_connection(client_session_t* session);
+static void receive_frames(http2_connection_t* connection);
+static void handle_frame(http2_connection_t* connection, uint8_t type, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length);
+static void receive_headers(http2_connection_t* connection, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length);
+static void receive_continuation(http2_connection_t* connection, uint8_t flags, const uint8_t* payload, size_t length);
+static void end_header_block(http2_connection_t* connection, uint32_t stream_id, uint8_t flags, const uint8_t* block, size_t length);
+static void receive_data(http2_connection_t* connection, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length);
+static void receive_settings(http2_connection_t* connection, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length);
+static void receive_window_update(http2_connection_t* connection, uint32_t stream_id, const uint8_t* payload, size_t length);
+static int apply_settings(http2_connection_t* connection, const uint8_t* payload, size_t length);
+static void add_field(void* ctx, const char* name, size_t name_length, const char* value, size_t value_length);
+static void skip_field(void* ctx, const char* name, size_t name_length, const char* value, size_t value_length);
+static void write_request_head(http2_stream_t* stream);
+static void complete_request(http2_stream_t* stream);
+static void start_response(http2_stream_t* stream);
+static void send_streams(http2_connection_t* connection);
+static void send_data(http2_stream_t* stream, size_t length);
+static size_t sendable_length(const http2_stream_t* stream);
+static http2_stream_t* open_stream(http2_connection_t* connection, uint32_t id);
+static http2_stream_t* find_stream(http2_connection_t* connection, uint32_t id);
+static void stream_error(http2_stream_t* stream, uint32_t code);
+static void reset_stream(http2_stream_t* stream);
+static void end_stream(http2_stream_t* stream);
+static void connection_error(http2_connection_t* connection, uint32_t code);
+static void finish_io(http2_connection_t* connection);
+static void update_interest(http2_connection_t* connection);
+static void close_connection(http2_connection_t* connection);
+static void release_connection(http2_connection_t* connection);
+static void queue_header(http2_connection_t* connection, uint8_t type, uint8_t flags, uint32_t stream_id, size_t length);
+static void queue_frame(http2_connection_t* connection, uint8_t type, uint8_t flags, uint32_t stream_id, const void* payload, size_t length);
+static void queue_code(http2_connection_t* connection, uint8_t type, uint32_t stream_id, uint32_t code);
+static void queue_bytes(http2_connection_t* connection, const void* data, size_t length);
+static void queue_file(http2_connection_t* connection, int fd, off_t offset, size_t length);
+static bool count_control(http2_connection_t* connection);
+static void flush_output(http2_connection_t* connection, const char* payload, size_t length, int flags);
+static const char* find_header(const char* request, const char* name);
+static bool field_is(const char* name, size_t name_length, const char* expected);
+static bool field_safe(const char* text, size_t length, bool name);
+static ssize_t base64url_decode(const char* text, size_t length, uint8_t* out);
+static uint32_t get_uint32(const uint8_t* in);
+static void put_uint32(uint8_t* out, uint32_t value);
+
+/**
+ * @brief Checks whether received data starts with the HTTP/2 client connection preface.
+ * @details The preface has to arrive with the first read of the connection, as it does from clients sending it with prior knowledge.
+ * @param data The received data.
+ * @param length The length of the data.
+ * @return Returns true if the connection speaks HTTP/2, false otherwise.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool http2_preface(const char* data, size_t length) {
+    return length >= HTTP2_PREFACE_LENGTH && memcmp(data, HTTP2_PREFACE, HTTP2_PREFACE_LENGTH) == 0;
+}
+
+/**
+ * @brief Switches a connection that sent the client preface to HTTP/2.
+ * @details The frames that arrived together with the preface are handled right away.
+ * @param client_info Pointer to the client session information, with the first read in its request buffer.
+ * @param length The number of bytes of the first read.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of bytes read. Space complexity: O(1).
+ */
+void http2_start(client_session_t* client_info, size_t length) {
+    http2_connection_t* connection = open_connection(client_info);
+
+    // The first read holds at most REQUEST_MAX bytes, which the input buffer fits.
+    connection->input_length = length - HTTP2_PREFACE_LENGTH;
+    memcpy(connection->input, client_info->request + HTTP2_PREFACE_LENGTH, connection->input_length);
+    session_release_buffers(client_info);
+
+    connection->processing = true;
+    receive_frames(connection);
+    connection->processing = false;
+    finish_io(connection);
+}
+
+/**
+ * @brief Upgrades a connection to h2c if its request asks for it.
+ * @details A request with "Upgrade: h2c" and an HTTP2-Settings header is answered with 101 Switching Protocols, and then served as
+ * stream 1 of the new HTTP/2 connection. Requests with a body are left to HTTP/1.1, so no body ever moves over to a stream.
+ * @param client_info Pointer to the client session information, holding a complete admitted request.
+ * @return Returns true if the connection was upgraded, or false, with nothing changed, if the request is to be served over HTTP/1.1.
+ * @note Time complexity: O(n) where n is the size of the request. Space complexity: O(n).
+ */
+bool http2_upgrade(client_session_t* client_info) {
+    const char* request = client_info->request;
+    const char* upgrade = find_header(request, "Upgrade");
+    const char* settings = find_header(request, "HTTP2-Settings");
+
+    if (!upgrade || strncasecmp(upgrade, "h2c", 3) != 0 || !settings) return false;
+    if (find_header(request, "Content-Length") || find_header(request, "Transfer-Encoding")) return false;
+
+    size_t settings_length = strcspn(settings, "\r\n ");
+    uint8_t* payload = session_scratch(client_info, settings_length);
+    ssize_t payload_length = base64url_decode(settings, settings_length, payload);
+    if (payload_length < 0 || payload_length % 6 != 0) return false;
+
+    static const char switching[] = "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\nUpgrade: h2c\r\n\r\n";
+    send(client_info->fd, switching, sizeof(switching) - 1, MSG_NOSIGNAL);
+
+    http2_connection_t* connection = open_connection(client_info);
+    connection->preface_remaining = HTTP2_PREFACE_LENGTH;
+    int error = apply_settings(connection, payload, payload_length);
+    if (error) {
+        connection_error(connection, error);
+    }
+
+    // The request moves over to the exchange of stream 1, together with its access log record.
+    http2_stream_t* stream = open_stream(connection, 1);
+    client_session_t* exchange = stream->exchange;
+    exchange->request = client_info->request;
+    exchange->request_capacity = client_info->request_capacity;
+    exchange->request_size = client_info->request_size;
+    exchange->log_record = client_info->log_record;
+    client_info->request = NULL;
+    client_info->request_capacity = 0;
+    memset(&client_info->log_record, 0, sizeof(client_info->log_record));
+    session_release_buffers(client_info);
+
+    connection->processing = true;
+    if (!connection->failed) {
+        stream->state = STREAM_SERVING;
+        serve_request(exchange);
+    }
+    connection->processing = false;
+    finish_io(connection);
+
+    return true;
+}
+
+/**
+ * @brief Handles an event on an HTTP/2 connection.
+ * @details This function sends the output the socket did not take before, receives what the client sent and handles every complete
+ * frame, then sends responses for as long as the flow control windows allow, up to FILE_CHUNK bytes of bodies per event so other
+ * connections get their turn. While more than HTTP2_OUTPUT_MAX bytes wait for the client to read them, nothing more is read from it.
+ * @param client_info Pointer to the session of the connection.
+ * @param events The events that occurred.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the received and sent frames. Space complexity: O(n).
+ */
+void http2_process(client_session_t* client_info, uint32_t events) {
+    http2_connection_t* connection = client_info->http2;
+    connection->processing = true;
+
+    if (events & EPOLLOUT) {
+        flush_output(connection, NULL, 0, 0);
+    }
+
+    // Errors are received even while reading is paused, since they end the connection.
+    bool reading = connection->output_length < HTTP2_OUTPUT_MAX && connection->input_length < connection->input_capacity;
+    if ((events & (EPOLLHUP | EPOLLERR)) || (reading && (events & EPOLLIN))) {
+        ssize_t received = recv(client_info->fd, connection->input + connection->input_length,
+            connection->input_capacity - connection->input_length, MSG_DONTWAIT);
+
+        if (received > 0) {
+            connection->input_length += received;
+        } else if (received == 0 || (errno != EAGAIN && errno != EINTR)) {
+            connection->failed = true;
+        }
+    }
+
+    // Frames left unhandled while the output was full are handled once the client has read some of it.
+    if (!connection->failed) {
+        receive_frames(connection);
+    }
+
+    connection->processing = false;
+    finish_io(connection);
+}
+
+/**
+ * @brief Sends the response an exchange has been given.
+ * @details This function is called in place of sending the response over a connection of its own. The response headers go out as a
+ * HEADERS frame, and the body follows in DATA frames as the windows allow. The response of a stream the client reset is dropped.
+ * @param exchange Pointer to the exchange of a stream.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the response headers. Space complexity: O(n).
+ */
+void http2_respond(client_session_t* exchange) {
+    http2_stream_t* stream = exchange->stream;
+    http2_connection_t* connection = stream->connection;
+
+    if (stream->reset || connection->closed) {
+        end_stream(stream);
+    } else {
+        start_response(stream);
+    }
+
+    // Responses set while frames are handled are sent once all of them have been.
+    if (!connection->processing) {
+        finish_io(connection);
+    }
+}
+
+/**
+ * @brief Attaches HTTP/2 state to a connection.
+ * @details The server's SETTINGS frame, which has to be the first frame it sends, is queued right away, and Nagle's algorithm is
+ * turned off. The socket is made non-blocking, so a client that does not read can never hold up the event loop.
+ * @param session Pointer to the session of the connection.
+ * @return Returns the HTTP/2 state of the connection.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static http2_connection_t* open_connection(client_session_t* session) {
+    http2_connection_t* connection = Malloc(sizeof(http2_connection_t));
+    memset(connection, 0, sizeof(http2_connection_t));
+
+    connection->session = session;
+    hpack_table_init(&connection->decoder);
+    connection->input = buffer_acquire(REQUEST_MAX, &connection->input_capacity);
+    connection->send_window = WINDOW_INITIAL;
+    connection->initial_window = WINDOW_INITIAL;
+    connection->max_frame = FRAME_PAYLOAD_MAX;
+    connection->events = EPOLLIN;
+    session->http2 = connection;
+
+    // Responses of streams served apart go out in small writes, which must not wait for the acknowledgement of the previous one.
+    int nodelay = 1;
+    setsockopt(session->fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    fcntl(session->fd, F_SETFL, fcntl(session->fd, F_GETFL) | O_NONBLOCK);
+
+    uint8_t settings[6] = { 0, SETTINGS_MAX_CONCURRENT_STREAMS };
+    put_uint32(settings + 2, HTTP2_STREAMS_MAX);
+    queue_frame(connection, FRAME_SETTINGS, 0, 0, settings, sizeof(settings));
+
+    return connection;
+}
+
+/**
+ * @brief Handles the complete frames in the input buffer.
+ * @details A frame cut off at the end of the buffer is kept for the next read, and so are the frames after the output grew beyond
+ * HTTP2_OUTPUT_MAX bytes. After an upgrade, the client preface is expected first.
+ * @param connection The HTTP/2 connection.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of buffered bytes. Space complexity: O(1).
+ */
+static void receive_frames(http2_connection_t* connection) {
+    const uint8_t* input = (const uint8_t*)connection->input;
+    size_t offset = 0;
+
+    if (connection->preface_remaining) {
+        size_t length = connection->input_length < connection->preface_remaining ? connection->input_length : connection->preface_remaining;
+        if (memcmp(input, HTTP2_PREFACE + HTTP2_PREFACE_LENGTH - connection->preface_remaining, length) != 0) {
+            connection_error(connection, H2_PROTOCOL_ERROR);
+            return;
+        }
+        connection->preface_remaining -= length;
+        offset = length;
+    }
+
+    while (!connection->failed && connection->output_length < HTTP2_OUTPUT_MAX && connection->input_length - offset >= FRAME_HEADER_SIZE) {
+        const uint8_t* frame = input + offset;
+        size_t length = (size_t)frame[0] << 16 | frame[1] << 8 | frame[2];
+
+        if (length > FRAME_PAYLOAD_MAX) {
+            connection_error(connection, H2_FRAME_SIZE_ERROR);
+            break;
+        }
+        if (connection->input_length - offset < FRAME_HEADER_SIZE + length) break;
+
+        handle_frame(connection, frame[3], frame[4], get_uint32(frame + 5) & 0x7fffffff, frame + FRAME_HEADER_SIZE, length);
+        offset += FRAME_HEADER_SIZE + length;
+    }
+
+    connection->input_length -= offset;
+    memmove(connection->input, connection->input + offset, connection->input_length);
+}
+
+/**
+ * @brief Handles a frame.
+ * @details Priorities are ignored, since streams are served in turns, and so are frames of unknown types.
+ * @param connection The HTTP/2 connection.
+ * @param type The type of the frame.
+ * @param flags The flags of the frame.
+ * @param stream_id The stream of the frame, 0 for the connection.
+ * @param payload The payload of the frame.
+ * @param length The length of the payload.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the payload. Space complexity: O(n).
+ */
+static void handle_frame(http2_connection_t* connection, uint8_t type, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length) {
+    // Nothing may come between the frames of a header block.
+    if (connection->block_stream && (type != FRAME_CONTINUATION || stream_id != connection->block_stream)) {
+        connection_error(connection, H2_PROTOCOL_ERROR);
+        return;
+    }
+
+    http2_stream_t* stream;
+
+    switch (type) {
+        case FRAME_DATA:
+            receive_data(connection, flags, stream_id, payload, length);
+            break;
+        case FRAME_HEADERS:
+            receive_headers(connection, flags, stream_id, payload, length);
+            break;
+        case FRAME_PRIORITY:
+            if (stream_id == 0) connection_error(connection, H2_PROTOCOL_ERROR);
+            break;
+        case FRAME_RST_STREAM:
+            if (stream_id == 0 || length != 4) {
+                connection_error(connection, stream_id == 0 ? H2_PROTOCOL_ERROR : H2_FRAME_SIZE_ERROR);
+            } else if (count_control(connection) && (stream = find_stream(connection, stream_id))) {
+                reset_stream(stream);
+            }
+            break;
+        case FRAME_SETTINGS:
+            receive_settings(connection, flags, stream_id, payload, length);
+            break;
+        case FRAME_PUSH_PROMISE:
+            // Only servers push.
+            connection_error(connection, H2_PROTOCOL_ERROR);
+            break;
+        case FRAME_PING:
+            if (stream_id != 0 || length != 8) {
+                connection_error(connection, stream_id != 0 ? H2_PROTOCOL_ERROR : H2_FRAME_SIZE_ERROR);
+            } else if (!(flags & FLAG_ACK) && count_control(connection)) {
+                queue_frame(connection, FRAME_PING, FLAG_ACK, 0, payload, length);
+            }
+            break;
+        case FRAME_GOAWAY:
+            // The streams the client opened so far are still answered.
+            connection->goaway = true;
+            break;
+        case FRAME_WINDOW_UPDATE:
+            receive_window_update(connection, stream_id, payload, length);
+            break;
+        case FRAME_CONTINUATION:
+            receive_continuation(connection, flags, payload, length);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Handles a HEADERS frame.
+ * @details A header block that ends in this frame is decoded straight out of the input buffer, otherwise it is collected until its last
+ * CONTINUATION frame. Padding and priority fields are skipped.
+ * @param connection The HTTP/2 connection.
+ * @param flags The flags of the frame.
+ * @param stream_id The stream of the frame.
+ * @param payload The payload of the frame.
+ * @param length The length of the payload.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the payload. Space complexity: O(n).
+ */
+static void receive_headers(http2_connection_t* connection, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length) {
+    size_t padding = 0;
+
+    if (flags & FLAG_PADDED) {
+        if (length < 1) {
+            connection_error(connection, H2_FRAME_SIZE_ERROR);
+            return;
+        }
+        padding = payload[0];
+        payload++;
+        length--;
+    }
+    if (flags & FLAG_PRIORITY) {
+        if (length < 5) {
+            connection_error(connection, H2_FRAME_SIZE_ERROR);
+            return;
+        }
+        payload += 5;
+        length -= 5;
+    }
+
+    // Clients open odd-numbered streams.
+    if (stream_id % 2 == 0 || padding > length) {
+        connection_error(connection, H2_PROTOCOL_ERROR);
+        return;
+    }
+    length -= padding;
+
+    if (flags & FLAG_END_HEADERS) {
+        end_header_block(connection, stream_id, flags, payload, length);
+        return;
+    }
+
+    connection->block_stream = stream_id;
+    connection->block_flags = flags;
+    connection->block_length = 0;
+    receive_continuation(connection, 0, payload, length);
+}
+
+/**
+ * @brief Collects a fragment of a header block, and handles the block once it is complete.
+ * @details Header blocks are bounded by REQUEST_MAX bytes.
+ * @param connection The HTTP/2 connection.
+ * @param flags The flags of the frame, or 0 for the fragment in the HEADERS frame.
+ * @param payload The fragment.
+ * @param length The length of the fragment.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the fragment. Space complexity: O(n).
+ */
+static void receive_continuation(http2_connection_t* connection, uint8_t flags, const uint8_t* payload, size_t length) {
+    if (!connection->block_stream) {
+        connection_error(connection, H2_PROTOCOL_ERROR);
+        return;
+    }
+
+    size_t needed = connection->block_length + length;
+    if (needed > REQUEST_MAX) {
+        connection_error(connection, H2_ENHANCE_YOUR_CALM);
+        return;
+    }
+    if (needed > connection->block_capacity) {
+        connection->block = buffer_grow(connection->block, connection->block_length, needed, &connection->block_capacity);
+    }
+    memcpy(connection->block + connection->block_length, payload, length);
+    connection->block_length = needed;
+
+    if (flags & FLAG_END_HEADERS) {
+        uint32_t stream_id = connection->block_stream;
+        connection->block_stream = 0;
+        end_header_block(connection, stream_id, connection->block_flags, (const uint8_t*)connection->block, connection->block_length);
+    }
+}
+
+/**
+ * @brief Handles a complete header block.
+ * @details A block on a new stream opens it and is decoded into the head of its request. A block on a stream whose body is arriving
+ * holds trailers, which end the request and are dropped. Streams beyond HTTP2_STREAMS_MAX are refused, but their blocks are still
+ * decoded, since every block changes the dynamic table.
+ * @param connection The HTTP/2 connection.
+ * @param stream_id The stream of the block.
+ * @param flags The flags of the HEADERS frame.
+ * @param block The header block.
+ * @param length The length of the block.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the block. Space complexity: O(n).
+ */
+static void end_header_block(http2_connection_t* connection, uint32_t stream_id, uint8_t flags, const uint8_t* block, size_t length) {
+    http2_stream_t* stream = find_stream(connection, stream_id);
+
+    if (stream) {
+        if (stream->state != STREAM_RECEIVING || !(flags & FLAG_END_STREAM)) {
+            connection_error(connection, H2_PROTOCOL_ERROR);
+        } else if (hpack_decode(&connection->decoder, block, length, skip_field, NULL) < 0) {
+            connection_error(connection, H2_COMPRESSION_ERROR);
+        } else {
+            complete_request(stream);
+        }
+        return;
+    }
+
+    if (stream_id <= connection->last_stream_id) {
+        connection_error(connection, H2_STREAM_CLOSED);
+        return;
+    }
+
+    if (connection->stream_count >= HTTP2_STREAMS_MAX || connection->goaway) {
+        connection->last_stream_id = stream_id;
+        if (hpack_decode(&connection->decoder, block, length, skip_field, NULL) < 0) {
+            connection_error(connection, H2_COMPRESSION_ERROR);
+        } else {
+            queue_code(connection, FRAME_RST_STREAM, stream_id, H2_REFUSED_STREAM);
+        }
+        return;
+    }
+
+    stream = open_stream(connection, stream_id);
+    if (hpack_decode(&connection->decoder, block, length, add_field, stream) < 0) {
+        connection_error(connection, H2_COMPRESSION_ERROR);
+        return;
+    }
+
+    if (stream->malformed || !stream->method || !stream->path) {
+        stream_error(stream, H2_PROTOCOL_ERROR);
+        return;
+    }
+
+    write_request_head(stream);
+    if (flags & FLAG_END_STREAM) {
+        complete_request(stream);
+    }
+}
+
+/**
+ * @brief Adds a decoded field to the request of a stream.
+ * @details Pseudo-header fields are kept for the request line. Other fields are written as header lines, apart from Content-Length,
+ * which is written once the body is complete, and fields that are specific to an HTTP/1.1 connection. Fields that could break out of
+ * their line make the request malformed.
+ * @param ctx Pointer to the stream.
+ * @param name The name of the field.
+ * @param name_length The length of the name.
+ * @param value The value of the field.
+ * @param value_length The length of the value.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the field. Space complexity: O(n).
+ */
+static void add_field(void* ctx, const char* name, size_t name_length, const char* value, size_t value_length) {
+    http2_stream_t* stream = (http2_stream_t*)ctx;
+    client_session_t* exchange = stream->exchange;
+
+    if (name_length == 0 || !field_safe(name, name_length, true) || !field_safe(value, value_length, false)) {
+        stream->malformed = true;
+        return;
+    }
+
+    if (name[0] == ':') {
+        const char** target = NULL;
+        if (field_is(name, name_length, ":method")) {
+            target = &stream->method;
+        } else if (field_is(name, name_length, ":path")) {
+            target = &stream->path;
+        } else if (field_is(name, name_length, ":authority")) {
+            target = &stream->authority;
+        } else if (!field_is(name, name_length, ":scheme")) {
+            stream->malformed = true;
+        }
+
+        if (target) {
+            if (value_length == 0 || memchr(value, ' ', value_length)) {
+                stream->malformed = true;
+                return;
+            }
+            char* copy = session_scratch(exchange, value_length + 1);
+            memcpy(copy, value, value_length);
+            copy[value_length] = '\0';
+            *target = copy;
+        }
+        return;
+    }
+
+    if (field_is(name, name_length, "content-length")) {
+        stream->has_length = true;
+        return;
+    }
+    if (field_is(name, name_length, "transfer-encoding") || field_is(name, name_length, "connection")) return;
+    if (field_is(name, name_length, "host")) {
+        stream->has_host = true;
+    }
+
+    size_t line_length = name_length + value_length + 4;
+    if (exchange->request_size + line_length + CONTENT_LENGTH_LINE_MAX >= REQUEST_MAX) {
+        stream->too_large = true;
+        return;
+    }
+
+    char* line = session_reserve_request(exchange, exchange->request_size + line_length) + exchange->request_size;
+    memcpy(line, name, name_length);
+    memcpy(line + name_length, ": ", 2);
+    memcpy(line + name_length + 2, value, value_length);
+    memcpy(line + name_length + 2 + value_length, "\r\n", 2);
+    exchange->request_size += line_length;
+}
+
+/**
+ * @brief Drops a decoded field.
+ * @param ctx Unused.
+ * @param name Unused.
+ * @param name_length Unused.
+ * @param value Unused.
+ * @param value_length Unused.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void skip_field(void* ctx, const char* name, size_t name_length, const char* value, size_t value_length) {
+}
+
+/**
+ * @brief Puts the request line in front of the header lines of a request, and ends its head.
+ * @details The authority becomes the Host header unless the request has one.
+ * @param stream The stream of the request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the head. Space complexity: O(n).
+ */
+static void write_request_head(http2_stream_t* stream) {
+    client_session_t* exchange = stream->exchange;
+    bool host = stream->authority && !stream->has_host;
+
+    size_t line_size = strlen(stream->method) + strlen(stream->path) + (host ? strlen(stream->authority) : 0) + 32;
+    char* line = session_scratch(exchange, line_size);
+    size_t line_length = snprintf(line, line_size, "%s %s HTTP/1.1\r\n%s%s%s", stream->method, stream->path,
+        host ? "host: " : "", host ? stream->authority : "", host ? "\r\n" : "");
+
+    if (exchange->request_size + line_length + CONTENT_LENGTH_LINE_MAX >= REQUEST_MAX) {
+        stream->too_large = true;
+    }
+
+    char* request = session_reserve_request(exchange, exchange->request_size + line_length + 2);
+    memmove(request + line_length, request, exchange->request_size);
+    memcpy(request, line, line_length);
+    exchange->request_size += line_length;
+
+    stream->head_length = exchange->request_size;
+    memcpy(request + exchange->request_size, "\r\n", 2);
+    exchange->request_size += 2;
+}
+
+/**
+ * @brief Handles a DATA frame.
+ * @details The body is appended to the request of its stream. Flow control counts whole frames, and both windows are opened again
+ * right away, since what a stream may buffer is bounded by REQUEST_MAX instead.
+ * @param connection The HTTP/2 connection.
+ * @param flags The flags of the frame.
+ * @param stream_id The stream of the frame.
+ * @param payload The payload of the frame.
+ * @param length The length of the payload.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the payload. Space complexity: O(n).
+ */
+static void receive_data(http2_connection_t* connection, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length) {
+    size_t counted = length;
+
+    if (flags & FLAG_PADDED) {
+        if (length < 1 || payload[0] >= length) {
+            connection_error(connection, H2_PROTOCOL_ERROR);
+            return;
+        }
+        length -= 1 + payload[0];
+        payload++;
+    }
+
+    if (stream_id == 0 || stream_id > connection->last_stream_id) {
+        connection_error(connection, H2_PROTOCOL_ERROR);
+        return;
+    }
+    if (counted > 0) {
+        queue_code(connection, FRAME_WINDOW_UPDATE, 0, counted);
+    }
+
+    // Data may still arrive for streams that were refused or reset.
+    http2_stream_t* stream = find_stream(connection, stream_id);
+    if (!stream || stream->state != STREAM_RECEIVING) return;
+
+    if (counted > 0 && !(flags & FLAG_END_STREAM)) {
+        queue_code(connection, FRAME_WINDOW_UPDATE, stream_id, counted);
+    }
+
+    client_session_t* exchange = stream->exchange;
+    stream->has_length = true;
+    if (exchange->request_size + length + CONTENT_LENGTH_LINE_MAX >= REQUEST_MAX) {
+        stream->too_large = true;
+    }
+    if (!stream->too_large) {
+        char* request = session_reserve_request(exchange, exchange->request_size + length);
+        memcpy(request + exchange->request_size, payload, length);
+        exchange->request_size += length;
+    }
+
+    if (flags & FLAG_END_STREAM) {
+        complete_request(stream);
+    }
+}
+
+/**
+ * @brief Handles a SETTINGS frame.
+ * @details Settings are acknowledged once applied. Acknowledgements of the server's settings need no action.
+ * @param connection The HTTP/2 connection.
+ * @param flags The flags of the frame.
+ * @param stream_id The stream of the frame, which must be 0.
+ * @param payload The payload of the frame.
+ * @param length The length of the payload.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of settings and streams. Space complexity: O(1).
+ */
+static void receive_settings(http2_connection_t* connection, uint8_t flags, uint32_t stream_id, const uint8_t* payload, size_t length) {
+    if (stream_id != 0) {
+        connection_error(connection, H2_PROTOCOL_ERROR);
+        return;
+    }
+    if ((flags & FLAG_ACK) ? length != 0 : length % 6 != 0) {
+        connection_error(connection, H2_FRAME_SIZE_ERROR);
+        return;
+    }
+    if ((flags & FLAG_ACK) || !count_control(connection)) return;
+
+    int error = apply_settings(connection, payload, length);
+    if (error) {
+        connection_error(connection, error);
+        return;
+    }
+    queue_frame(connection, FRAME_SETTINGS, FLAG_ACK, 0, NULL, 0);
+}
+
+/**
+ * @brief Applies the settings of the client.
+ * @details Only the settings that shape what the server sends matter: the initial window of streams, which also moves the windows of
+ * open streams, and the largest frame. The server never pushes and never indexes response headers, so the others are ignored.
+ * @param connection The HTTP/2 connection.
+ * @param payload The settings, 6 bytes each.
+ * @param length The length of the settings.
+ * @return Returns 0 on success, or the error code of the connection error an invalid value causes.
+ * @note Time complexity: O(n) where n is the number of settings and streams. Space complexity: O(1).
+ */
+static int apply_settings(http2_connection_t* connection, const uint8_t* payload, size_t length) {
+    for (size_t i = 0; i + 6 <= length; i += 6) {
+        uint16_t id = payload[i] << 8 | payload[i + 1];
+        uint32_t value = get_uint32(payload + i + 2);
+
+        if (id == SETTINGS_ENABLE_PUSH && value > 1) return H2_PROTOCOL_ERROR;
+
+        if (id == SETTINGS_INITIAL_WINDOW_SIZE) {
+            if (value > WINDOW_MAX) return H2_FLOW_CONTROL_ERROR;
+            for (http2_stream_t* stream = connection->streams; stream; stream = stream->next) {
+                stream->send_window += (int64_t)value - connection->initial_window;
+            }
+            connection->initial_window = value;
+        }
+
+        if (id == SETTINGS_MAX_FRAME_SIZE) {
+            if (value < FRAME_PAYLOAD_MAX || value > 0xffffff) return H2_PROTOCOL_ERROR;
+            connection->max_frame = value;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Handles a WINDOW_UPDATE frame.
+ * @details Updates for streams that already ended are ignored.
+ * @param connection The HTTP/2 connection.
+ * @param stream_id The stream of the frame, 0 for the connection.
+ * @param payload The payload of the frame.
+ * @param length The length of the payload.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of streams. Space complexity: O(1).
+ */
+static void receive_window_update(http2_connection_t* connection, uint32_t stream_id, const uint8_t* payload, size_t length) {
+    if (length != 4) {
+        connection_error(connection, H2_FRAME_SIZE_ERROR);
+        return;
+    }
+
+    uint32_t increment = get_uint32(payload) & 0x7fffffff;
+
+    if (stream_id == 0) {
+        if (increment == 0 || connection->send_window + increment > WINDOW_MAX) {
+            connection_error(connection, increment == 0 ? H2_PROTOCOL_ERROR : H2_FLOW_CONTROL_ERROR);
+            return;
+        }
+        connection->send_window += increment;
+        return;
+    }
+
+    http2_stream_t* stream = find_stream(connection, stream_id);
+    if (!stream) return;
+
+    if (increment == 0 || stream->send_window + increment > WINDOW_MAX) {
+        stream_error(stream, increment == 0 ? H2_PROTOCOL_ERROR : H2_FLOW_CONTROL_ERROR);
+        return;
+    }
+    stream->send_window += increment;
+}
+
+/**
+ * @brief Serves the complete request of a stream.
+ * @details The request gets a Content-Length header for its body, and is admitted like a request on its own connection would be, with
+ * the connection limit and request tokens of the connection's client. Its response is sent by http2_respond.
+ * @param stream The stream of the request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the request. Space complexity: O(n).
+ */
+static void complete_request(http2_stream_t* stream) {
+    client_session_t* exchange = stream->exchange;
+    TRACE_STAMP(exchange, TRACE_RECV);
+    stream->state = STREAM_SERVING;
+
+    if (stream->has_length && !stream->too_large) {
+        char line[CONTENT_LENGTH_LINE_MAX];
+        size_t line_length = snprintf(line, sizeof(line), "Content-Length: %zu\r\n", exchange->request_size - stream->head_length - 2);
+
+        char* request = session_reserve_request(exchange, exchange->request_size + line_length);
+        memmove(request + stream->head_length + line_length, request + stream->head_length, exchange->request_size - stream->head_length);
+        memcpy(request + stream->head_length, line, line_length);
+        exchange->request_size += line_length;
+    }
+
+    char* request = session_reserve_request(exchange, exchange->request_size + 1);
+    request[exchange->request_size] = '\0';
+
+    exchange->rejection = stream->too_large ? ENTITY_TOO_LARGE : admit_request(stream->connection->session, request);
+    serve_request(exchange);
+}
+
+/**
+ * @brief Starts sending the response of a stream.
+ * @details The handlers answer in HTTP/1.1, with a cached response or a header and a body, pinned value or file. The status line
+ * becomes the :status field and the other header lines become fields, minus those specific to an HTTP/1.1 connection. A response
+ * without a body ends the stream right away.
+ * @param stream The stream.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the response headers. Space complexity: O(n).
+ */
+static void start_response(http2_stream_t* stream) {
+    client_session_t* exchange = stream->exchange;
+    cached_response_t* cached = exchange->cached_response;
+
+    const char* head = cached ? cached->bytes : exchange->header;
+    size_t head_size = cached ? cached->length : (size_t)exchange->HSIZE;
+    const char* head_end = memmem(head, head_size, "\r\n\r\n", 4);
+    size_t head_length = head_end ? (size_t)(head_end - head) + 4 : head_size;
+
+    if (cached) {
+        stream->body = head + head_length;
+        stream->body_size = head_size - head_length;
+    } else if (exchange->body_chunking_enabled) {
+        stream->body = NULL;
+        stream->body_size = exchange->file_size;
+    } else {
+        stream->body = exchange->body_value ? exchange->body_value->data : exchange->body;
+        stream->body_size = exchange->BSIZE > 0 ? exchange->BSIZE : 0;
+    }
+
+    uint8_t* block = session_scratch(exchange, head_length * 2 + 16);
+    int status = head_length > sizeof("HTTP/1.1 ") ? atoi(head + sizeof("HTTP/1.1 ") - 1) : INTERNAL_SERVER_ERROR;
+    size_t block_length = hpack_encode_status(block, status);
+
+    const char* end = head + head_length;
+    const char* line = memchr(head, '\n', head_length);
+    for (line = line ? line + 1 : end; line < end; ) {
+        const char* line_end = memmem(line, end - line, "\r\n", 2);
+        if (!line_end || line_end == line) break;
+
+        const char* colon = memchr(line, ':', line_end - line);
+        size_t name_length = colon ? (size_t)(colon - line) : 0;
+        if (colon && !field_is(line, name_length, "connection") && !field_is(line, name_length, "transfer-encoding")) {
+            const char* value = colon + 1;
+            while (value < line_end && *value == ' ') value++;
+            block_length += hpack_encode_field(block + block_length, line, name_length, value, line_end - value);
+        }
+        line = line_end + 2;
+    }
+
+    exchange->log_record.status = status;
+    exchange->log_record.bytes = block_length;
+
+    queue_frame(stream->connection, FRAME_HEADERS, FLAG_END_HEADERS | (stream->body_size == 0 ? FLAG_END_STREAM : 0), stream->id,
+        block, block_length);
+
+    if (stream->body_size == 0) {
+        TRACE_STAMP(exchange, TRACE_SEND);
+        end_stream(stream);
+        return;
+    }
+
+    stream->state = STREAM_SENDING;
+    stream->body_sent = 0;
+}
+
+/**
+ * @brief Sends response bodies.
+ * @details Streams take turns sending a frame each, oldest first, so a large body does not hold up the others. Sending stops once
+ * FILE_CHUNK bytes went out, when the socket takes no more, or when every body is done or waiting for its window to open.
+ * @param connection The HTTP/2 connection.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of bytes sent. Space complexity: O(1).
+ */
+static void send_streams(http2_connection_t* connection) {
+    size_t budget = FILE_CHUNK;
+    bool progress = true;
+
+    while (progress && budget > 0 && !connection->failed) {
+        progress = false;
+
+        http2_stream_t* next;
+        for (http2_stream_t* stream = connection->streams; stream && budget > 0 && !connection->failed; stream = next) {
+            next = stream->next;
+
+            size_t length = sendable_length(stream);
+            if (length > budget) length = budget;
+            if (length == 0) continue;
+
+            send_data(stream, length);
+            budget -= length;
+            progress = true;
+
+            if (connection->output_length > 0) return;
+        }
+    }
+}
+
+/**
+ * @brief Sends a DATA frame of a response body.
+ * @details Bodies in memory are sent together with the queued frames in a single call. File bodies are sent with sendfile right after
+ * their frame header, so they never pass through user space, unless the socket is full, in which case the rest of the frame is read
+ * into the output. The last frame ends the stream.
+ * @param stream The stream.
+ * @param length The length of the frame, which the windows allow.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length. Space complexity: O(1).
+ */
+static void send_data(http2_stream_t* stream, size_t length) {
+    http2_connection_t* connection = stream->connection;
+    client_session_t* exchange = stream->exchange;
+    bool last = stream->body_sent + length == stream->body_size;
+
+    queue_header(connection, FRAME_DATA, last ? FLAG_END_STREAM : 0, stream->id, length);
+
+    if (stream->body) {
+        flush_output(connection, stream->body + stream->body_sent, length, 0);
+    } else {
+        flush_output(connection, NULL, 0, MSG_MORE);
+
+        off_t offset = exchange->file_offset + stream->body_sent;
+        size_t remaining = length;
+        while (remaining > 0 && !connection->failed && connection->output_length == 0) {
+            ssize_t sent = sendfile(connection->session->fd, exchange->file_fd, &offset, remaining);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent < 0 && errno == EAGAIN) break;
+            if (sent <= 0) {
+                connection->failed = true;
+                break;
+            }
+            remaining -= sent;
+        }
+        if (remaining > 0 && !connection->failed) {
+            queue_file(connection, exchange->file_fd, offset, remaining);
+        }
+    }
+
+    PROBE_CHUNK_SENT(exchange, connection->session->fd, length, stream->body_sent);
+    stream->body_sent += length;
+    stream->send_window -= length;
+    connection->send_window -= length;
+    exchange->log_record.bytes += length;
+
+    if (last) {
+        TRACE_STAMP(exchange, TRACE_SEND);
+        end_stream(stream);
+    }
+}
+
+/**
+ * @brief Gets how much of a response body may be sent in the next frame.
+ * @param stream The stream.
+ * @return Returns the length of the next frame, or 0 if the stream has nothing to send or its windows are closed.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static size_t sendable_length(const http2_stream_t* stream) {
+    const http2_connection_t* connection = stream->connection;
+
+    // After an upgrade, bodies wait for the client preface, so the client reads the 101 response before a flood of frames.
+    if (stream->state != STREAM_SENDING || connection->preface_remaining) return 0;
+
+    int64_t length = stream->body_size - stream->body_sent;
+    if (length > stream->send_window) length = stream->send_window;
+    if (length > connection->send_window) length = connection->send_window;
+    if (length > connection->max_frame) length = connection->max_frame;
+
+    return length > 0 ? length : 0;
+}
+
+/**
+ * @brief Opens a stream.
+ * @details The stream is taken from the stream cache, or allocated, and gets an exchange session of its own.
+ * @param connection The HTTP/2 connection.
+ * @param id The id of the stream.
+ * @return Returns the stream.
+ * @note Time complexity: O(n) where n is the number of open streams. Space complexity: O(1).
+ */
+static http2_stream_t* open_stream(http2_connection_t* connection, uint32_t id) {
+    http2_stream_t* stream;
+
+    if (stream_cache) {
+        stream = stream_cache;
+        stream_cache = stream->next;
+        stream_cache_count--;
+    } else {
+        stream = Malloc(sizeof(http2_stream_t));
+    }
+
+    memset(stream, 0, sizeof(http2_stream_t));
+    stream->connection = connection;
+    stream->id = id;
+    stream->state = STREAM_RECEIVING;
+    stream->send_window = connection->initial_window;
+
+    stream->exchange = session_create(-1, connection->session->epfd);
+    stream->exchange->stream = stream;
+    access_log_start(&stream->exchange->log_record);
+    TRACE_START(stream->exchange);
+
+    http2_stream_t** link = &connection->streams;
+    while (*link) {
+        link = &(*link)->next;
+    }
+    *link = stream;
+    connection->stream_count++;
+    connection->last_stream_id = id;
+
+    return stream;
+}
+
+/**
+ * @brief Finds an open stream.
+ * @param connection The HTTP/2 connection.
+ * @param id The id of the stream.
+ * @return Returns the stream, or NULL if no open stream has the id.
+ * @note Time complexity: O(n) where n is the number of open streams. Space complexity: O(1).
+ */
+static http2_stream_t* find_stream(http2_connection_t* connection, uint32_t id) {
+    for (http2_stream_t* stream = connection->streams; stream; stream = stream->next) {
+        if (stream->id == id) return stream;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Resets a stream because of an error.
+ * @param stream The stream.
+ * @param code The error code sent to the client.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of open streams. Space complexity: O(1).
+ */
+static void stream_error(http2_stream_t* stream, uint32_t code) {
+    queue_code(stream->connection, FRAME_RST_STREAM, stream->id, code);
+    reset_stream(stream);
+}
+
+/**
+ * @brief Ends a stream that was reset.
+ * @details A stream waiting for the write-ahead log is on the list of pending responses, so it only ends once it has been answered.
+ * @param stream The stream.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of open streams. Space complexity: O(1).
+ */
+static void reset_stream(http2_stream_t* stream) {
+    if (stream->state == STREAM_SERVING) {
+        stream->reset = true;
+    } else {
+        end_stream(stream);
+    }
+}
+
+/**
+ * @brief Ends a stream.
+ * @details This function closes the file of a file response, destroys the exchange, which logs the request, and keeps the stream for reuse.
+ * @param stream The stream.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of open streams. Space complexity: O(1).
+ */
+static void end_stream(http2_stream_t* stream) {
+    http2_connection_t* connection = stream->connection;
+
+    http2_stream_t** link = &connection->streams;
+    while (*link != stream) {
+        link = &(*link)->next;
+    }
+    *link = stream->next;
+    connection->stream_count--;
+
+    client_session_t* exchange = stream->exchange;
+    if (exchange->body_chunking_enabled) {
+        session_close_file(exchange);
+    }
+    exchange->stream = NULL;
+    session_destroy(exchange);
+
+    if (stream_cache_count >= STREAM_CACHE_MAX) {
+        free(stream);
+        return;
+    }
+    stream->next = stream_cache;
+    stream_cache = stream;
+    stream_cache_count++;
+}
+
+/**
+ * @brief Fails the connection because of an error.
+ * @details A GOAWAY frame tells the client which streams were seen and why the connection closes.
+ * @param connection The HTTP/2 connection.
+ * @param code The error code sent to the client.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void connection_error(http2_connection_t* connection, uint32_t code) {
+    uint8_t payload[8];
+    put_uint32(payload, connection->last_stream_id);
+    put_uint32(payload + 4, code);
+
+    queue_frame(connection, FRAME_GOAWAY, 0, 0, payload, sizeof(payload));
+    flush_output(connection, NULL, 0, 0);
+    connection->failed = true;
+}
+
+/**
+ * @brief Sends what is ready to be sent, and closes the connection once it is done.
+ * @details A connection is done when it failed, or when the client sent GOAWAY and all its streams have been answered.
+ * @param connection The HTTP/2 connection.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of bytes sent. Space complexity: O(1).
+ */
+static void finish_io(http2_connection_t* connection) {
+    if (!connection->closed) {
+        send_streams(connection);
+        flush_output(connection, NULL, 0, 0);
+
+        if (connection->goaway && connection->stream_count == 0) {
+            connection->failed = true;
+        }
+
+        if (connection->failed) {
+            close_connection(connection);
+        } else {
+            update_interest(connection);
+        }
+    }
+
+    if (connection->closed && connection->stream_count == 0) {
+        release_connection(connection);
+    }
+}
+
+/**
+ * @brief Monitors the connection for writing while output waits or a response body can be sent.
+ * @details Connections are monitored for reading, since window updates and new streams may arrive at any time, except while the
+ * output is beyond HTTP2_OUTPUT_MAX bytes.
+ * @param connection The HTTP/2 connection.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of open streams. Space complexity: O(1).
+ */
+static void update_interest(http2_connection_t* connection) {
+    uint32_t events = connection->output_length < HTTP2_OUTPUT_MAX ? EPOLLIN : 0;
+    if (connection->output_length > 0) {
+        events |= EPOLLOUT;
+    }
+    for (http2_stream_t* stream = connection->streams; stream && !(events & EPOLLOUT); stream = stream->next) {
+        if (sendable_length(stream) > 0) {
+            events |= EPOLLOUT;
+        }
+    }
+    if (events == connection->events) return;
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.ptr = connection->session;
+
+    Epoll_ctl(connection->session->epfd, EPOLL_CTL_MOD, connection->session->fd, &event);
+    connection->events = events;
+}
+
+/**
+ * @brief Closes a connection.
+ * @details Every stream ends, except those waiting for the write-ahead log. Until they have been answered too, the connection is only
+ * no longer monitored.
+ * @param connection The HTTP/2 connection.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of open streams. Space complexity: O(1).
+ */
+static void close_connection(http2_connection_t* connection) {
+    http2_stream_t* next;
+    for (http2_stream_t* stream = connection->streams; stream; stream = next) {
+        next = stream->next;
+        if (stream->state != STREAM_SERVING) {
+            end_stream(stream);
+        }
+    }
+
+    Epoll_ctl(connection->session->epfd, EPOLL_CTL_DEL, connection->session->fd, NULL);
+    connection->closed = true;
+}
+
+/**
+ * @brief Frees the HTTP/2 state of a closed connection and destroys its session.
+ * @param connection The HTTP/2 connection, without open streams.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of dynamic table entries. Space complexity: O(1).
+ */
+static void release_connection(http2_connection_t* connection) {
+    client_session_t* session = connection->session;
+
+    hpack_table_free(&connection->decoder);
+    buffer_release(connection->input, connection->input_capacity);
+    buffer_release(connection->output, connection->output_capacity);
+    buffer_release(connection->block, connection->block_capacity);
+    free(connection);
+
+    session->http2 = NULL;
+    session_destroy(session);
+}
+
+/**
+ * @brief Queues a frame header, the payload of which is sent separately.
+ * @param connection The HTTP/2 connection.
+ * @param type The type of the frame.
+ * @param flags The flags of the frame.
+ * @param stream_id The stream of the frame, 0 for the connection.
+ * @param length The length of the payload.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1) amortized. Space complexity: O(1).
+ */
+static void queue_header(http2_connection_t* connection, uint8_t type, uint8_t flags, uint32_t stream_id, size_t length) {
+    size_t needed = connection->output_length + FRAME_HEADER_SIZE;
+    if (needed > connection->output_capacity) {
+        connection->output = buffer_grow(connection->output, connection->output_length, needed, &connection->output_capacity);
+    }
+
+    uint8_t* header = (uint8_t*)connection->output + connection->output_length;
+    header[0] = length >> 16;
+    header[1] = length >> 8;
+    header[2] = length;
+    header[3] = type;
+    header[4] = flags;
+    put_uint32(header + 5, stream_id);
+    connection->output_length = needed;
+}
+
+/**
+ * @brief Queues a frame.
+ * @details Queued frames are sent together with the next DATA frame, or at the end of the event.
+ * @param connection The HTTP/2 connection.
+ * @param type The type of the frame.
+ * @param flags The flags of the frame.
+ * @param stream_id The stream of the frame, 0 for the connection.
+ * @param payload The payload of the frame.
+ * @param length The length of the payload.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) amortized where n is the length of the payload. Space complexity: O(n).
+ */
+static void queue_frame(http2_connection_t* connection, uint8_t type, uint8_t flags, uint32_t stream_id, const void* payload, size_t length) {
+    size_t needed = connection->output_length + FRAME_HEADER_SIZE + length;
+    if (needed > connection->output_capacity) {
+        connection->output = buffer_grow(connection->output, connection->output_length, needed, &connection->output_capacity);
+    }
+
+    queue_header(connection, type, flags, stream_id, length);
+    queue_bytes(connection, payload, length);
+}
+
+/**
+ * @brief Queues a frame whose payload is a single 32-bit value, an error code or a window increment.
+ * @param connection The HTTP/2 connection.
+ * @param type The type of the frame.
+ * @param stream_id The stream of the frame, 0 for the connection.
+ * @param code The value.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1) amortized. Space complexity: O(1).
+ */
+static void queue_code(http2_connection_t* connection, uint8_t type, uint32_t stream_id, uint32_t code) {
+    uint8_t payload[4];
+    put_uint32(payload, code);
+    queue_frame(connection, type, 0, stream_id, payload, sizeof(payload));
+}
+
+/**
+ * @brief Queues bytes after the queued frames.
+ * @param connection The HTTP/2 connection.
+ * @param data The bytes.
+ * @param length The number of bytes.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) amortized where n is the number of bytes. Space complexity: O(n).
+ */
+static void queue_bytes(http2_connection_t* connection, const void* data, size_t length) {
+    if (length == 0) return;
+
+    size_t needed = connection->output_length + length;
+    if (needed > connection->output_capacity) {
+        connection->output = buffer_grow(connection->output, connection->output_length, needed, &connection->output_capacity);
+    }
+    memcpy(connection->output + connection->output_length, data, length);
+    connection->output_length = needed;
+}
+
+/**
+ * @brief Queues part of a file after the queued frames.
+ * @details If the file cannot be read, the connection is failed, since the frame header of the part has been queued already.
+ * @param connection The HTTP/2 connection.
+ * @param fd The file.
+ * @param offset The offset of the part.
+ * @param length The length of the part.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length. Space complexity: O(n).
+ */
+static void queue_file(http2_connection_t* connection, int fd, off_t offset, size_t length) {
+    size_t needed = connection->output_length + length;
+    if (needed > connection->output_capacity) {
+        connection->output = buffer_grow(connection->output, connection->output_length, needed, &connection->output_capacity);
+    }
+
+    while (connection->output_length < needed) {
+        ssize_t bytes_read = pread(fd, connection->output + connection->output_length, needed - connection->output_length, offset);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        if (bytes_read <= 0) {
+            connection->failed = true;
+            return;
+        }
+        connection->output_length += bytes_read;
+        offset += bytes_read;
+    }
+}
+
+/**
+ * @brief Counts a PING, SETTINGS or RST_STREAM frame of the client.
+ * @details A client that keeps sending such frames without reading what the server sends back is flooding the connection, which is
+ * then failed with ENHANCE_YOUR_CALM.
+ * @param connection The HTTP/2 connection.
+ * @return Returns true if the frame is handled, or false if the connection was failed.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static bool count_control(http2_connection_t* connection) {
+    if (++connection->control_frames <= HTTP2_CONTROL_MAX) return true;
+
+    connection_error(connection, H2_ENHANCE_YOUR_CALM);
+    return false;
+}
+
+/**
+ * @brief Sends the queued frames, followed by a payload.
+ * @details The socket is non-blocking, so sending stops once it takes no more. What it did not take, the rest of the payload included,
+ * stays queued until the connection is writable again. If sending fails, the connection is failed and nothing more is sent over it.
+ * @param connection The HTTP/2 connection.
+ * @param payload Bytes to send after the queued frames, or NULL.
+ * @param length The length of the payload.
+ * @param flags Flags of the send, MSG_MORE when more follows right away.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of bytes sent or queued. Space complexity: O(n).
+ */
+static void flush_output(http2_connection_t* connection, const char* payload, size_t length, int flags) {
+    size_t queued = connection->output_length;
+    size_t sent = 0;
+
+    while (sent < queued + length && !connection->failed) {
+        struct iovec iov[2];
+        int count = 0;
+        if (sent < queued) {
+            iov[count++] = (struct iovec){ .iov_base = connection->output + sent, .iov_len = queued - sent };
+        }
+        if (length > 0) {
+            size_t payload_sent = sent > queued ? sent - queued : 0;
+            iov[count++] = (struct iovec){ .iov_base = (void*)(payload + payload_sent), .iov_len = length - payload_sent };
+        }
+
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = iov;
+        message.msg_iovlen = count;
+
+        ssize_t result = sendmsg(connection->session->fd, &message, MSG_NOSIGNAL | flags);
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0 && errno == EAGAIN) break;
+        if (result < 0) {
+            connection->failed = true;
+            break;
+        }
+        sent += result;
+    }
+
+    if (connection->failed) {
+        connection->output_length = 0;
+        return;
+    }
+
+    size_t queued_sent = sent < queued ? sent : queued;
+    connection->output_length = queued - queued_sent;
+    memmove(connection->output, connection->output + queued_sent, connection->output_length);
+    if (sent - queued_sent < length) {
+        queue_bytes(connection, payload + (sent - queued_sent), length - (sent - queued_sent));
+    }
+
+    if (connection->output_length == 0) {
+        connection->control_frames = 0;
+    }
+}
+
+/**
+ * @brief Finds a header of an HTTP/1.1 request, ignoring the case of its name.
+ * @param request The request.
+ * @param name The name of the header.
+ * @return Returns a pointer to the value of the header, or NULL if the request does not have it.
+ * @note Time complexity: O(n) where n is the length of the request head. Space complexity: O(1).
+ */
+static const char* find_header(const char* request, const char* name) {
+    size_t name_length = strlen(name);
+    const char* head_end = strstr(request, "\r\n\r\n");
+
+    for (const char* line = strstr(request, "\r\n"); line && line < head_end; line = strstr(line + 2, "\r\n")) {
+        const char* field = line + 2;
+        if (strncasecmp(field, name, name_length) == 0 && field[name_length] == ':') {
+            const char* value = field + name_length + 1;
+            while (*value == ' ') value++;
+            return value;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Compares a field name, ignoring case.
+ * @param name The name.
+ * @param name_length The length of the name.
+ * @param expected The expected name in lowercase.
+ * @return Returns true if the names are equal, false otherwise.
+ * @note Time complexity: O(n) where n is the length of the name. Space complexity: O(1).
+ */
+static bool field_is(const char* name, size_t name_length, const char* expected) {
+    return strlen(expected) == name_length && strncasecmp(name, expected, name_length) == 0;
+}
+
+/**
+ * @brief Checks whether a field name or value can be written as part of a header line.
+ * @param text The name or value.
+ * @param length The length of the text.
+ * @param name Whether the text is a name, which may contain neither colons, apart from a leading one, nor spaces.
+ * @return Returns true if the text is safe, false otherwise.
+ * @note Time complexity: O(n) where n is the length of the text. Space complexity: O(1).
+ */
+static bool field_safe(const char* text, size_t length, bool name) {
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] == '\r' || text[i] == '\n' || text[i] == '\0') return false;
+        if (name && (text[i] == ' ' || (text[i] == ':' && i > 0))) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Decodes base64url, the encoding of the HTTP2-Settings header.
+ * @param text The encoded text, with or without padding.
+ * @param length The length of the text.
+ * @param out Output for the decoded bytes, at least 3/4 of the length.
+ * @return Returns the number of decoded bytes, or -1 if the text is not base64url.
+ * @note Time complexity: O(n) where n is the length of the text. Space complexity: O(1).
+ */
+static ssize_t base64url_decode(const char* text, size_t length, uint8_t* out) {
+    uint32_t bits = 0;
+    int count = 0;
+    size_t used = 0;
+
+    for (size_t i = 0; i < length && text[i] != '='; i++) {
+        char c = text[i];
+        uint32_t value;
+
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '-') value = 62;
+        else if (c == '_') value = 63;
+        else return -1;
+
+        bits = bits << 6 | value;
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out[used++] = bits >> count;
+        }
+    }
+    return used;
+}
+
+/**
+ * @brief Reads a 32-bit value in network byte order.
+ * @param in The bytes.
+ * @return Returns the value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint32_t get_uint32(const uint8_t* in) {
+    return (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+}
+
+/**
+ * @brief Writes a 32-bit value in network byte order.
+ * @param out The output.
+ * @param value The value.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void put_uint32(uint8_t* out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
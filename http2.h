@@ -0,0 +1,22 @@
+#ifndef HTTP2_H
+#define HTTP2_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "client_session.h"
+
+/// @file http2.h
+/// @brief Contains function declarations for serving HTTP/2 over cleartext connections (h2c).
+/// @details A connection switches to HTTP/2 when it starts with the client connection preface, or when its first request asks to
+/// upgrade to h2c. From then on it stays open, and every stream is served by a session of its own, the exchange, which holds the
+/// request as HTTP/1.1 text, so the handlers, the response cache and the write-ahead log serve streams unchanged. The responses of
+/// all streams are sent frame by frame, taking turns, within the flow control windows the client grants.
+
+bool http2_preface(const char* data, size_t length);
+void http2_start(client_session_t* client_info, size_t length);
+bool http2_upgrade(client_session_t* client_info);
+void http2_process(client_session_t* client_info, uint32_t events);
+void http2_respond(client_session_t* exchange);
+
+#endif
@@ -15,7 +15,7 @@
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 static void bad_request(client_session_t* client_info) {
-    client_info->HSIZE = snprintf(client_info->header, HMAX,
+    session_set_header(client_info,
         "HTTP/1.1 400 Bad Request\r\n"
         "\r\n"
     );
@@ -30,7 +30,7 @@ static void bad_request(client_session_t* client_info) {
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 static void request_entity_too_large(client_session_t* client_info) {
-    client_info->HSIZE = snprintf(client_info->header, HMAX, 
+    session_set_header(client_info,
         "HTTP/1.1 413 Request Entity Too Large\r\n"
         "\r\n"
     );
@@ -45,13 +45,75 @@ static void request_entity_too_large(client_session_t* client_info) {
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 static void request_not_found(client_session_t* client_info) {
-    client_info->HSIZE = snprintf(client_info->header, HMAX, 
+    session_set_header(client_info,
         "HTTP/1.1 404 Not Found\r\n"
         "\r\n"
     );
     client_info->BSIZE = 0;
 }
 
+/**
+ * @brief Generates a 507 Insufficient Storage response.
+ * @details This function sets the HTTP response header to indicate that a value could not be stored within the storage budget.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void insufficient_storage(client_session_t* client_info) {
+    session_set_header(client_info,
+        "HTTP/1.1 507 Insufficient Storage\r\n"
+        "\r\n"
+    );
+    client_info->BSIZE = 0;
+}
+
+/**
+ * @brief Generates a 403 Forbidden response.
+ * @details This function sets the HTTP response header to indicate that the local peer does not run as the allowed user.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void forbidden(client_session_t* client_info) {
+    session_set_header(client_info,
+        "HTTP/1.1 403 Forbidden\r\n"
+        "\r\n"
+    );
+    client_info->BSIZE = 0;
+}
+
+/**
+ * @brief Generates a 429 Too Many Requests response.
+ * @details This function sets the HTTP response header to indicate that the client has run out of request tokens.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void too_many_requests(client_session_t* client_info) {
+    session_set_header(client_info,
+        "HTTP/1.1 429 Too Many Requests\r\n"
+        "Retry-After: 1\r\n"
+        "\r\n"
+    );
+    client_info->BSIZE = 0;
+}
+
+/**
+ * @brief Generates a 503 Service Unavailable response.
+ * @details This function sets the HTTP response header to indicate that the client has too many open connections or that the
+ * server is overloaded.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void service_unavailable(client_session_t* client_info) {
+    session_set_header(client_info,
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "\r\n"
+    );
+    client_info->BSIZE = 0;
+}
+
 /**
  * @brief Raises an HTTP error response.
  * @details This function generates an HTTP error response based on the provided error code. It sets the appropriate response header and body for the error.
@@ -65,14 +127,26 @@ void raise_http_error(int error_code, client_session_t* client_info) {
         case BAD_REQUEST:
             bad_request(client_info);
             break;
+        case FORBIDDEN:
+            forbidden(client_info);
+            break;
         case ENTITY_TOO_LARGE:
             request_entity_too_large(client_info);
             break;
         case NOT_FOUND:
             request_not_found(client_info);
             break;
+        case INSUFFICIENT_STORAGE:
+            insufficient_storage(client_info);
+            break;
+        case TOO_MANY_REQUESTS:
+            too_many_requests(client_info);
+            break;
+        case SERVICE_UNAVAILABLE:
+            service_unavailable(client_info);
+            break;
         default:
-            client_info->HSIZE = snprintf(client_info->header, HMAX,
+            session_set_header(client_info,
                 "HTTP/1.1 500 Internal Server Error \r\n"
                 "Content-Length: 0\r\n"
                 "\r\n"
@@ -17,49 +17,87 @@
 #include "http_parser.h"
 #include "storage.h"
 #include "network_utils.h"
+#include "buffer_pool.h"
+#include "response_cache.h"
+#include "router.h"
+#include "wal.h"
+#include "rate_limit.h"
+#include "overload.h"
+#include "capture.h"
+#include "asset_pack.h"
+#include "open_files.h"
+#include "probes.h"
 #include "http_method_handler.h"
 
 
-storage_t* server_storage = NULL;
-
-static void handle_ping(client_session_t* client_info);
-static void handle_echo(client_session_t* client_info);
-static void handle_read(client_session_t* client_info);
-static void handle_write(client_session_t* client_info);
+static void handle_ping(const char* path, client_session_t* client_info);
+static void handle_echo(const char* path, client_session_t* client_info);
+static void handle_read(const char* path, client_session_t* client_info);
+static void handle_stats(const char* path, client_session_t* client_info);
+static void handle_trace(const char* path, client_session_t* client_info);
+static void handle_write(const char* path, client_session_t* client_info);
+static void handle_batch(const char* path, client_session_t* client_info);
+static void handle_mget(const char* path, client_session_t* client_info);
+static void handle_chunked_write(client_session_t* client_info);
+static void append_upload(void* ctx, const char* data, size_t length);
 static void handle_common_get(const char* path, client_session_t* client_info);
+static bool serve_packed(const char* path, client_session_t* client_info);
+static bool serve_shared(const char* path, uint64_t version, client_session_t* client_info);
 static void set_header(size_t content_length, client_session_t* client_info);
+static void set_body_value(storage_t* storage, client_session_t* client_info);
+static bool valid_key(const char* key);
+static void persist_write(const char* key, storage_t* storage, client_session_t* client_info);
+static int refused_write_status();
+static bool serve_cached(const char* key, uint64_t version, client_session_t* client_info);
+static void cache_response(const char* key, uint64_t version, client_session_t* client_info);
+static uint64_t file_version(const struct stat* file_stat);
+
+// The route table generated from routes.def, referring to the handlers above.
+#include "routes_gen.h"
 
 /**
- * @brief Handles GET requests.
- * @details This function routes the GET request to the appropriate handler based on the requested path.
+ * @brief Dispatches a request to its handler.
+ * @details This function looks the method and the first path segment up in the generated route table with a single hash lookup.
+ * An exact route matches when nothing follows the segment, a prefix route when a non-empty remainder follows it. GET requests
+ * that match no route are served from the filesystem, any other request is answered with 400.
+ * @param method The HTTP method.
  * @param path The requested path.
  * @param client_info Pointer to the client session information.
  * @return This function does not return a value.
- * @note Time complexity: O(1) for each path comparison. Space complexity: O(1).
+ * @note Time complexity: O(n) where n is the length of the method and first path segment. Space complexity: O(1).
  */
-void handle_get(const char* path, client_session_t* client_info) {
-    if (strcmp(path, "/ping") == 0) {
-        handle_ping(client_info);
-    } else if (strcmp(path, "/echo") == 0) {
-        handle_echo(client_info);
-    } else if (strcmp(path, "/read") == 0) {
-        handle_read(client_info);
-    } else {
-        handle_common_get(path, client_info);
+void handle_request(const char* method, const char* path, client_session_t* client_info) {
+    route_handler_t handler = NULL;
+    const char* argument = NULL;
+
+    if (path[0] == '/') {
+        const char* segment_end = strchr(path + 1, '/');
+        size_t segment_length = segment_end ? (size_t)(segment_end - path) : strlen(path);
+
+        uint32_t slot = route_hash(method, path, segment_length, ROUTE_HASH_SEED) & (ROUTE_TABLE_SIZE - 1);
+        const route_t* route = &route_table[slot];
+
+        if (route->method && route->segment_length == segment_length && strcmp(route->method, method) == 0
+            && memcmp(route->segment, path, segment_length) == 0) {
+            const char* rest = path + segment_length;
+
+            if (rest[0] == '\0' && route->exact) {
+                handler = route->exact;
+                argument = rest;
+            } else if (rest[0] == '/' && rest[1] != '\0' && route->prefix) {
+                handler = route->prefix;
+                argument = rest + 1;
+            }
+        }
     }
-}
 
-/**
- * @brief Handles POST requests.
- * @details This function routes the POST request to the appropriate handler based on the requested path.
- * @param path The requested path.
- * @param client_info Pointer to the client session information.
- * @return This function does not return a value.
- * @note Time complexity: O(1) for each path comparison. Space complexity: O(1).
- */
-void handle_post(const char* path, client_session_t* client_info) {
-    if (strcmp(path, "/write") == 0) {
-        handle_write(client_info);
+    TRACE_STAMP(client_info, TRACE_ROUTE);
+    PROBE_ROUTE_CHOSEN(client_info, path, handler != NULL);
+
+    if (handler) {
+        handler(argument, client_info);
+    } else if (strcmp(method, "GET") == 0) {
+        handle_common_get(path, client_info);
     } else {
         raise_http_error(BAD_REQUEST, client_info);
     }
@@ -72,28 +110,35 @@ void handle_post(const char* path, client_session_t* client_info) {
  * @return This function does not return a value.
  * @note Time complexity: O(1). Space complexity: O(1).
  */
-static void handle_ping(client_session_t* client_info) {
+static void handle_ping(const char* path, client_session_t* client_info) {
+    // The /ping response never changes.
+    if (serve_cached("/ping", 0, client_info)) return;
+
     // Setting header for /ping.
-    client_info->HSIZE = snprintf(client_info->header, HMAX,
+    session_set_header(client_info,
         "HTTP/1.1 200 OK\r\n"
         "Content-Length: 4\r\n"
         "\r\n"
     );
 
     // Setting body for /ping
-    client_info->BSIZE = snprintf(client_info->body, BMAX + 1, "pong");
+    client_info->BSIZE = snprintf(session_reserve_body(client_info, 5), 5, "pong");
+
+    cache_response("/ping", 0, client_info);
 }
 
 /**
  * @brief Handles the /echo request.
- * @details This function parses the headers and sets the appropriate response for the /echo request.
+ * @details This function parses the headers straight into the body buffer and sets the appropriate response for the /echo request.
+ * The headers are only bounded by the request, which holds at most REQUEST_MAX bytes.
  * @param client_info Pointer to the client session information.
  * @return This function does not return a value.
- * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(1).
+ * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(n).
  */
-static void handle_echo(client_session_t* client_info) {
-    char header_recieved[HMAX];
-    int status = parse_headers(client_info->request, header_recieved, HMAX);
+static void handle_echo(const char* path, client_session_t* client_info) {
+    size_t headers_size = client_info->request_size + 1;
+    char* header_recieved = session_reserve_body(client_info, headers_size);
+    int status = parse_headers(client_info->request, header_recieved, headers_size);
 
     if (status == -1) {
         raise_http_error(BAD_REQUEST, client_info);
@@ -105,128 +150,478 @@ static void handle_echo(client_session_t* client_info) {
         return;
     }
 
+    size_t header_length = strlen(header_recieved);
+
     // Setting header to send
-    client_info->HSIZE = snprintf(client_info->header, HMAX, 
+    session_set_header(client_info,
         "HTTP/1.1 200 OK\r\n"
         "Content-Length: %zu\r\n\r\n",
-        (size_t)strlen(header_recieved)
+        header_length
     );
 
-    // Setting body to send
-    client_info->BSIZE = snprintf(client_info->body, BMAX + 1, "%s", header_recieved);
+    client_info->BSIZE = header_length;
 }
 
 /**
- * @brief Handles the /write request.
- * @details This function writes data to the storage and sets the appropriate response for the /write request.
+ * @brief Handles the /write and /write/<key> requests.
+ * @details This function writes data to the storage and sets the appropriate response for the /write request. The value is stored straight
+ * out of the request, so a body is only bounded by the request, which has to fit into REQUEST_MAX bytes. Bytes beyond the Content-Length
+ * are ignored. The response echoes the stored value without copying it again.
+ * @param path The key of the value to write, or "" for the default value.
  * @param client_info Pointer to the client session information.
  * @return This function does not return a value.
  * @note Time complexity: O(n) where n is the size of the data written. Space complexity: O(1).
  */
-static void handle_write(client_session_t* client_info) {
-    int content_length = extract_content_length(client_info->request);
+static void handle_write(const char* path, client_session_t* client_info) {
+    if (!valid_key(path)) {
+        raise_http_error(BAD_REQUEST, client_info);
+        return;
+    }
 
-    size_t to_store_len = content_length;
+    // Transfer-Encoding takes precedence over Content-Length.
+    if (is_chunked_transfer(client_info->request)) {
+        client_info->upload_key = path;
+        handle_chunked_write(client_info);
+        return;
+    }
+
+    int content_length = extract_content_length(client_info->request);
     if (content_length < 0) {
         raise_http_error(BAD_REQUEST, client_info);
         return;
     }
 
-    if (content_length > BMAX) {
+    const char* body = strstr(client_info->request, "\r\n\r\n") + 4;
+    size_t head_length = body - client_info->request;
+    if ((size_t)content_length >= REQUEST_MAX - head_length) {
         raise_http_error(ENTITY_TOO_LARGE, client_info);
         return;
     }
 
-    char body_recieved[BMAX + 1];
-    int body_length = parse_body(client_info->request, client_info->request_size, body_recieved, BMAX);
+    // The client closed its side of the connection before the body was complete.
+    if (client_info->request_size - head_length < (size_t)content_length) {
+        raise_http_error(BAD_REQUEST, client_info);
+        return;
+    }
+
+    storage_t* storage = storage_lookup(path, true);
+    if (!storage) {
+        raise_http_error(refused_write_status(), client_info);
+        return;
+    }
+
+    if (storage_save(storage, body, content_length) < 0) {
+        raise_http_error(ENTITY_TOO_LARGE, client_info);
+        return;
+    }
+    persist_write(path, storage, client_info);
+
+    session_set_header(client_info,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Length: %u\r\n"
+        "\r\n",
+        content_length
+    );
+
+    set_body_value(storage, client_info);
+}
+
+/**
+ * @brief Handles the /batch request.
+ * @details This function stores a list of key/value pairs sent in one body, framed as "<key length> <value length>\n<key><value>" per pair.
+ * The whole batch is validated before anything is stored, so a malformed batch changes nothing. The response holds one status code per
+ * pair, in order: 200 if the value was stored, 507 if its key was not admitted. A batch of more than BATCH_PAIRS_MAX pairs is answered
+ * with 413.
+ * @param path Unused.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the batch. Space complexity: O(m) where m is the number of pairs.
+ */
+static void handle_batch(const char* path, client_session_t* client_info) {
+    int content_length = extract_content_length(client_info->request);
+    if (content_length < 0) {
+        raise_http_error(BAD_REQUEST, client_info);
+        return;
+    }
+
+    if (content_length > BATCH_MAX) {
+        raise_http_error(ENTITY_TOO_LARGE, client_info);
+        return;
+    }
 
-    // Means error in parsing body
-    if (body_length < content_length) {
+    const char* body = strstr(client_info->request, "\r\n\r\n") + 4;
+    size_t body_length = client_info->request_size - (body - client_info->request);
+    if (body_length < (size_t)content_length) {
+        raise_http_error(BAD_REQUEST, client_info);
+        return;
+    }
+    body_length = content_length;
 
-        if (body_length == -1) {
+    batch_frame_t frame;
+    size_t pairs = 0;
+    for (size_t offset = 0; offset < body_length; pairs++) {
+        ssize_t used = parse_batch_frame(body + offset, body_length - offset, KEY_MAX, BMAX, &frame);
+        if (used < 0 || memchr(frame.key, '/', frame.key_length)) {
             raise_http_error(BAD_REQUEST, client_info);
             return;
         }
+        if (pairs == BATCH_PAIRS_MAX) {
+            raise_http_error(ENTITY_TOO_LARGE, client_info);
+            return;
+        }
+        offset += used;
+    }
 
-        if (body_length == -2) {
-            if (!server_storage) {
-                server_storage = storage_init();
-            }
-            parse_body_upto(client_info->request, body_recieved, to_store_len);
-            
-            if (storage_save(server_storage, body_recieved, content_length) < 0) {
-                raise_http_error(ENTITY_TOO_LARGE, client_info);
-                return;
-            }
+    // Every status code takes four bytes, "200\n" or "507\n".
+    char* statuses = session_reserve_body(client_info, pairs * 4 + 1);
+    size_t statuses_length = 0;
+    char key[KEY_MAX + 1];
 
-            client_info->HSIZE = snprintf(client_info->header, HMAX,
-                "HTTP/1.1 200 OK\r\n"
-                "Content-Length: %u\r\n"
-                "\r\n",
-                content_length
-            );
-   
-            client_info->BSIZE = storage_read(server_storage, client_info->body, BMAX);
-            return;
+    for (size_t offset = 0; offset < body_length; ) {
+        offset += parse_batch_frame(body + offset, body_length - offset, KEY_MAX, BMAX, &frame);
+
+        memcpy(key, frame.key, frame.key_length);
+        key[frame.key_length] = '\0';
+
+        int status = refused_write_status();
+        storage_t* storage = storage_lookup(key, true);
+        if (storage && storage_save(storage, frame.value, frame.value_length) == 0) {
+            persist_write(key, storage, client_info);
+            status = OK;
         }
+        statuses_length += sprintf(statuses + statuses_length, "%d\n", status);
     }
 
-    if (!server_storage) {
-        server_storage = storage_init();
+    set_header(statuses_length, client_info);
+    client_info->BSIZE = statuses_length;
+}
+
+/**
+ * @brief Handles a /write request with a chunked body.
+ * @details This function starts streaming the upload into storage and decodes the part of the body that arrived together with the headers.
+ * If the body is not complete yet, the session is left in streaming mode and the rest is fed through handle_body_stream as it arrives.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the received body. Space complexity: O(n).
+ */
+static void handle_chunked_write(client_session_t* client_info) {
+    const char* body_start = strstr(client_info->request, "\r\n\r\n") + 4;
+    size_t body_length = client_info->request_size - (body_start - client_info->request);
+
+    chunk_decoder_init(&client_info->chunk_decoder, CHUNKED_BODY_MAX);
+    storage_stream_begin(&client_info->upload);
+    client_info->body_streaming_enabled = true;
+
+    handle_body_stream(body_start, body_length, client_info);
+}
+
+/**
+ * @brief Feeds the next piece of a chunked request body.
+ * @details This function decodes the received bytes and appends the decoded spans to the pending upload. Once the terminating chunk
+ * has been decoded, the upload is committed to storage and the /write response is set, echoing the stored value. On a malformed or
+ * oversized body the upload is discarded and an error response is set. In both cases streaming is disabled again.
+ * @param data The received bytes.
+ * @param length The number of received bytes.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of received bytes. Space complexity: O(n).
+ */
+void handle_body_stream(const char* data, size_t length, client_session_t* client_info) {
+    int status = chunk_decoder_feed(&client_info->chunk_decoder, data, length, append_upload, &client_info->upload);
+
+    if (status == 0) return;
+
+    client_info->body_streaming_enabled = false;
+
+    if (status < 0) {
+        storage_stream_abort(&client_info->upload);
+        raise_http_error(status == -2 ? ENTITY_TOO_LARGE : BAD_REQUEST, client_info);
+        return;
     }
 
-    if (storage_save(server_storage, body_recieved, to_store_len) < 0) {
-        raise_http_error(ENTITY_TOO_LARGE, client_info);
+    // The storage is looked up only now, since it may have been evicted while the body was arriving.
+    storage_t* storage = storage_lookup(client_info->upload_key, true);
+    if (!storage) {
+        storage_stream_abort(&client_info->upload);
+        raise_http_error(refused_write_status(), client_info);
         return;
     }
+    storage_stream_commit(storage, &client_info->upload);
+    persist_write(client_info->upload_key, storage, client_info);
 
-    client_info->HSIZE = snprintf(client_info->header, HMAX,
-        "HTTP/1.1 200 OK\r\n"
-        "Content-Length: %u\r\n"
-        "\r\n",
-        content_length
-    );
+    set_header(storage->value->length, client_info);
+    set_body_value(storage, client_info);
+}
 
-    memcpy(client_info->body, body_recieved, content_length);
-    client_info->BSIZE = content_length;
+/**
+ * @brief Abandons a chunked request body.
+ * @details This function discards the pending upload of a client that went away before finishing its body.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void abort_body_stream(client_session_t* client_info) {
+    if (client_info->body_streaming_enabled) {
+        storage_stream_abort(&client_info->upload);
+        client_info->body_streaming_enabled = false;
+    }
+}
+
+/**
+ * @brief Appends a decoded chunk span to a pending upload.
+ * @param ctx Pointer to the storage stream.
+ * @param data The decoded span.
+ * @param length The length of the span.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) amortized where n is the length of the span. Space complexity: O(n).
+ */
+static void append_upload(void* ctx, const char* data, size_t length) {
+    storage_stream_append((storage_stream_t*)ctx, data, length);
 }
 
 /**
- * @brief Handles the /read request.
+ * @brief Handles the /read and /read/<key> requests.
  * @details This function reads data from the storage and sets the appropriate response for the /read request.
+ * @param path The key of the value to read, or "" for the default value.
  * @param client_info Pointer to the client session information.
  * @return This function does not return a value.
  * @note Time complexity: O(n) where n is the size of the data read. Space complexity: O(1).
  */
-static void handle_read(client_session_t* client_info) {
-    if (!server_storage || server_storage->length == 0) {
-        client_info->HSIZE = snprintf(client_info->header, HMAX,
+static void handle_read(const char* path, client_session_t* client_info) {
+    storage_t* storage = valid_key(path) ? storage_lookup(path, false) : NULL;
+    PROBE_STORAGE_READ(client_info, path, storage ? (ssize_t)storage->value->length : -1);
+
+    // Responses are cached per key and rebuilt whenever a write changes the storage version.
+    uint64_t version = storage ? storage->version : 0;
+    char* cache_key = session_scratch(client_info, sizeof("/read/") + strlen(path));
+    sprintf(cache_key, "/read/%s", path);
+    if (serve_cached(cache_key, version, client_info)) return;
+
+    if (!storage || storage->value->length == 0) {
+        session_set_header(client_info,
             "HTTP/1.1 200 OK\r\n"
             "Content-Length: %zu\r\n"
             "\r\n",
             strlen("<empty>")
         );
 
-        client_info->BSIZE = snprintf(client_info->body, BMAX + 1, 
+        client_info->BSIZE = snprintf(session_reserve_body(client_info, sizeof("<empty>")), sizeof("<empty>"),
             "<empty>"
         );
 
+        // Missing keys are not cached, or reads of random keys would crowd the cache out.
+        if (storage) {
+            cache_response(cache_key, version, client_info);
+        }
         return;
     }
 
-    client_info->HSIZE = snprintf(client_info->header, HMAX,
+    session_set_header(client_info,
         "HTTP/1.1 200 OK\r\n"
         "Content-Length: %zu\r\n"
         "\r\n",
-        server_storage->length
+        storage->value->length
+    );
+
+    // The value is sent straight from storage. Only small values are worth a copy in the response cache.
+    set_body_value(storage, client_info);
+    if (storage->value->length <= BMAX) {
+        cache_response(cache_key, version, client_info);
+    }
+}
+
+/**
+ * @brief Handles the /mget/<key>/<key>/... request.
+ * @details This function returns the values of all listed keys in one response, framed like a /batch body as
+ * "<key length> <value length>\n<key><value>" per key, in order. Missing keys have an empty value. More than MGET_KEYS_MAX keys, or
+ * values adding up to a body of more than MGET_BODY_MAX bytes, are answered with 413.
+ * @param path The keys, separated by '/'. An empty key refers to the default value.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(n).
+ */
+static void handle_mget(const char* path, client_session_t* client_info) {
+    size_t count = 1;
+    for (const char* key = path; (key = strchr(key, '/')); key++) {
+        count++;
+    }
+
+    if (count > MGET_KEYS_MAX) {
+        raise_http_error(ENTITY_TOO_LARGE, client_info);
+        return;
+    }
+
+    const char* key = path;
+    for (size_t i = 0; i < count; i++) {
+        const char* end = strchrnul(key, '/');
+        if (end - key > KEY_MAX) {
+            raise_http_error(BAD_REQUEST, client_info);
+            return;
+        }
+        key = end + 1;
+    }
+
+    // Values are pinned while the response is sized, and copied into it afterwards.
+    storage_value_t** values = session_scratch(client_info, count * sizeof(*values));
+    char* name = session_scratch(client_info, KEY_MAX + 1);
+    size_t total_length = 0;
+
+    key = path;
+    for (size_t i = 0; i < count; i++) {
+        size_t key_length = strchrnul(key, '/') - key;
+        memcpy(name, key, key_length);
+        name[key_length] = '\0';
+
+        storage_t* storage = storage_lookup(name, false);
+        values[i] = storage ? storage_pin(storage) : NULL;
+        PROBE_STORAGE_READ(client_info, name, values[i] ? (ssize_t)values[i]->length : -1);
+
+        size_t value_length = values[i] ? values[i]->length : 0;
+        total_length += snprintf(NULL, 0, "%zu %zu\n", key_length, value_length) + key_length + value_length;
+        key += key_length + 1;
+    }
+
+    if (total_length > MGET_BODY_MAX) {
+        for (size_t i = 0; i < count; i++) {
+            if (values[i]) storage_value_release(values[i]);
+        }
+        raise_http_error(ENTITY_TOO_LARGE, client_info);
+        return;
+    }
+
+    char* body = session_reserve_body(client_info, total_length + 1);
+    size_t body_length = 0;
+
+    key = path;
+    for (size_t i = 0; i < count; i++) {
+        size_t key_length = strchrnul(key, '/') - key;
+        size_t value_length = values[i] ? values[i]->length : 0;
+
+        body_length += sprintf(body + body_length, "%zu %zu\n", key_length, value_length);
+        memcpy(body + body_length, key, key_length);
+        body_length += key_length;
+
+        if (values[i]) {
+            memcpy(body + body_length, values[i]->data, value_length);
+            body_length += value_length;
+            storage_value_release(values[i]);
+        }
+        key += key_length + 1;
+    }
+
+    set_header(body_length, client_info);
+    client_info->BSIZE = body_length;
+}
+
+/**
+ * @brief Checks whether a key may be used.
+ * @details The empty key refers to the default value used by /read and /write. Other keys may be up to KEY_MAX bytes long and may not contain '/'.
+ * @param key The key of the value.
+ * @return Returns true if the key is valid, false otherwise.
+ * @note Time complexity: O(n) where n is the length of the key. Space complexity: O(1).
+ */
+static bool valid_key(const char* key) {
+    return strlen(key) <= KEY_MAX && !strchr(key, '/');
+}
+
+/**
+ * @brief Logs a stored value when persistence is enabled.
+ * @details This function appends the value to the write-ahead log and marks the response as waiting for the log to be synced,
+ * so the client is only answered once the value is durable.
+ * @param key The key of the value, or "" for the default value.
+ * @param storage The storage of the value.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the value. Space complexity: O(n).
+ */
+static void persist_write(const char* key, storage_t* storage, client_session_t* client_info) {
+    PROBE_STORAGE_WRITE(client_info, key, storage->value->length);
+    if (!wal_enabled()) return;
+
+    wal_append(key, storage->value->data, storage->value->length);
+    client_info->wal_sync_pending = true;
+}
+
+/**
+ * @brief Gets the status of a write that storage refused.
+ * @return Returns SERVICE_UNAVAILABLE if the stored values have moved to a new server, so the client retries there, or
+ * INSUFFICIENT_STORAGE if the value did not fit.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int refused_write_status() {
+    return storage_is_read_only() ? SERVICE_UNAVAILABLE : INSUFFICIENT_STORAGE;
+}
+
+/**
+ * @brief Handles the /stats request.
+ * @details This function reports server internals as plain "name: value" lines, one per line.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void handle_stats(const char* path, client_session_t* client_info) {
+    char* body = session_reserve_body(client_info, BMAX);
+
+    client_info->BSIZE = snprintf(body, BMAX,
+        "allocations: %zu\n"
+        "pooled buffer bytes: %zu\n"
+        "storage bytes: %zu\n"
+        "response cache hits: %zu\n"
+        "response cache misses: %zu\n"
+        "response cache evictions: %zu\n"
+        "storage hits: %zu\n"
+        "storage misses: %zu\n"
+        "storage evictions: %zu\n"
+        "storage admission rejections: %zu\n"
+        "access log drops: %zu\n"
+        "capture drops: %zu\n"
+        "rate limit rejections: %zu\n"
+        "load shed requests: %zu\n"
+        "accept pauses: %zu\n"
+        "shared file opens: %zu\n",
+        get_allocation_count(),
+        buffer_pool_get_idle_memory(),
+        storage_get_memory_usage(),
+        response_cache_get_hits(),
+        response_cache_get_misses(),
+        response_cache_get_evictions(),
+        storage_get_hits(),
+        storage_get_misses(),
+        storage_get_evictions(),
+        storage_get_rejections(),
+        access_log_get_drops(),
+        capture_get_drops(),
+        rate_limit_get_rejections(),
+        overload_get_shed(),
+        overload_get_accept_pauses(),
+        open_file_get_shared()
     );
 
-    client_info->BSIZE = storage_read(server_storage, client_info->body, BMAX);
+    set_header(client_info->BSIZE, client_info);
+}
+
+/**
+ * @brief Handles the /trace request.
+ * @details This function dumps the per-stage latency histograms and the slowest requests since the previous dump, which starts a new window.
+ * Without tracing compiled in, /trace does not exist.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void handle_trace(const char* path, client_session_t* client_info) {
+#ifdef HTTP_TRACE
+    char* body = session_reserve_body(client_info, TRACE_DUMP_MAX);
+    client_info->BSIZE = trace_dump(body, TRACE_DUMP_MAX);
+    set_header(client_info->BSIZE, client_info);
+#else
+    raise_http_error(NOT_FOUND, client_info);
+#endif
 }
 
 /**
  * @brief Handles common GET requests.
- * @details This function sets the appropriate response for common GET requests.
+ * @details This function sets the appropriate response for common GET requests, from the asset pack if the path is packed and from
+ * the filesystem otherwise.
  * @param path The requested path.
  * @param client_info Pointer to the client session information.
  * @return This function does not return a value.
@@ -234,6 +629,19 @@ static void handle_read(client_session_t* client_info) {
  */
 static void handle_common_get(const char* path, client_session_t* client_info) {
     const char* filepath = path + 1;
+    struct stat file_stat;
+
+    if (serve_packed(path, client_info)) return;
+
+    // Small files are served from the response cache for as long as they are unchanged on disk, large ones from the file another
+    // response is sending, if any.
+    uint64_t version = 0;
+    if (stat(filepath, &file_stat) == 0 && S_ISREG(file_stat.st_mode)) {
+        version = file_version(&file_stat);
+        if ((size_t)file_stat.st_size <= BMAX ? serve_cached(path, version, client_info) : serve_shared(path, version, client_info)) {
+            return;
+        }
+    }
 
     int file_fd = open(filepath, O_RDONLY);
     if (file_fd < 0) {
@@ -241,8 +649,6 @@ static void handle_common_get(const char* path, client_session_t* client_info) {
         return;
     }
 
-
-    struct stat file_stat;
     if (fstat(file_fd, &file_stat) < 0 || !S_ISREG(file_stat.st_mode)) {
         close(file_fd);
         raise_http_error(NOT_FOUND, client_info);
@@ -257,17 +663,136 @@ static void handle_common_get(const char* path, client_session_t* client_info) {
         client_info->file_fd = file_fd;
         client_info->file_size = file_size;
         client_info->bytes_sent = 0;
+
+        // Only share what was opened from the same file that was looked up.
+        if (version == file_version(&file_stat)) {
+            client_info->open_file = open_file_share(path, version, file_fd, file_size);
+        }
         return;
     }
     
-    char* read_buff = Malloc(file_size);
-    ssize_t bytes_read = Read(file_fd, read_buff, file_size);
+    // Small files are read straight into the body buffer.
+    ssize_t bytes_read = Read(file_fd, session_reserve_body(client_info, file_size), file_size);
     close(file_fd);
 
-    memcpy(client_info->body, read_buff, file_size);
     client_info->BSIZE = file_size;
 
-    free(read_buff);
+    // Only cache what was read from the same file that was looked up.
+    if (version == file_version(&file_stat)) {
+        cache_response(path, version, client_info);
+    }
+}
+
+/**
+ * @brief Serves a response from the asset pack.
+ * @details Small responses are sent from the mapped pack like cached responses. Large ones copy their header and send the body with
+ * sendfile from the pack's file, at the offset of the body, so nothing is opened or looked up in the filesystem either way.
+ * @param path The requested path.
+ * @param client_info Pointer to the client session information.
+ * @return Returns true if the response was set, false if the path is not packed.
+ * @note Time complexity: O(n) where n is the length of the path and the request. Space complexity: O(1).
+ */
+static bool serve_packed(const char* path, client_session_t* client_info) {
+    const pack_entry_t* entry = pack_lookup(path, accepts_encoding(client_info->request, "gzip"));
+    if (!entry) return false;
+
+    if (entry->body_length <= BMAX) {
+        client_info->cached_response = pack_pin(entry);
+        return true;
+    }
+
+    // The session closes its file when the body is sent, so it gets a descriptor of its own.
+    int file_fd = dup(pack_fd());
+    if (file_fd < 0) return false;
+
+    session_set_header(client_info, "%.*s", (int)entry->header_length, pack_response(entry));
+    client_info->body_chunking_enabled = true;
+    client_info->file_fd = file_fd;
+    client_info->file_offset = entry->response_offset + entry->header_length;
+    client_info->file_size = entry->body_length;
+    client_info->bytes_sent = 0;
+    return true;
+}
+
+/**
+ * @brief Serves a large file from the descriptor another response is sending it from.
+ * @details Requests arriving while the file is being sent share its descriptor, so a burst of requests for the same file opens it
+ * once.
+ * @param path The requested path.
+ * @param version The current version of the file.
+ * @param client_info Pointer to the client session information.
+ * @return Returns true if the response was set, false if no response is sending that version of the file.
+ * @note Time complexity: O(n) where n is the length of the path. Space complexity: O(1).
+ */
+static bool serve_shared(const char* path, uint64_t version, client_session_t* client_info) {
+    open_file_t* file = open_file_acquire(path, version);
+    if (!file) return false;
+
+    set_header(file->size, client_info);
+    client_info->body_chunking_enabled = true;
+    client_info->open_file = file;
+    client_info->file_fd = file->fd;
+    client_info->file_size = file->size;
+    client_info->bytes_sent = 0;
+    return true;
+}
+
+/**
+ * @brief Computes the version of a file.
+ * @details The version changes whenever the file is replaced or modified, so it can validate cached responses built from the file.
+ * @param file_stat The status of the file.
+ * @return Returns the version of the file.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint64_t file_version(const struct stat* file_stat) {
+    uint64_t version = (uint64_t)file_stat->st_ino;
+    version = version * 1000003u ^ (uint64_t)file_stat->st_size;
+    version = version * 1000003u ^ (uint64_t)file_stat->st_mtim.tv_sec;
+    version = version * 1000003u ^ (uint64_t)file_stat->st_mtim.tv_nsec;
+    return version;
+}
+
+/**
+ * @brief Serves a response from the response cache.
+ * @details This function pins the cached response of the key if it was built from the given version. Send then writes its bytes
+ * with a single call, without touching the header and body buffers.
+ * @param key The cache key.
+ * @param version The current version of the data behind the response.
+ * @param client_info Pointer to the client session information.
+ * @return Returns true on a cache hit, false otherwise.
+ * @note Time complexity: O(n) where n is the length of the key. Space complexity: O(1).
+ */
+static bool serve_cached(const char* key, uint64_t version, client_session_t* client_info) {
+    client_info->cached_response = response_cache_lookup(key, version);
+    return client_info->cached_response != NULL;
+}
+
+/**
+ * @brief Stores the current response in the response cache.
+ * @details This function serializes the header and body set by a handler into the cache, and lets the session send the cached bytes.
+ * @param key The cache key.
+ * @param version The version of the data the response was built from.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(n).
+ */
+static void cache_response(const char* key, uint64_t version, client_session_t* client_info) {
+    const char* body = client_info->body_value ? client_info->body_value->data : client_info->body;
+    client_info->cached_response = response_cache_store(key, version, client_info->header, client_info->HSIZE, body, client_info->BSIZE);
+}
+
+/**
+ * @brief Sets the stored value as the response body.
+ * @details This function pins the current value of the storage, so it is sent without copying it and stays valid while it is being sent,
+ * even if a write replaces it in the meantime.
+ * @param storage Pointer to the storage.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void set_body_value(storage_t* storage, client_session_t* client_info) {
+    client_info->body_value = storage_pin(storage);
+    client_info->BSIZE = client_info->body_value->length;
 }
 
 /**
@@ -279,7 +804,7 @@ static void handle_common_get(const char* path, client_session_t* client_info) {
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 static void set_header(size_t content_length, client_session_t* client_info) {
-    client_info->HSIZE = snprintf(client_info->header, HMAX,
+    session_set_header(client_info,
         "HTTP/1.1 200 OK\r\n"
         "Content-Length: %zu\r\n"
         "\r\n",
@@ -3,7 +3,8 @@
 #include <stdbool.h>
 #include "client_session.h"
 
-void handle_get(const char* path, client_session_t* client_info);
-void handle_post(const char* path, client_session_t* client_info);
+void handle_request(const char* method, const char* path, client_session_t* client_info);
+void handle_body_stream(const char* data, size_t length, client_session_t* client_info);
+void abort_body_stream(client_session_t* client_info);
 
 #endif
\ No newline at end of file
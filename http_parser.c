@@ -3,6 +3,8 @@
 /// @details This file includes functions to parse HTTP request lines and headers.
 
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -50,23 +52,24 @@ int parse_request(const char* request, char* method, size_t method_size, char* p
  * @brief Parses the HTTP headers.
  * @details This function extracts the headers from the HTTP request.
  * It uses `strstr` to find the start and end of the headers, which are delimited by `\r\n` and `\r\n\r\n` respectively.
- * The headers are then copied into the provided buffer.
+ * The headers are then copied into the provided buffer, which has to hold them and a terminating null byte.
  * @param request The HTTP request containing the headers.
  * @param header_recieved A buffer to store the extracted headers.
  * @param headers_size The size of the headers buffer.
- * @return Returns 0 on success, or -1 on failure.
+ * @return Returns 0 on success, -1 if the request has no complete head, or -2 if the headers do not fit into the buffer.
  * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(1).
  */
 int parse_headers(const char* request, char* header_recieved, size_t headers_size) {
     // Extracting a pointer to the start of the header. +2 since \r\n are counted as 2 chars.
-    const char* header_start = strstr(request, "\r\n") + 2;
+    const char* header_start = strstr(request, "\r\n");
     if (!header_start) return -1;
-    
+    header_start += 2;
+
     const char* header_end = strstr(header_start, "\r\n\r\n");
     if (!header_end) return -1;
 
     size_t header_len = header_end - header_start;
-    if (header_len > HMAX) return -2;
+    if (header_len >= headers_size) return -2;
 
     strncpy(header_recieved, header_start, header_len);
     header_recieved[header_len] = '\0';
@@ -74,33 +77,6 @@ int parse_headers(const char* request, char* header_recieved, size_t headers_siz
     return 0;
 }
 
-/**
- * @brief Parses the HTTP body.
- * @details This function extracts the body from the HTTP request. 
- * It uses `strstr` to find the start of the body, which is delimited by `\r\n\r\n`. 
- * The body is then copied into the provided buffer. 
- * The function also ensures that the body size does not exceed the buffer size.
- * @param request The HTTP request containing the body.
- * @param request_size The size of the HTTP request.
- * @param body_recieved A buffer to store the extracted body.
- * @param body_size The size of the body buffer.
- * @return Returns the length of the extracted body on success, or -1 on failure.
- * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(1).
- */
-int parse_body(const char* request, ssize_t request_size, char* body_recieved, size_t body_size) {
-    // +4 to skip the carraige return.
-    char* body_start = strstr(request, "\r\n\r\n") + 4;
-    if (!body_start) return -1;
-
-    size_t parsed_b_length = request_size - (body_start - request);
-    if (parsed_b_length >= body_size) return -2;
-
-    memcpy(body_recieved, body_start, parsed_b_length);
-    body_recieved[parsed_b_length] = '\0';
-
-    return (int)parsed_b_length;
-}
-
 /**
  * @brief Extracts the Content-Length from the HTTP request.
  * @details This function extracts the Content-Length value from the HTTP request headers. 
@@ -119,17 +95,278 @@ int extract_content_length(const char* request) {
 }
 
 /**
- * @brief Parses the HTTP body up to a specified length.
- * @details This function extracts the body from the HTTP request up to the specified length. It uses `strstr` to find the start of the body, which is delimited by `\r\n\r\n`. The body is then copied into the provided buffer up to the specified length.
- * @param request The HTTP request containing the body.
- * @param body_recieved A buffer to store the extracted body.
- * @param length_to_copy The length of the body to copy.
+ * @brief Checks whether the request body uses chunked transfer coding.
+ * @details This function looks for a "Transfer-Encoding:" header within the request head and checks whether its value names the "chunked" coding.
+ * @param request The HTTP request containing the headers.
+ * @return Returns true if the body is chunked, false otherwise.
+ * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(1).
+ */
+bool is_chunked_transfer(const char* request) {
+    const char* head_end = strstr(request, "\r\n\r\n");
+    const char* encoding = strstr(request, "Transfer-Encoding:");
+    if (!encoding || !head_end || encoding > head_end) return false;
+
+    const char* line_end = strstr(encoding, "\r\n");
+    const char* chunked = strstr(encoding, "chunked");
+
+    return chunked && chunked < line_end;
+}
+
+/**
+ * @brief Checks whether a weight is zero.
+ * @param weight The weight, e.g. "0.000" or "0.5".
+ * @return Returns true if the weight is zero, false otherwise.
+ * @note Time complexity: O(n) where n is the length of the weight. Space complexity: O(1).
+ */
+static bool is_zero_weight(const char* weight) {
+    if (*weight != '0') return false;
+    weight++;
+
+    if (*weight == '.') {
+        weight++;
+        while (*weight == '0') weight++;
+    }
+
+    return !isdigit((unsigned char)*weight);
+}
+
+/**
+ * @brief Checks whether the client accepts a content coding.
+ * @details This function looks for an "Accept-Encoding:" header within the request head, in any case since HTTP/2 header names are
+ * lowercase, and splits its value into codings with their parameters. A coding listed with a weight of zero, e.g. "gzip;q=0", is
+ * refused. A coding that is not listed is accepted if "*" is listed with a weight other than zero.
+ * @param request The HTTP request containing the headers.
+ * @param coding The content coding, e.g. "gzip".
+ * @return Returns true if the coding is accepted, false otherwise.
+ * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(1).
+ */
+bool accepts_encoding(const char* request, const char* coding) {
+    const char* head_end = strstr(request, "\r\n\r\n");
+    const char* encoding = strcasestr(request, "\r\nAccept-Encoding:");
+    if (!encoding || !head_end || encoding > head_end) return false;
+
+    const char* cursor = encoding + strlen("\r\nAccept-Encoding:");
+    const char* line_end = strstr(cursor, "\r\n");
+    size_t coding_length = strlen(coding);
+    bool wildcard = false;
+
+    while (cursor < line_end) {
+        while (cursor < line_end && (*cursor == ',' || *cursor == ' ' || *cursor == '\t')) cursor++;
+
+        const char* token = cursor;
+        while (cursor < line_end && *cursor != ',' && *cursor != ';' && *cursor != ' ' && *cursor != '\t') cursor++;
+        size_t token_length = cursor - token;
+
+        // Of the parameters up to the next coding, only the weight matters.
+        bool refused = false;
+        while (cursor < line_end && *cursor != ',') {
+            if (*cursor++ != ';') continue;
+
+            while (cursor < line_end && (*cursor == ' ' || *cursor == '\t')) cursor++;
+            if (line_end - cursor > 2 && (*cursor == 'q' || *cursor == 'Q') && cursor[1] == '=') {
+                refused = is_zero_weight(cursor + 2);
+            }
+        }
+
+        if (token_length == coding_length && strncasecmp(token, coding, coding_length) == 0) return !refused;
+        if (token_length == 1 && *token == '*') wildcard = !refused;
+    }
+
+    return wildcard;
+}
+
+// States of the chunked body decoder.
+enum {
+    CHUNK_SIZE,
+    CHUNK_EXTENSION,
+    CHUNK_SIZE_LF,
+    CHUNK_DATA,
+    CHUNK_DATA_CR,
+    CHUNK_DATA_LF,
+    CHUNK_TRAILER,
+    CHUNK_TRAILER_LINE,
+    CHUNK_TRAILER_LF,
+    CHUNK_DONE
+};
+
+/**
+ * @brief Initializes a chunked body decoder.
+ * @details This function resets the decoder so that it expects the first chunk-size line.
+ * @param decoder Pointer to the decoder to initialize.
+ * @param max_total_length The maximum number of decoded body bytes accepted before the body is rejected.
  * @return This function does not return a value.
- * @note Time complexity: O(n) where n is the length to copy. Space complexity: O(1).
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void chunk_decoder_init(chunk_decoder_t* decoder, size_t max_total_length) {
+    memset(decoder, 0x00, sizeof(chunk_decoder_t));
+    decoder->state = CHUNK_SIZE;
+    decoder->max_total_length = max_total_length;
+}
+
+/**
+ * @brief Converts a hexadecimal digit to its value.
+ * @param c The character to convert.
+ * @return Returns the value of the digit, or -1 if the character is not a hexadecimal digit.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int hex_value(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Feeds received bytes into a chunked body decoder.
+ * @details This function runs the chunked transfer coding state machine over the given bytes. Chunk data is never copied:
+ * every decoded span is handed to `on_data` as a pointer into `data`. The decoder keeps its state between calls, so a body
+ * may be fed in arbitrarily split pieces as it arrives from the socket. Chunk-size lines are limited to CHUNK_LINE_MAX bytes,
+ * trailer lines to HMAX bytes and the decoded body to the decoder's maximum total length.
+ * @param decoder Pointer to the decoder.
+ * @param data The received bytes.
+ * @param length The number of received bytes.
+ * @param on_data Callback receiving each decoded span.
+ * @param ctx Opaque pointer passed through to `on_data`.
+ * @return Returns 1 once the terminating chunk and trailers were decoded, 0 if more input is needed,
+ * -1 if the body is malformed, or -2 if the body exceeds the maximum total length.
+ * @note Time complexity: O(n) where n is the number of bytes fed. Space complexity: O(1).
+ */
+int chunk_decoder_feed(chunk_decoder_t* decoder, const char* data, size_t length, chunk_data_cb on_data, void* ctx) {
+    size_t i = 0;
+
+    while (i < length && decoder->state != CHUNK_DONE) {
+        char c = data[i];
+
+        switch (decoder->state) {
+            case CHUNK_SIZE: {
+                int digit = hex_value(c);
+                if (++decoder->line_length > CHUNK_LINE_MAX) return -1;
+
+                if (digit >= 0) {
+                    if (decoder->chunk_remaining > (decoder->max_total_length - decoder->total_length) / 16) return -2;
+                    decoder->chunk_remaining = decoder->chunk_remaining * 16 + digit;
+                } else if (decoder->line_length == 1) {
+                    return -1;
+                } else if (c == ';' || c == ' ' || c == '\t') {
+                    decoder->state = CHUNK_EXTENSION;
+                } else if (c == '\r') {
+                    decoder->state = CHUNK_SIZE_LF;
+                } else {
+                    return -1;
+                }
+                i++;
+                break;
+            }
+            case CHUNK_EXTENSION:
+                if (++decoder->line_length > CHUNK_LINE_MAX) return -1;
+                if (c == '\r') decoder->state = CHUNK_SIZE_LF;
+                i++;
+                break;
+            case CHUNK_SIZE_LF:
+                if (c != '\n') return -1;
+                if (decoder->chunk_remaining > decoder->max_total_length - decoder->total_length) return -2;
+
+                decoder->line_length = 0;
+                decoder->state = (decoder->chunk_remaining == 0) ? CHUNK_TRAILER : CHUNK_DATA;
+                i++;
+                break;
+            case CHUNK_DATA: {
+                size_t available = length - i;
+                size_t span = (available < decoder->chunk_remaining) ? available : decoder->chunk_remaining;
+
+                on_data(ctx, data + i, span);
+                decoder->chunk_remaining -= span;
+                decoder->total_length += span;
+                i += span;
+
+                if (decoder->chunk_remaining == 0) decoder->state = CHUNK_DATA_CR;
+                break;
+            }
+            case CHUNK_DATA_CR:
+                if (c != '\r') return -1;
+                decoder->state = CHUNK_DATA_LF;
+                i++;
+                break;
+            case CHUNK_DATA_LF:
+                if (c != '\n') return -1;
+                decoder->state = CHUNK_SIZE;
+                i++;
+                break;
+            case CHUNK_TRAILER:
+                // An empty line ends the trailer section, anything else is a trailer field we skip.
+                decoder->state = (c == '\r') ? CHUNK_TRAILER_LF : CHUNK_TRAILER_LINE;
+                decoder->line_length = 1;
+                i++;
+                break;
+            case CHUNK_TRAILER_LINE:
+                if (++decoder->line_length > HMAX) return -1;
+                if (c == '\n') {
+                    decoder->line_length = 0;
+                    decoder->state = CHUNK_TRAILER;
+                }
+                i++;
+                break;
+            case CHUNK_TRAILER_LF:
+                if (c != '\n') return -1;
+                decoder->state = CHUNK_DONE;
+                i++;
+                break;
+        }
+    }
+
+    return (decoder->state == CHUNK_DONE) ? 1 : 0;
+}
+
+/**
+ * @brief Parses a length field of a batch frame header.
+ * @param data The header.
+ * @param length The length of the header.
+ * @param offset The offset of the field, advanced past it.
+ * @param max The largest valid value.
+ * @return Returns the value of the field, or -1 if it is missing, not a decimal number or larger than `max`.
+ * @note Time complexity: O(n) where n is the length of the field. Space complexity: O(1).
  */
-void parse_body_upto(const char* request, char* body_recieved, size_t length_to_copy) {
-    char* body_start = strstr(request, "\r\n\r\n") + 4;
+static ssize_t parse_frame_length(const char* data, size_t length, size_t* offset, size_t max) {
+    size_t start = *offset;
+    size_t value = 0;
+
+    while (*offset < length && isdigit((unsigned char)data[*offset])) {
+        value = value * 10 + (data[*offset] - '0');
+        if (value > max) return -1;
+        (*offset)++;
+    }
+
+    return *offset == start ? -1 : (ssize_t)value;
+}
 
-    strncpy(body_recieved, body_start, length_to_copy);
-    body_recieved[length_to_copy] = '\0';
-}
\ No newline at end of file
+/**
+ * @brief Parses the next key/value pair of a batch body.
+ * @details Each pair is framed as "<key length> <value length>\n" followed by the key and the value, with the lengths in decimal.
+ * The parsed key and value point into `data`, nothing is copied.
+ * @param data The remaining batch body.
+ * @param length The length of the remaining body.
+ * @param max_key_length The longest valid key.
+ * @param max_value_length The longest valid value.
+ * @param frame The parsed pair.
+ * @return Returns the number of bytes taken by the pair, 0 if the body is empty, or -1 if the pair is malformed or truncated.
+ * @note Time complexity: O(n) where n is the length of the frame header. Space complexity: O(1).
+ */
+ssize_t parse_batch_frame(const char* data, size_t length, size_t max_key_length, size_t max_value_length, batch_frame_t* frame) {
+    if (length == 0) return 0;
+
+    size_t offset = 0;
+    ssize_t key_length = parse_frame_length(data, length, &offset, max_key_length);
+    if (key_length < 0 || offset >= length || data[offset++] != ' ') return -1;
+
+    ssize_t value_length = parse_frame_length(data, length, &offset, max_value_length);
+    if (value_length < 0 || offset >= length || data[offset++] != '\n') return -1;
+
+    if (length - offset < (size_t)key_length + (size_t)value_length) return -1;
+
+    frame->key = data + offset;
+    frame->key_length = key_length;
+    frame->value = data + offset + key_length;
+    frame->value_length = value_length;
+
+    return offset + key_length + value_length;
+}
@@ -1,13 +1,37 @@
 #if !defined(HTTP_PARSER_H)
 #define HTTP_PARSER_H
 
+#include <stdbool.h>
 #include <unistd.h>
 
+/// @brief Callback invoked with each decoded span of a chunked body.
+/// @details The span points into the caller's input buffer and is only valid for the duration of the call.
+typedef void (*chunk_data_cb)(void* ctx, const char* data, size_t length);
+
+typedef struct {
+    int state;
+    size_t chunk_remaining;
+    size_t line_length;
+    size_t total_length;
+    size_t max_total_length;
+} chunk_decoder_t;
+
+// A key/value pair of a batch body, framed as "<key length> <value length>\n<key><value>". Key and value point into the body.
+typedef struct {
+    const char* key;
+    size_t key_length;
+    const char* value;
+    size_t value_length;
+} batch_frame_t;
+
 int parse_request(const char* request, char* method, size_t method_size, char* path, size_t path_size);
 int parse_headers(const char* request, char* headers, size_t headers_size);
-int parse_body(const char* request, ssize_t request_size, char* body_recieved, size_t body_size);
 int extract_content_length(const char* request);
-void parse_body_upto(const char* request, char* body_recieved, size_t length_to_copy);
+bool is_chunked_transfer(const char* request);
+bool accepts_encoding(const char* request, const char* coding);
+void chunk_decoder_init(chunk_decoder_t* decoder, size_t max_total_length);
+int chunk_decoder_feed(chunk_decoder_t* decoder, const char* data, size_t length, chunk_data_cb on_data, void* ctx);
+ssize_t parse_batch_frame(const char* data, size_t length, size_t max_key_length, size_t max_value_length, batch_frame_t* frame);
 
 
 #endif
\ No newline at end of file
@@ -5,11 +5,15 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
 #include "http_response.h"
 #include "http_parser.h"
 #include "constants.h"
 #include "http_errors.h"
 #include "http_method_handler.h"
+#include "probes.h"
+#include "socket_profile.h"
 #include <sys/epoll.h>
 
 /**
@@ -22,17 +26,12 @@
  */
 void generate_response(const char* method, const char* path, client_session_t* client_info) {
     if (strstr(client_info->request, "\r\n\r\n") == NULL) {
-        raise_http_error(BAD_REQUEST, client_info);
+        // A head that did not end within REQUEST_MAX bytes is too large rather than malformed.
+        raise_http_error(client_info->request_size + 1 >= REQUEST_MAX ? ENTITY_TOO_LARGE : BAD_REQUEST, client_info);
         return;
     }
 
-    if (strcmp(method, "GET") == 0) {
-       handle_get(path, client_info);
-    } else if (strcmp(method, "POST") == 0) {
-        handle_post(path, client_info);
-    } else {
-        raise_http_error(BAD_REQUEST, client_info);
-    }
+    handle_request(method, path, client_info);
 }
 
 /**
@@ -45,7 +44,7 @@ void generate_response(const char* method, const char* path, client_session_t* c
  * @return Returns an integer indicating success (0) or failure (non-zero).
  * @note Time complexity: O(1). Space complexity: O(1).
  */
-static void send_data(int clientfd, char buf[], int size) {
+static void send_data(int clientfd, const char buf[], int size) {
     ssize_t amt, total = 0;
 
     do {
@@ -55,48 +54,118 @@ static void send_data(int clientfd, char buf[], int size) {
     } while (total < size);
 }
 
+/**
+ * @brief Sends a header and a body with a single call.
+ * @details Partial writes are resumed until both have been sent or an error occurs.
+ * @param clientfd The socket file descriptor to send the response to.
+ * @param header The response header.
+ * @param header_size The size of the header.
+ * @param body The response body.
+ * @param body_size The size of the body, 0 if there is none.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(1).
+ */
+static void send_vectors(int clientfd, const char* header, size_t header_size, const char* body, size_t body_size) {
+    struct iovec iov[2] = {
+        { .iov_base = (void*)header, .iov_len = header_size },
+        { .iov_base = (void*)body, .iov_len = body_size },
+    };
+    struct iovec* next = iov;
+    int count = body_size > 0 ? 2 : 1;
+
+    while (count > 0) {
+        ssize_t amt = writev(clientfd, next, count);
+        if (amt < 0) break;
+
+        while (count > 0 && (size_t)amt >= next->iov_len) {
+            amt -= next->iov_len;
+            next++;
+            count--;
+        }
+        if (count > 0) {
+            next->iov_base = (char*)next->iov_base + amt;
+            next->iov_len -= amt;
+        }
+    }
+}
+
+/**
+ * @brief Reads the status code of a response.
+ * @param response The response, starting with its status line.
+ * @param length The length of the response.
+ * @return Returns the status code, or 0 if the status line is too short.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int response_status(const char* response, size_t length) {
+    return length >= sizeof("HTTP/1.1 200") - 1 ? atoi(response + sizeof("HTTP/1.1 ") - 1) : 0;
+}
+
 /**
  * @brief Sends the HTTP response to the client.
- * @details This function handles both chunked and non-chunked responses. For chunked responses, it reads data from the file in chunks and sends it to the client. For non-chunked responses, it sends the header and body directly.
+ * @details This function handles both chunked and non-chunked responses. For chunked responses, it sends the file in chunks of FILE_CHUNK bytes
+ * with sendfile, so file data never passes through user space, also not on kTLS connections where the kernel encrypts it. For non-chunked
+ * responses, it sends the header and body directly.
  * @param client_info Pointer to the client session information.
  * @return This function does not return a value.
  * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(1).
  */
 void Send(client_session_t* client_info) {
     if (client_info->body_chunking_enabled) {
-        char buffer[BMAX];
         size_t remaining_bytes = client_info->file_size - client_info->bytes_sent;
-        size_t to_read = (remaining_bytes > BMAX) ? BMAX : remaining_bytes;
+        size_t to_send = (remaining_bytes > FILE_CHUNK) ? FILE_CHUNK : remaining_bytes;
 
-        ssize_t bytes_read = read(client_info->file_fd, buffer, to_read);
-        
-        // Send header only if it is the first chunk.
-        if (client_info->bytes_sent == 0) {
+        // Send header only if it is the first chunk, the pooled buffers are not needed after that.
+        bool first_chunk = client_info->bytes_sent == 0;
+        if (first_chunk) {
+            socket_profile_cork(client_info->fd, true);
             send_data(client_info->fd, client_info->header, client_info->HSIZE);
+            client_info->log_record.status = response_status(client_info->header, client_info->HSIZE);
+            client_info->log_record.bytes = client_info->HSIZE;
+            session_release_buffers(client_info);
+        }
+
+        off_t offset = client_info->file_offset + client_info->bytes_sent;
+        ssize_t bytes_read = sendfile(client_info->fd, client_info->file_fd, &offset, to_send);
+
+        // The header has left with the first chunk, later chunks fill their segments on their own.
+        if (first_chunk) {
+            socket_profile_cork(client_info->fd, false);
         }
 
         if (bytes_read > 0) {
-            send_data(client_info->fd, buffer, bytes_read);
+            PROBE_CHUNK_SENT(client_info, client_info->fd, bytes_read, client_info->bytes_sent);
             client_info->bytes_sent += bytes_read;
+            client_info->log_record.bytes += bytes_read;
+            TRACE_STAMP(client_info, TRACE_SEND);
 
             // Check if this is the last chunk
             if (client_info->bytes_sent >= client_info->file_size) {
-                close(client_info->file_fd); // Close the file descriptor
+                session_close_file(client_info); // Close the file descriptor
                 epoll_ctl(client_info->epfd, EPOLL_CTL_DEL, client_info->fd, NULL); // Remove from epoll interest list
-                close(client_info->fd); // Close the socket
-                free(client_info); // Free the client session memory
+                session_destroy(client_info); // Close the socket and free the client session memory
             }
         } else {
-            // Handle read error or EOF
-            close(client_info->file_fd); // Close the file descriptor
+            // Handle read or send error, or EOF
+            session_close_file(client_info); // Close the file descriptor
             epoll_ctl(client_info->epfd, EPOLL_CTL_DEL, client_info->fd, NULL); // Remove from epoll interest list
-            close(client_info->fd); // Close the socket
-            free(client_info); // Free the client session memory
+            session_destroy(client_info); // Close the socket and free the client session memory
         }
+    } else if (client_info->cached_response) {
+        // Pre-serialized response, sent with a single call
+        send_data(client_info->fd, client_info->cached_response->bytes, client_info->cached_response->length);
+        client_info->log_record.status = response_status(client_info->cached_response->bytes, client_info->cached_response->length);
+        client_info->log_record.bytes = client_info->cached_response->length;
+        TRACE_STAMP(client_info, TRACE_SEND);
+
+        epoll_ctl(client_info->epfd, EPOLL_CTL_DEL, client_info->fd, NULL); // Remove from epoll interest list
     } else {
-        // Normal response (non-chunked)
-        send_data(client_info->fd, client_info->header, client_info->HSIZE);
-        send_data(client_info->fd, client_info->body, client_info->BSIZE);
+        // Normal response (non-chunked), a pinned stored value is sent straight from storage
+        const char* body = client_info->body_value ? client_info->body_value->data : client_info->body;
+        size_t body_size = client_info->BSIZE > 0 ? client_info->BSIZE : 0;
+        send_vectors(client_info->fd, client_info->header, client_info->HSIZE, body, body_size);
+        client_info->log_record.status = response_status(client_info->header, client_info->HSIZE);
+        client_info->log_record.bytes = client_info->HSIZE + body_size;
+        TRACE_STAMP(client_info, TRACE_SEND);
 
         epoll_ctl(client_info->epfd, EPOLL_CTL_DEL, client_info->fd, NULL); // Remove from epoll interest list
     }
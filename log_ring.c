@@ -0,0 +1,147 @@
+/// @file log_ring.c
+/// @brief Contains the ring behind the access log and the capture trace.
+/// @details This file includes functions to claim and push records on a single-producer, single-consumer ring, and the background
+/// thread that drains the ring into a file. The event loop is the only producer and never blocks on the writer.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+
+#include "log_ring.h"
+#include "cpu_affinity.h"
+
+// How long the writer sleeps when the ring is empty.
+#define LOG_RING_IDLE_NS (10 * 1000 * 1000)
+
+static void* writer_main(void* arg);
+static void write_all(int fd, const char* data, size_t length);
+
+/**
+ * @brief Starts the writer thread of a ring.
+ * @details The writer blocks every signal, so signals meant for the server interrupt the event loop.
+ * @param ring The ring, with its records, output buffer and format filled in.
+ * @param fd The file the writer appends lines to. It stays open until the ring is stopped and is closed by the caller.
+ * @return Returns 0 on success, or -1 if the writer could not be started.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int log_ring_start(log_ring_t* ring, int fd) {
+    ring->fd = fd;
+    atomic_store_explicit(&ring->stopping, false, memory_order_relaxed);
+
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_SETMASK, &all, &previous);
+    int created = pthread_create(&ring->writer, NULL, writer_main, ring);
+    pthread_sigmask(SIG_SETMASK, &previous, NULL);
+
+    if (created != 0) {
+        return -1;
+    }
+    affinity_place_helper(ring->writer);
+
+    return 0;
+}
+
+/**
+ * @brief Claims the next free record of a ring.
+ * @details The record is only handed to the writer by log_ring_push. If the ring is full, the drop is counted instead.
+ * @param ring The ring.
+ * @return Returns a pointer to the record, or NULL if the ring is full.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void* log_ring_claim(log_ring_t* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail == ring->slot_count) {
+        ring->drops++;
+        return NULL;
+    }
+
+    return (char*)ring->records + (head & (ring->slot_count - 1)) * ring->record_size;
+}
+
+/**
+ * @brief Hands the record claimed last to the writer.
+ * @param ring The ring.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void log_ring_push(log_ring_t* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+/**
+ * @brief Stops the writer of a ring.
+ * @details This function lets the writer drain the ring and waits for it.
+ * @param ring The ring.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of pending records. Space complexity: O(1).
+ */
+void log_ring_stop(log_ring_t* ring) {
+    atomic_store_explicit(&ring->stopping, true, memory_order_release);
+    pthread_join(ring->writer, NULL);
+}
+
+/**
+ * @brief Runs the writer thread.
+ * @details The writer formats records into the output buffer and writes the buffer whenever it fills up or the ring runs empty, so a
+ * burst of records costs a single write. It sleeps while there is nothing to do, and exits once the ring is empty after a stop was requested.
+ * @param arg The ring.
+ * @return Returns NULL.
+ * @note Time complexity: O(n) where n is the size of the records. Space complexity: O(1).
+ */
+static void* writer_main(void* arg) {
+    log_ring_t* ring = arg;
+    size_t used = 0;
+
+    while (true) {
+        // Reading the stop flag first guarantees that every record pushed before the stop is seen below.
+        bool stop = atomic_load_explicit(&ring->stopping, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+        if (tail == head) {
+            if (used > 0) {
+                write_all(ring->fd, ring->out, used);
+                used = 0;
+            }
+            if (stop) break;
+
+            struct timespec idle = { .tv_sec = 0, .tv_nsec = LOG_RING_IDLE_NS };
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+        for (; tail != head; tail++) {
+            if (ring->out_size - used < ring->line_max) {
+                write_all(ring->fd, ring->out, used);
+                used = 0;
+            }
+            used += ring->format((char*)ring->records + (tail & (ring->slot_count - 1)) * ring->record_size, ring->out + used);
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Writes a buffer to a file, retrying partial writes.
+ * @details Lines that cannot be written are lost, the writer never stops the server.
+ * @param fd The file descriptor.
+ * @param data The data to be written.
+ * @param length The length of the data.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the data. Space complexity: O(1).
+ */
+static void write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) return;
+        data += written;
+        length -= written;
+    }
+}
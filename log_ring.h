@@ -0,0 +1,42 @@
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/// @file log_ring.h
+/// @brief Contains the declarations of the ring behind the access log and the capture trace.
+/// @details The event loop copies fixed-size records into a lock-free single-producer, single-consumer ring, and a background thread
+/// formats them into lines and writes them out in batches. When the ring is full, records are dropped and counted rather than waited for.
+
+// Formats a record into a line of at most line_max bytes and returns its length.
+typedef size_t (*log_ring_format_t)(const void* record, char* line);
+
+// A ring and its writer. The records and the output buffer belong to the user of the ring, which fills in every field up to
+// format, usually in a static initializer. The rest is zero until the ring is started.
+typedef struct {
+    void* records;              // slot_count records of record_size bytes.
+    size_t record_size;
+    size_t slot_count;          // A power of two.
+    char* out;                  // The buffer lines are formatted into before they are written out.
+    size_t out_size;
+    size_t line_max;            // The longest line a record formats to.
+    log_ring_format_t format;
+
+    // Records in [tail, head) are waiting for the writer. head is only written by the event loop, tail only by the writer.
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    atomic_bool stopping;
+    int fd;
+    pthread_t writer;
+    size_t drops;
+} log_ring_t;
+
+int log_ring_start(log_ring_t* ring, int fd);
+void* log_ring_claim(log_ring_t* ring);
+void log_ring_push(log_ring_t* ring);
+void log_ring_stop(log_ring_t* ring);
+
+#endif
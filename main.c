@@ -20,19 +20,127 @@
 #include "client_session.h"
 #include "server_config.h"
 
+// HTTPS options, only available when built with TLS=1.
+#ifdef HTTP_TLS
+#define TLS_OPTIONS "S:k:K:"
+#define TLS_USAGE " [-S https port -k certificate -K key]"
+#else
+#define TLS_OPTIONS ""
+#define TLS_USAGE ""
+#endif
+
 /**
  * @brief Entry point for the HTTP server application.
- * @details This function initializes the server and starts it on the specified port. It asserts that the correct number of command-line arguments are provided.
+ * @details This function parses the command line and starts the server on the specified port. Options may appear before or after the port:
+ * - `-w <path>` keeps a write-ahead log of the stored values at `path` and recovers them from it on startup.
+ * - `-m <bytes>` limits the memory taken by stored values, evicting cold values beyond it.
+ * - `-a` only admits new keys into a full storage if they are used more often than the values they would evict.
+ * - `-l <path>` appends a JSON line per request to the access log at `path`.
+ * - `-t <path>` captures the requests, with the time they arrived at, to a trace at `path` that bench/replay can send again.
+ * - `-T <n>` only captures one in `n` requests.
+ * - `-A <path>` serves the files packed into the asset pack at `path` by pack_gen from the pack, without looking them up on disk.
+ * - `-c <connections>` limits the open connections per client address, beyond which connections are answered with 503 and closed.
+ * - `-r <rate>` limits the requests per second per client address, in bursts of up to `rate`, beyond which requests are answered with 429.
+ * - `-R <path>` takes the port and stored values over from the server listening on the control socket at `path`, if any, and listens
+ *   there for the next server to hand over to.
+ * - `-d <microseconds>` answers requests other than `/ping` with 503 while ready events wait longer than this to be handled.
+ * - `-s <sessions>` pauses accepting while this many sessions are open.
+ * - `-P <profile>` applies a TCP socket option profile, `latency`, `throughput` or a list of settings, see socket_profile.h.
+ * - `-b <microseconds>` polls for events for up to this long before blocking, trading a busy core for lower latency.
+ * - `-u <path>` also accepts clients on the same host on a UNIX domain socket at `path`.
+ * - `-U <uid>` answers clients of the UNIX domain socket that do not run as user `uid` with 403.
+ * - `-C <cpu>` pins the event loop to a core, places its memory on that core's NUMA node, and keeps helper threads on the node's other cores.
+ * - `-S <port> -k <certificate> -K <key>` also serves HTTPS on `port`, with records encrypted by the kernel. Only available when built with TLS=1.
  * @param argc The number of command-line arguments.
- * @param argv The array of command-line arguments. The first argument is the program name, and the second argument is the port number.
- * @return Returns 0 on successful execution.
+ * @param argv The array of command-line arguments. The first argument is the program name, followed by the options and the port number.
+ * @return Returns 0 on successful execution, or 1 if the command line is invalid.
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 int main(int argc, char * argv[])
 {
-    assert(argc == 2);
-    int port = atoi(argv[1]);
-    run_server(port);
+    server_options_t options;
+    memset(&options, 0, sizeof(options));
+    options.loop_cpu = -1;
+    options.unix_uid = -1;
+
+    int option;
+    while ((option = getopt(argc, argv, "w:m:al:t:T:A:c:r:R:d:s:b:P:C:u:U:" TLS_OPTIONS)) != -1) {
+        switch (option) {
+            case 'w':
+                options.wal_path = optarg;
+                break;
+            case 'm':
+                options.memory_limit = strtoull(optarg, NULL, 10);
+                break;
+            case 'a':
+                options.admission = true;
+                break;
+            case 'l':
+                options.access_log_path = optarg;
+                break;
+            case 't':
+                options.capture_path = optarg;
+                break;
+            case 'T':
+                options.capture_sample = strtoul(optarg, NULL, 10);
+                break;
+            case 'A':
+                options.assets_path = optarg;
+                break;
+            case 'c':
+                options.client_connections = strtoul(optarg, NULL, 10);
+                break;
+            case 'r':
+                options.client_rate = strtoul(optarg, NULL, 10);
+                break;
+            case 'R':
+                options.control_path = optarg;
+                break;
+            case 'd':
+                options.max_delay_us = strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                options.max_sessions = strtoull(optarg, NULL, 10);
+                break;
+            case 'b':
+                options.busy_poll_us = strtoul(optarg, NULL, 10);
+                break;
+            case 'P':
+                options.socket_profile = optarg;
+                break;
+            case 'C':
+                options.loop_cpu = atoi(optarg);
+                break;
+            case 'u':
+                options.unix_path = optarg;
+                break;
+            case 'U':
+                options.unix_uid = atoi(optarg);
+                break;
+#ifdef HTTP_TLS
+            case 'S':
+                options.tls_port = atoi(optarg);
+                break;
+            case 'k':
+                options.tls_certificate = optarg;
+                break;
+            case 'K':
+                options.tls_key = optarg;
+                break;
+#endif
+            default:
+                fprintf(stderr, "usage: %s [-w log] [-m bytes] [-a] [-l access log] [-t capture trace] [-T sample] [-A asset pack] [-c connections] [-r rate] [-R control socket] [-d delay us] [-s sessions] [-b spin us] [-P socket profile] [-C cpu] [-u unix socket] [-U uid]" TLS_USAGE " port\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind != 1 || (options.tls_port && (!options.tls_certificate || !options.tls_key))) {
+        fprintf(stderr, "usage: %s [-w log] [-m bytes] [-a] [-l access log] [-t capture trace] [-T sample] [-A asset pack] [-c connections] [-r rate] [-R control socket] [-d delay us] [-s sessions] [-b spin us] [-P socket profile] [-C cpu] [-u unix socket] [-U uid]" TLS_USAGE " port\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    options.port = atoi(argv[optind]);
+    run_server(&options);
 
     return 0;
 }
\ No newline at end of file
@@ -6,11 +6,16 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/stat.h>
 #include <arpa/inet.h>
 #include "network_utils.h"
 
+// Number of heap allocations made through Malloc and Realloc.
+static size_t allocation_count = 0;
+
 /// @file network_utils.c
 /// @brief Contains utility functions for network operations.
 /// @details This file includes wrapper functions for common network operations such as creating a socket, binding, and listening on a socket.
@@ -66,10 +71,15 @@ void Listen(int sockfd, int backlog) {
     }
 }
 
-/// @brief 
-/// @param sockfd 
+/**
+ * @brief Configures a listening socket.
+ * @details This function lets the socket bind its port while connections of a previous server linger in TIME_WAIT.
+ * @param sockfd The socket file descriptor.
+ * @return This function does not return a value. It exits if the option cannot be set.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
 void configure_socket(int sockfd) {
-    int optval = -1;
+    int optval = 1;
     if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval)) < 0) {
         perror("Set socket options failed");
         close(sockfd);
@@ -77,21 +87,38 @@ void configure_socket(int sockfd) {
     }
 }
 
+/**
+ * @brief Removes a UNIX domain socket file left behind at a path, so a socket can be bound there again.
+ * @details Anything at the path that is not a socket is left alone, binding then fails instead of replacing it. A symbolic link is
+ * not followed.
+ * @param path The path of the socket.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void unlink_socket(const char* path) {
+    struct stat path_stat;
+    if (lstat(path, &path_stat) == 0 && S_ISSOCK(path_stat.st_mode)) {
+        unlink(path);
+    }
+}
+
 /**
  * @brief Wrapper function for accepting a new client connection.
- * @details This function accepts a new client connection and handles errors if the acceptance fails.
+ * @details This function accepts a new client connection and handles errors if the acceptance fails. Running out of file descriptors
+ * and connections aborted before they were accepted are not fatal, the connection is left for a later call.
  * @param listenfd The file descriptor of the listening socket.
- * @return Returns the file descriptor of the accepted client connection.
+ * @param client_addr Set to the address of the client, of any family the listening socket may accept.
+ * @return Returns the file descriptor of the accepted client connection, or -1 if none could be accepted for now.
  * @note Time complexity: O(1). Space complexity: O(1).
  */
-int Accept(int listenfd) {
-    struct sockaddr_in client_addr;
-    socklen_t client_len = sizeof(struct sockaddr_in);
+int Accept(int listenfd, struct sockaddr_storage* client_addr) {
+    socklen_t client_len = sizeof(*client_addr);
     
-    memset(&client_addr, 0x00, sizeof(client_addr));
+    memset(client_addr, 0x00, sizeof(*client_addr));
 
-    int clientfd = accept(listenfd, (struct sockaddr*) &client_addr, &client_len);
+    int clientfd = accept(listenfd, (struct sockaddr*) client_addr, &client_len);
     if (clientfd < 0) {
+        if (errno == EMFILE || errno == ENFILE || errno == ECONNABORTED) return -1;
         perror("Accept failed");
         exit(EXIT_FAILURE);
     }
@@ -101,21 +128,20 @@ int Accept(int listenfd) {
 
 /**
  * @brief Wrapper function for receiving data from a socket.
- * @details This function receives data from a socket and handles errors if the receive operation fails.
+ * @details This function receives data from a socket. A failed receive, such as a connection reset by the client, only concerns
+ * that connection, so it is left to the caller.
  * @param sockfd The file descriptor of the socket.
  * @param buffer A pointer to the buffer where the received data will be stored.
  * @param length The length of the buffer.
  * @param flags Flags to be used with the receive operation.
- * @return Returns the number of bytes received.
+ * @return Returns the number of bytes received, or -1 with errno set if the receive failed.
  * @note Time complexity: O(n) where n is the number of bytes received. Space complexity: O(1).
  */
 ssize_t Recv(int sockfd, void* buffer, size_t length, int flags) {
     ssize_t bytes_recieved = recv(sockfd, buffer, length, flags);
 
     if (bytes_recieved < 0) {
-        printf("Recv Failed.\n");
-        close(sockfd);
-        exit(EXIT_FAILURE);
+        return -1;
     }
 
     return bytes_recieved;
@@ -130,6 +156,7 @@ ssize_t Recv(int sockfd, void* buffer, size_t length, int flags) {
  */
 void* Malloc(size_t size) {
     void* ptr = malloc(size);
+    allocation_count++;
 
     if (!ptr) {
         printf("Failed to allocate memory\n");
@@ -140,6 +167,37 @@ void* Malloc(size_t size) {
     return ptr;
 }
 
+/**
+ * @brief Wrapper function for resizing allocated memory.
+ * @details This function resizes a memory block and handles errors if the reallocation fails.
+ * @param ptr Pointer to the memory block to resize, or NULL to allocate a new block.
+ * @param size The new size of the memory block.
+ * @return Returns a pointer to the resized memory.
+ * @note Time complexity: O(n) where n is the size of the block. Space complexity: O(n).
+ */
+void* Realloc(void* ptr, size_t size) {
+    void* resized = realloc(ptr, size);
+    allocation_count++;
+
+    if (!resized) {
+        printf("Failed to allocate memory\n");
+        free(ptr);
+        exit(EXIT_FAILURE);
+    }
+
+    return resized;
+}
+
+/**
+ * @brief Gets the number of heap allocations made so far.
+ * @details Every call to Malloc or Realloc is counted, which makes allocations on the request path observable.
+ * @return Returns the number of allocations.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t get_allocation_count() {
+    return allocation_count;
+}
+
 /**
  * @brief Wrapper function for adding, modifying, or removing file descriptors from an epoll instance.
  * @details This function adds, modifies, or removes file descriptors from an epoll instance and handles errors if the operation fails.
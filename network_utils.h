@@ -3,15 +3,19 @@
 
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <netinet/in.h>
 
 int Socket(int namespace, int style, int protocol);
 void Bind(int sockfd, const struct sockaddr* addr, socklen_t addrlen);
 void Listen(int sockfd, int backlog);
 void configure_socket(int sockfd);
-int Accept(int listenfd);
+void unlink_socket(const char* path);
+int Accept(int listenfd, struct sockaddr_storage* client_addr);
 ssize_t Read(int fd, void* buffer, size_t count);
 ssize_t Recv(int sockfd, void* buffer, size_t length, int flags);
 void* Malloc(size_t size);
+void* Realloc(void* ptr, size_t size);
+size_t get_allocation_count();
 void Epoll_ctl(int epfd, int op, int fd, struct epoll_event* event);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,130 @@
+/// @file open_files.c
+/// @brief Contains the table of files being sent.
+/// @details This file includes functions to share the open file of a large response among all responses sending the same version of
+/// the file at the same time. Under a burst of requests for a cold file, the first request opens it and the others are sent from the
+/// same descriptor, and so the same page cache pages, without opening or inspecting the file again. sendfile is given its own offset
+/// by every response, so they never move each other's position. Entries live only while a response sends them.
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "network_utils.h"
+#include "open_files.h"
+
+#define OPEN_FILE_BUCKETS 64
+
+static open_file_t* buckets[OPEN_FILE_BUCKETS];
+static size_t shared = 0;
+
+/**
+ * @brief Finds the bucket of a path.
+ * @param path The path of the file.
+ * @return Returns a pointer to the head of the bucket chain.
+ * @note Time complexity: O(n) where n is the length of the path. Space complexity: O(1).
+ */
+static open_file_t** bucket_of(const char* path) {
+    size_t hash = 5381;
+    for (const char* c = path; *c; c++) {
+        hash = hash * 33 + (unsigned char)*c;
+    }
+    return &buckets[hash % OPEN_FILE_BUCKETS];
+}
+
+/**
+ * @brief Unlinks an entry from its bucket.
+ * @param file The entry.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the bucket chain. Space complexity: O(1).
+ */
+static void unlink_file(open_file_t* file) {
+    open_file_t** link = bucket_of(file->path);
+    while (*link != file) {
+        link = &(*link)->next;
+    }
+    *link = file->next;
+    file->unlinked = true;
+}
+
+/**
+ * @brief Looks up a file another response is sending.
+ * @details This function returns the entry of the path if it holds the given version of the file, pinning it until open_file_release
+ * is called.
+ * @param path The path of the file.
+ * @param version The current version of the file.
+ * @return Returns a pointer to the pinned entry, or NULL if no response is sending that version of the file.
+ * @note Time complexity: O(n) where n is the length of the path, on average. Space complexity: O(1).
+ */
+open_file_t* open_file_acquire(const char* path, uint64_t version) {
+    for (open_file_t* file = *bucket_of(path); file; file = file->next) {
+        if (strcmp(file->path, path) == 0) {
+            if (file->version != version) return NULL;
+
+            shared++;
+            file->refcount++;
+            return file;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Shares an opened file with later responses for the same path.
+ * @details The table takes the descriptor over. An entry of an older version of the file is unlinked, the responses still sending it
+ * keep it until they release it.
+ * @param path The path of the file.
+ * @param version The version of the file.
+ * @param fd The open file descriptor.
+ * @param size The size of the file.
+ * @return Returns a pointer to the new entry, pinned like a lookup result.
+ * @note Time complexity: O(n) where n is the length of the path, on average. Space complexity: O(n).
+ */
+open_file_t* open_file_share(const char* path, uint64_t version, int fd, size_t size) {
+    open_file_t** link = bucket_of(path);
+    for (open_file_t* file = *link; file; file = file->next) {
+        if (strcmp(file->path, path) == 0) {
+            unlink_file(file);
+            break;
+        }
+    }
+
+    size_t path_length = strlen(path);
+    open_file_t* file = Malloc(sizeof(open_file_t) + path_length + 1);
+    memcpy(file->path, path, path_length + 1);
+    file->version = version;
+    file->refcount = 1;
+    file->unlinked = false;
+    file->fd = fd;
+    file->size = size;
+    file->next = *link;
+    *link = file;
+
+    return file;
+}
+
+/**
+ * @brief Unpins a shared file.
+ * @details This function drops a reference taken by a lookup or share, closing the file when no response sends it anymore.
+ * @param file The entry to unpin.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1), plus the bucket chain when the file is closed. Space complexity: O(1).
+ */
+void open_file_release(open_file_t* file) {
+    if (--file->refcount > 0) return;
+
+    if (!file->unlinked) {
+        unlink_file(file);
+    }
+    close(file->fd);
+    free(file);
+}
+
+/**
+ * @brief Gets the number of responses sent from a file another response had open.
+ * @return Returns the number of shared opens.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t open_file_get_shared() {
+    return shared;
+}
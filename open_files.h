@@ -0,0 +1,24 @@
+#ifndef OPEN_FILES_H
+#define OPEN_FILES_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// An open file shared by the responses sending it. The file is closed when the last of them releases it.
+typedef struct open_file {
+    struct open_file* next;
+    uint64_t version;
+    int refcount;
+    bool unlinked;
+    int fd;
+    size_t size;
+    char path[];
+} open_file_t;
+
+open_file_t* open_file_acquire(const char* path, uint64_t version);
+open_file_t* open_file_share(const char* path, uint64_t version, int fd, size_t size);
+void open_file_release(open_file_t* file);
+size_t open_file_get_shared();
+
+#endif
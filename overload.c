@@ -0,0 +1,149 @@
+/// @file overload.c
+/// @brief Contains functions for shedding load when the event loop falls behind.
+/// @details This file includes functions to smooth the queueing delay measured by the event loop and to decide, with hysteresis, when
+/// to shed requests and when to pause accepting. Both thresholds are off unless configured.
+
+#include <time.h>
+
+#include "overload.h"
+
+// Shedding or pausing stops once the load has fallen to this fraction of the threshold, in percent.
+#define OVERLOAD_RESUME_PERCENT 75
+
+// How long accepting pauses after running out of file descriptors if no session closes meanwhile, in microseconds.
+#define OVERLOAD_EXHAUSTED_PAUSE_US (100 * 1000)
+
+static uint32_t delay_limit_us = 0;
+static size_t session_limit = 0;
+
+// Exponentially weighted moving average of the queueing delay, each sample weighing 1/8.
+static uint64_t average_delay_us = 0;
+
+static bool shedding = false;
+static bool accepting = true;
+static size_t shed = 0;
+static size_t accept_pauses = 0;
+
+// The open sessions and the time when accepting last failed for lack of file descriptors, or 0 while it has not.
+static size_t exhausted_sessions = 0;
+static uint64_t exhausted_at_us = 0;
+
+/**
+ * @brief Sets the overload thresholds.
+ * @param max_delay_us The queueing delay in microseconds past which requests are shed, or 0 to never shed.
+ * @param max_sessions The number of open sessions at which accepting pauses, or 0 to always accept.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void overload_configure(uint32_t max_delay_us, size_t max_sessions) {
+    delay_limit_us = max_delay_us;
+    session_limit = max_sessions;
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Returns the current time in microseconds.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+uint64_t overload_now_us() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+/**
+ * @brief Adds a sample of the queueing delay.
+ * @details Shedding starts once the average delay exceeds the threshold and stops once it has fallen below OVERLOAD_RESUME_PERCENT
+ * of it, so a single slow iteration does not toggle it.
+ * @param delay_us How long the last event of an iteration waited for the events handled before it, in microseconds.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void overload_record_delay(uint64_t delay_us) {
+    if (!delay_limit_us) return;
+
+    average_delay_us = (average_delay_us * 7 + delay_us) / 8;
+
+    if (!shedding && average_delay_us > delay_limit_us) {
+        shedding = true;
+    } else if (shedding && average_delay_us * 100 < (uint64_t)delay_limit_us * OVERLOAD_RESUME_PERCENT) {
+        shedding = false;
+    }
+}
+
+/**
+ * @brief Checks whether new requests are being shed.
+ * @return Returns true if new requests other than health checks should be answered with 503.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool overload_shedding() {
+    return shedding;
+}
+
+/**
+ * @brief Records that accepting failed because the process or the system is out of file descriptors.
+ * @details The pending connection stays in the listen backlog, so a level-triggered listener would be reported again at once.
+ * Accepting pauses instead until a session has closed or OVERLOAD_EXHAUSTED_PAUSE_US has passed.
+ * @param active_sessions The number of open sessions.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void overload_fds_exhausted(size_t active_sessions) {
+    exhausted_sessions = active_sessions;
+    exhausted_at_us = overload_now_us();
+    accept_pauses++;
+}
+
+/**
+ * @brief Decides whether to accept new connections.
+ * @details Accepting pauses at the session threshold and resumes once the open sessions have fallen below OVERLOAD_RESUME_PERCENT
+ * of it. It also pauses after overload_fds_exhausted. Connections arriving meanwhile wait in the listen backlog.
+ * @param active_sessions The number of open sessions.
+ * @return Returns true if the listening socket should be monitored.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool overload_should_accept(size_t active_sessions) {
+    if (exhausted_at_us) {
+        if (active_sessions >= exhausted_sessions && overload_now_us() - exhausted_at_us < OVERLOAD_EXHAUSTED_PAUSE_US) {
+            return false;
+        }
+        exhausted_at_us = 0;
+    }
+
+    if (!session_limit) return true;
+
+    if (accepting && active_sessions >= session_limit) {
+        accepting = false;
+        accept_pauses++;
+    } else if (!accepting && active_sessions * 100 < session_limit * OVERLOAD_RESUME_PERCENT) {
+        accepting = true;
+    }
+    return accepting;
+}
+
+/**
+ * @brief Counts a shed request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void overload_count_shed() {
+    shed++;
+}
+
+/**
+ * @brief Gets the number of shed requests.
+ * @return Returns the number of requests answered with 503 because of the queueing delay.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t overload_get_shed() {
+    return shed;
+}
+
+/**
+ * @brief Gets the number of times accepting paused.
+ * @return Returns the number of pauses.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t overload_get_accept_pauses() {
+    return accept_pauses;
+}
@@ -0,0 +1,24 @@
+#ifndef OVERLOAD_H
+#define OVERLOAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file overload.h
+/// @brief Contains function declarations for shedding load when the event loop falls behind.
+/// @details The event loop reports how long ready events waited to be handled and how many sessions are open. Past the configured
+/// queueing delay, new requests other than health checks are answered with 503. Past the configured number of sessions, accepting
+/// pauses until sessions have finished. Running out of file descriptors pauses accepting as well.
+
+void overload_configure(uint32_t max_delay_us, size_t max_sessions);
+uint64_t overload_now_us();
+void overload_record_delay(uint64_t delay_us);
+bool overload_shedding();
+void overload_fds_exhausted(size_t active_sessions);
+bool overload_should_accept(size_t active_sessions);
+void overload_count_shed();
+size_t overload_get_shed();
+size_t overload_get_accept_pauses();
+
+#endif
@@ -0,0 +1,274 @@
+/// @file pack_gen.c
+/// @brief Build-time packer of static assets.
+/// @details This program walks directories and writes every regular file below them into an asset pack, as a complete response under
+/// the path the server would serve the file at, e.g. /tests/07-files/index.html. With -z, a gzip-compressed variant is added for
+/// every file it makes smaller. Files are packed in path order, so the same files always give the same pack.
+/// Usage: pack_gen [-z] <pack> <directory>...
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "asset_pack.h"
+
+// Most files a pack can hold.
+#define MAX_FILES 65536
+
+// Longest response header, with room for the largest Content-Length.
+#define HEADER_MAX 128
+
+typedef struct {
+    char* path;
+    char* body;
+    size_t body_length;
+    char header[HEADER_MAX];
+    size_t header_length;
+    char* gzip_body;
+    size_t gzip_body_length;
+    char gzip_header[HEADER_MAX];
+    size_t gzip_header_length;
+} packed_file_t;
+
+static packed_file_t files[MAX_FILES];
+static size_t file_count = 0;
+static bool compress_files = false;
+
+static int add_file(const char* path, const struct stat* file_stat, int type, struct FTW* walk);
+static int compare_paths(const void* a, const void* b);
+static void compress_file(packed_file_t* file);
+static void write_pack(const char* name);
+
+/**
+ * @brief Entry point of the packer.
+ * @param argc The number of command-line arguments.
+ * @param argv -z to add compressed variants, the path of the pack and the directories to pack.
+ * @return Returns 0 on success, or 1 on failure.
+ * @note Time complexity: O(n log n) where n is the number of files, plus the size of the files. Space complexity: O(s) where s is
+ * the size of the files.
+ */
+int main(int argc, char* argv[]) {
+    int option;
+    while ((option = getopt(argc, argv, "z")) != -1) {
+        if (option != 'z') {
+            fprintf(stderr, "usage: %s [-z] pack directory...\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        compress_files = true;
+    }
+
+    if (argc - optind < 2) {
+        fprintf(stderr, "usage: %s [-z] pack directory...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = optind + 1; i < argc; i++) {
+        // Paths are served relative to the working directory, so "./dir" and "dir" pack the same paths.
+        const char* directory = argv[i];
+        while (strncmp(directory, "./", 2) == 0) directory += 2;
+
+        if (nftw(directory, add_file, 16, FTW_PHYS) != 0) {
+            perror(directory);
+            return EXIT_FAILURE;
+        }
+    }
+
+    qsort(files, file_count, sizeof(packed_file_t), compare_paths);
+    for (size_t i = 1; i < file_count; i++) {
+        if (strcmp(files[i - 1].path, files[i].path) == 0) {
+            fprintf(stderr, "pack_gen: %s is packed twice\n", files[i].path);
+            return EXIT_FAILURE;
+        }
+    }
+
+    write_pack(argv[optind]);
+    return 0;
+}
+
+/**
+ * @brief Reads a file found by the walk into the list of files to pack.
+ * @param path The path of the file.
+ * @param file_stat The status of the file.
+ * @param type The type of the file.
+ * @param walk Unused.
+ * @return Returns 0 to continue the walk. It exits if the file cannot be read.
+ * @note Time complexity: O(n) where n is the size of the file. Space complexity: O(n).
+ */
+static int add_file(const char* path, const struct stat* file_stat, int type, struct FTW* walk) {
+    if (type != FTW_F || !S_ISREG(file_stat->st_mode)) return 0;
+
+    if (file_count == MAX_FILES) {
+        fprintf(stderr, "pack_gen: too many files\n");
+        exit(EXIT_FAILURE);
+    }
+
+    packed_file_t* file = &files[file_count++];
+    memset(file, 0x00, sizeof(packed_file_t));
+
+    file->path = malloc(strlen(path) + 2);
+    file->body = malloc(file_stat->st_size ? file_stat->st_size : 1);
+    FILE* input = fopen(path, "rb");
+    if (!file->path || !file->body || !input || fread(file->body, 1, file_stat->st_size, input) != (size_t)file_stat->st_size) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    fclose(input);
+
+    sprintf(file->path, "/%s", path);
+    file->body_length = file_stat->st_size;
+
+    if (compress_files) {
+        compress_file(file);
+    }
+
+    // The same header the server sends for files, telling caches that the body depends on Accept-Encoding if there is a variant.
+    file->header_length = sprintf(file->header, "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n%s\r\n", file->body_length,
+        file->gzip_body ? "Vary: Accept-Encoding\r\n" : "");
+
+    return 0;
+}
+
+/**
+ * @brief Compresses a file with gzip, keeping the result only if it is smaller.
+ * @param file The file.
+ * @return This function does not return a value. It exits if compression fails.
+ * @note Time complexity: O(n) where n is the size of the file. Space complexity: O(n).
+ */
+static void compress_file(packed_file_t* file) {
+    z_stream stream;
+    memset(&stream, 0x00, sizeof(stream));
+
+    // 16 added to the window bits selects the gzip wrapper.
+    if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "pack_gen: %s\n", stream.msg ? stream.msg : "deflateInit2 failed");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t capacity = deflateBound(&stream, file->body_length);
+    char* compressed = malloc(capacity);
+    if (!compressed) exit(EXIT_FAILURE);
+
+    stream.next_in = (Bytef*)file->body;
+    stream.avail_in = file->body_length;
+    stream.next_out = (Bytef*)compressed;
+    stream.avail_out = capacity;
+    if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+        fprintf(stderr, "pack_gen: compressing %s failed\n", file->path);
+        exit(EXIT_FAILURE);
+    }
+    size_t compressed_length = stream.total_out;
+    deflateEnd(&stream);
+
+    int header_length = snprintf(file->gzip_header, sizeof(file->gzip_header), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\n"
+        "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n\r\n", compressed_length);
+    if (compressed_length + header_length >= file->body_length) {
+        free(compressed);
+        return;
+    }
+
+    file->gzip_body = compressed;
+    file->gzip_body_length = compressed_length;
+    file->gzip_header_length = header_length;
+}
+
+/**
+ * @brief Orders files by path for qsort.
+ * @param a The first file.
+ * @param b The second file.
+ * @return Returns a negative, zero or positive value as the path of a sorts before, with or after the path of b.
+ * @note Time complexity: O(n) where n is the length of the paths. Space complexity: O(1).
+ */
+static int compare_paths(const void* a, const void* b) {
+    return strcmp(((const packed_file_t*)a)->path, ((const packed_file_t*)b)->path);
+}
+
+/**
+ * @brief Writes the pack.
+ * @details The plain response of every file gets an entry and an index slot. Compressed variants get entries after all plain ones.
+ * The index has at least twice as many slots as files, so probe sequences stay short.
+ * @param name The path of the pack.
+ * @return This function does not return a value. It exits if the pack cannot be written.
+ * @note Time complexity: O(n) where n is the size of the pack. Space complexity: O(m) where m is the number of files.
+ */
+static void write_pack(const char* name) {
+    uint32_t slot_count = 1;
+    while (slot_count < 2 * file_count) slot_count *= 2;
+
+    size_t variants = 0;
+    for (size_t i = 0; i < file_count; i++) {
+        if (files[i].gzip_body) variants++;
+    }
+    size_t entry_count = file_count + variants;
+
+    pack_slot_t* slots = calloc(slot_count, sizeof(pack_slot_t));
+    pack_entry_t* entries = calloc(entry_count ? entry_count : 1, sizeof(pack_entry_t));
+    if (!slots || !entries) exit(EXIT_FAILURE);
+
+    // Paths and responses follow the tables, in file order.
+    uint64_t offset = sizeof(pack_header_t) + slot_count * sizeof(pack_slot_t) + entry_count * sizeof(pack_entry_t);
+    size_t variant = file_count;
+    for (size_t i = 0; i < file_count; i++) {
+        packed_file_t* file = &files[i];
+        pack_entry_t* entry = &entries[i];
+
+        entry->path_offset = offset;
+        entry->path_length = strlen(file->path);
+        offset += entry->path_length;
+
+        entry->response_offset = offset;
+        entry->header_length = file->header_length;
+        entry->body_length = file->body_length;
+        offset += file->header_length + file->body_length;
+
+        if (file->gzip_body) {
+            pack_entry_t* compressed = &entries[variant];
+            compressed->path_offset = entry->path_offset;
+            compressed->path_length = entry->path_length;
+            compressed->response_offset = offset;
+            compressed->header_length = file->gzip_header_length;
+            compressed->body_length = file->gzip_body_length;
+            offset += file->gzip_header_length + file->gzip_body_length;
+            entry->variant = ++variant;
+        }
+
+        uint32_t hash = pack_hash(file->path, entry->path_length);
+        uint32_t slot = hash & (slot_count - 1);
+        while (slots[slot].entry) slot = (slot + 1) & (slot_count - 1);
+        slots[slot].hash = hash;
+        slots[slot].entry = i + 1;
+    }
+
+    pack_header_t header;
+    memset(&header, 0x00, sizeof(header));
+    memcpy(header.magic, PACK_MAGIC, sizeof(header.magic));
+    header.slot_count = slot_count;
+    header.entry_count = entry_count;
+    header.size = offset;
+
+    FILE* output = fopen(name, "wb");
+    if (!output) {
+        perror(name);
+        exit(EXIT_FAILURE);
+    }
+    fwrite(&header, sizeof(header), 1, output);
+    fwrite(slots, sizeof(pack_slot_t), slot_count, output);
+    fwrite(entries, sizeof(pack_entry_t), entry_count, output);
+    for (size_t i = 0; i < file_count; i++) {
+        packed_file_t* file = &files[i];
+        fwrite(file->path, 1, strlen(file->path), output);
+        fwrite(file->header, 1, file->header_length, output);
+        fwrite(file->body, 1, file->body_length, output);
+        if (file->gzip_body) {
+            fwrite(file->gzip_header, 1, file->gzip_header_length, output);
+            fwrite(file->gzip_body, 1, file->gzip_body_length, output);
+        }
+    }
+    if (ferror(output) || fclose(output) != 0) {
+        perror(name);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%s: %zu files, %zu compressed variants, %llu bytes\n", name, file_count, variants, (unsigned long long)offset);
+}
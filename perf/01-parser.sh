@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# requests/s: parsing the request line, headers and content length of a write
+
+./bench/micro parser
@@ -0,0 +1,7 @@
+#!/bin/bash
+
+# requests/s: /ping round trips of a single client, each on its own connection
+
+PORT=$@
+
+./bench/latency $PORT 20000 /ping | awk '/^throughput:/ { print $2 }'
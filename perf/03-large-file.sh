@@ -0,0 +1,12 @@
+#!/bin/bash
+
+# MB/s: downloading a 64 MB file
+
+PORT=$@
+
+# The server serves files below its working directory, the file is made in a directory of its own there and removed afterwards.
+DIR=$(mktemp -d perf.XXXXXX)
+trap "rm -rf $DIR" EXIT
+head -c $((64 * 1024 * 1024)) /dev/urandom >$DIR/perf.bin
+
+curl -s -o /dev/null -w "%{speed_download}\n" http://127.0.0.1:$PORT/$DIR/perf.bin | awk '{ printf "%.1f\n", $1 / 1000000 }'
@@ -0,0 +1,5 @@
+#!/bin/bash
+
+# sessions/s: creating a session, giving it a request buffer and destroying it
+
+./bench/micro sessions
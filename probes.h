@@ -0,0 +1,58 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+/// @file probes.h
+/// @brief Contains the USDT probes of the request path.
+/// @details The probes are compiled in whenever sys/sdt.h is installed (systemtap-sdt-dev), which the makefile detects and announces
+/// with -DHAVE_SYS_SDT_H. Every probe is a single nop in the code plus a note telling perf and bpftrace where it is and where its
+/// arguments live, so a probe costs nothing until a tracer attaches to it, and it survives the inlining of the function around it.
+/// Without sys/sdt.h the macros expand to nothing. The probes belong to the provider "http", and the first argument of each is the
+/// session serving the request, which tells concurrent requests apart, also the streams of an HTTP/2 connection, whose sessions have
+/// no fd of their own (-1). The scripts in bpftrace/ are built on them.
+
+#ifdef HAVE_SYS_SDT_H
+
+#include <sys/sdt.h>
+
+// A connection was accepted: session, fd, whether the client is on the UNIX socket.
+#define PROBE_ACCEPT(session, fd, local) DTRACE_PROBE3(http, accept, session, fd, local)
+
+// The request line was parsed: session, fd, method, path, request size.
+#define PROBE_REQUEST_PARSED(session, method, path) \
+    DTRACE_PROBE5(http, request__parsed, session, (session)->fd, method, path, (session)->request_size)
+
+// The route was looked up: session, path, whether a route matched rather than the filesystem or an error.
+#define PROBE_ROUTE_CHOSEN(session, path, matched) DTRACE_PROBE3(http, route__chosen, session, path, matched)
+
+// A value was looked up: session, key, size of the value or -1 if the key is missing.
+#define PROBE_STORAGE_READ(session, key, size) DTRACE_PROBE3(http, storage__read, session, key, size)
+
+// A value was stored: session, key, size of the value.
+#define PROBE_STORAGE_WRITE(session, key, size) DTRACE_PROBE3(http, storage__write, session, key, size)
+
+// The response is about to be sent: session, fd, header size, body size.
+#define PROBE_RESPONSE_START(session) \
+    DTRACE_PROBE4(http, response__start, session, (session)->fd, (session)->HSIZE, (session)->BSIZE)
+
+// A piece of a file body, or a DATA frame of an HTTP/2 stream, was sent: session, fd of the connection, bytes sent, bytes of the
+// body sent before.
+#define PROBE_CHUNK_SENT(session, fd, bytes, offset) DTRACE_PROBE4(http, chunk__sent, session, fd, bytes, offset)
+
+// The session is done: session, fd, status or 0 if no response was sent, bytes sent.
+#define PROBE_RESPONSE_FINISH(session) \
+    DTRACE_PROBE4(http, response__finish, session, (session)->fd, (session)->log_record.status, (session)->log_record.bytes)
+
+#else
+
+#define PROBE_ACCEPT(session, fd, local) ((void)0)
+#define PROBE_REQUEST_PARSED(session, method, path) ((void)0)
+#define PROBE_ROUTE_CHOSEN(session, path, matched) ((void)0)
+#define PROBE_STORAGE_READ(session, key, size) ((void)0)
+#define PROBE_STORAGE_WRITE(session, key, size) ((void)0)
+#define PROBE_RESPONSE_START(session) ((void)0)
+#define PROBE_CHUNK_SENT(session, fd, bytes, offset) ((void)0)
+#define PROBE_RESPONSE_FINISH(session) ((void)0)
+
+#endif
+
+#endif
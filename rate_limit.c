@@ -0,0 +1,157 @@
+/// @file rate_limit.c
+/// @brief Contains functions for per-client admission control.
+/// @details This file includes functions to look client addresses up in a fixed-size, open-addressed table, to enforce the per-address
+/// connection limit and to refill and spend the per-address token buckets. The table never allocates. An entry is reused once its
+/// address has no open connection and a full bucket, since it then carries no state.
+
+#include <stddef.h>
+#include <time.h>
+
+#include "constants.h"
+#include "rate_limit.h"
+
+// Number of entries in the table, a power of two.
+#define RATE_LIMIT_TABLE_SIZE 4096
+
+// Number of entries probed for an address before the table counts as full.
+#define RATE_LIMIT_PROBES 16
+
+static client_limit_t table[RATE_LIMIT_TABLE_SIZE];
+
+static uint32_t connection_limit = CLIENT_CONNECTIONS_MAX;
+static uint32_t request_rate = 0;
+static size_t rejections = 0;
+
+static uint32_t now_ms();
+static void refill(client_limit_t* limit, uint32_t now);
+
+/**
+ * @brief Sets the per-client limits.
+ * @param max_connections The maximum number of open connections per address, or 0 for CLIENT_CONNECTIONS_MAX.
+ * @param rate The number of requests per second per address, which is also the burst size, or 0 to not limit requests.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void rate_limit_configure(uint32_t max_connections, uint32_t rate) {
+    connection_limit = max_connections ? max_connections : CLIENT_CONNECTIONS_MAX;
+    // Buckets hold thousandths of a request in 32 bits.
+    request_rate = rate < 1000000 ? rate : 1000000;
+}
+
+/**
+ * @brief Admits a connection from a client address.
+ * @details On success the connection is counted against the address until rate_limit_release is called with the returned entry.
+ * A rejected connection is not counted. When every probed entry belongs to an active address, the connection is rejected
+ * rather than tracked, so a flood of addresses cannot grow the table.
+ * @param address The IPv4 address of the client in network byte order.
+ * @param limit Set to the entry of the address on success, NULL otherwise.
+ * @return Returns 0 if the connection is admitted, or SERVICE_UNAVAILABLE if it is rejected.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int rate_limit_admit(uint32_t address, client_limit_t** limit) {
+    uint32_t now = now_ms();
+    uint32_t slot = (address * 2654435761u) >> 20;
+    client_limit_t* entry = NULL;
+    client_limit_t* unused = NULL;
+
+    *limit = NULL;
+
+    for (int probe = 0; probe < RATE_LIMIT_PROBES; probe++) {
+        client_limit_t* candidate = &table[(slot + probe) & (RATE_LIMIT_TABLE_SIZE - 1)];
+        if (candidate->address == address) {
+            entry = candidate;
+            break;
+        }
+        if (!unused) {
+            if (candidate->address != 0 && candidate->connections == 0) refill(candidate, now);
+            if (candidate->address == 0 || (candidate->connections == 0 && (!request_rate || candidate->tokens == request_rate * 1000))) {
+                unused = candidate;
+            }
+        }
+    }
+
+    if (!entry) {
+        if (!unused) {
+            rejections++;
+            return SERVICE_UNAVAILABLE;
+        }
+        entry = unused;
+        entry->address = address;
+        entry->connections = 0;
+        entry->tokens = request_rate * 1000;
+        entry->refilled_ms = now;
+    }
+
+    if (entry->connections >= connection_limit) {
+        rejections++;
+        return SERVICE_UNAVAILABLE;
+    }
+
+    entry->connections++;
+    *limit = entry;
+    return 0;
+}
+
+/**
+ * @brief Spends a token of a client address on a request.
+ * @param limit The entry returned by rate_limit_admit.
+ * @return Returns true if the request may be served, false if the address is out of tokens.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool rate_limit_take(client_limit_t* limit) {
+    if (!request_rate) return true;
+
+    refill(limit, now_ms());
+    if (limit->tokens < 1000) {
+        rejections++;
+        return false;
+    }
+    limit->tokens -= 1000;
+    return true;
+}
+
+/**
+ * @brief Stops counting a closed connection against its address.
+ * @param limit The entry returned by rate_limit_admit.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void rate_limit_release(client_limit_t* limit) {
+    limit->connections--;
+}
+
+/**
+ * @brief Gets the number of connections and requests rejected by the limits.
+ * @return Returns the number of rejections.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t rate_limit_get_rejections() {
+    return rejections;
+}
+
+/**
+ * @brief Adds the tokens earned since the last refill to a bucket.
+ * @details Tokens are earned at request_rate per second, up to a full bucket of request_rate requests.
+ * @param limit The entry of an address.
+ * @param now The current time in milliseconds.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void refill(client_limit_t* limit, uint32_t now) {
+    uint32_t capacity = request_rate * 1000;
+    uint64_t earned = (uint64_t)(uint32_t)(now - limit->refilled_ms) * request_rate;
+
+    limit->tokens = earned >= capacity - limit->tokens ? capacity : limit->tokens + (uint32_t)earned;
+    limit->refilled_ms = now;
+}
+
+/**
+ * @brief Reads the coarse monotonic clock.
+ * @return Returns the current time in milliseconds, truncated to 32 bits.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint32_t now_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000);
+}
@@ -0,0 +1,27 @@
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file rate_limit.h
+/// @brief Contains function declarations for per-client admission control.
+/// @details Each client address gets an entry in a fixed-size hash table that counts its open connections and holds a token bucket
+/// of requests. Connections over the connection limit are answered with 503, and requests without a token with 429.
+
+// The admission state of a client address.
+typedef struct {
+    uint32_t address;       // IPv4 address in network byte order, 0 for an unused entry.
+    uint32_t connections;   // Open connections from the address.
+    uint32_t tokens;        // Requests the address may still make, in thousandths of a request.
+    uint32_t refilled_ms;   // When the bucket was last refilled, on the monotonic clock. Wraps after 49 days.
+} client_limit_t;
+
+void rate_limit_configure(uint32_t max_connections, uint32_t rate);
+int rate_limit_admit(uint32_t address, client_limit_t** limit);
+bool rate_limit_take(client_limit_t* limit);
+void rate_limit_release(client_limit_t* limit);
+size_t rate_limit_get_rejections();
+
+#endif
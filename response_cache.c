@@ -0,0 +1,224 @@
+/// @file response_cache.c
+/// @brief Contains a cache of pre-serialized responses.
+/// @details This file includes functions to store the complete wire bytes of cacheable responses and to look them up again. Every entry
+/// carries the version of the data it was built from, e.g. the write sequence of a stored value or the identity of a file, and a lookup
+/// only hits if the caller's current version matches, so entries never have to be invalidated explicitly. When the cache is full, cold
+/// entries are evicted with the CLOCK policy, like stored values.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "network_utils.h"
+#include "response_cache.h"
+
+#define RESPONSE_CACHE_BUCKETS 256
+#define RESPONSE_CACHE_MAX (4 * 1024 * 1024)
+
+static cached_response_t* buckets[RESPONSE_CACHE_BUCKETS];
+static cached_response_t* clock_hand = NULL;
+static size_t cached_bytes = 0;
+static size_t hits = 0;
+static size_t misses = 0;
+static size_t evictions = 0;
+
+static cached_response_t* clock_candidate();
+
+/**
+ * @brief Finds the bucket of a key.
+ * @param key The cache key.
+ * @return Returns a pointer to the head of the bucket chain.
+ * @note Time complexity: O(n) where n is the length of the key. Space complexity: O(1).
+ */
+static cached_response_t** bucket_of(const char* key) {
+    size_t hash = 5381;
+    for (const char* c = key; *c; c++) {
+        hash = hash * 33 + (unsigned char)*c;
+    }
+    return &buckets[hash % RESPONSE_CACHE_BUCKETS];
+}
+
+/**
+ * @brief Looks up a cached response.
+ * @details This function returns the entry of the key if it was built from the given version, pinning it until response_cache_release is called.
+ * @param key The cache key, e.g. the request path.
+ * @param version The current version of the data behind the response.
+ * @return Returns a pointer to the pinned entry, or NULL on a miss.
+ * @note Time complexity: O(n) where n is the length of the key, on average. Space complexity: O(1).
+ */
+cached_response_t* response_cache_lookup(const char* key, uint64_t version) {
+    for (cached_response_t* entry = *bucket_of(key); entry; entry = entry->next) {
+        if (strcmp(entry->key, key) == 0) {
+            if (entry->version != version) break;
+
+            hits++;
+            entry->referenced = true;
+            entry->refcount++;
+            return entry;
+        }
+    }
+
+    misses++;
+    return NULL;
+}
+
+/**
+ * @brief Unlinks a cache entry and frees it unless it is pinned.
+ * @param link Pointer to the link pointing at the entry.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void evict(cached_response_t** link) {
+    cached_response_t* entry = *link;
+    *link = entry->next;
+    cached_bytes -= entry->capacity;
+
+    if (entry->clock_next == entry) {
+        clock_hand = NULL;
+    } else {
+        entry->clock_prev->clock_next = entry->clock_next;
+        entry->clock_next->clock_prev = entry->clock_prev;
+        if (clock_hand == entry) clock_hand = entry->clock_next;
+    }
+
+    // A pinned entry is freed by the last response_cache_release.
+    entry->evicted = true;
+    if (entry->refcount == 0) {
+        free(entry->bytes);
+        free(entry);
+    }
+}
+
+/**
+ * @brief Stores the wire bytes of a response.
+ * @details This function serializes the header and body into the entry of the key, reusing the entry's buffer when it is not pinned
+ * and large enough. Cold entries are evicted to make room for responses that would push the cache over RESPONSE_CACHE_MAX bytes,
+ * responses larger than the whole cache are not stored.
+ * @param key The cache key, e.g. the request path.
+ * @param version The version of the data the response was built from.
+ * @param header The response header.
+ * @param header_size The size of the header.
+ * @param body The response body.
+ * @param body_size The size of the body.
+ * @return Returns a pointer to the entry, pinned like a lookup result, or NULL if the response was not stored.
+ * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(n).
+ */
+cached_response_t* response_cache_store(const char* key, uint64_t version, const char* header, size_t header_size, const char* body, size_t body_size) {
+    cached_response_t** link = bucket_of(key);
+    size_t length = header_size + body_size;
+
+    while (*link && strcmp((*link)->key, key) != 0) {
+        link = &(*link)->next;
+    }
+
+    cached_response_t* entry = *link;
+    if (entry && (entry->refcount > 0 || entry->capacity < length)) {
+        evict(link);
+        entry = NULL;
+    }
+
+    if (!entry) {
+        if (length > RESPONSE_CACHE_MAX) return NULL;
+
+        while (cached_bytes + length > RESPONSE_CACHE_MAX) {
+            cached_response_t* victim = clock_candidate();
+            cached_response_t** victim_link = bucket_of(victim->key);
+            while (*victim_link != victim) {
+                victim_link = &(*victim_link)->next;
+            }
+            evict(victim_link);
+            evictions++;
+        }
+
+        size_t key_length = strlen(key);
+        entry = Malloc(sizeof(cached_response_t) + key_length + 1);
+        memcpy(entry->key, key, key_length + 1);
+        entry->bytes = Malloc(length);
+        entry->capacity = length;
+        entry->refcount = 0;
+        entry->evicted = false;
+        entry->referenced = false;
+
+        // Evictions may have unlinked the entries `link` pointed into, the bucket head is still valid.
+        cached_response_t** bucket = bucket_of(key);
+        entry->next = *bucket;
+        *bucket = entry;
+        cached_bytes += length;
+
+        // New entries go right behind the hand, so they are the last to be considered for eviction.
+        if (clock_hand) {
+            entry->clock_next = clock_hand;
+            entry->clock_prev = clock_hand->clock_prev;
+            clock_hand->clock_prev->clock_next = entry;
+            clock_hand->clock_prev = entry;
+        } else {
+            entry->clock_next = entry->clock_prev = entry;
+            clock_hand = entry;
+        }
+    }
+
+    memcpy(entry->bytes, header, header_size);
+    memcpy(entry->bytes + header_size, body, body_size);
+    entry->length = length;
+    entry->version = version;
+    entry->refcount++;
+
+    return entry;
+}
+
+/**
+ * @brief Unpins a cached response.
+ * @details This function drops a reference taken by a lookup or store, freeing the entry if it was evicted in the meantime.
+ * @param entry The entry to unpin.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void response_cache_release(cached_response_t* entry) {
+    entry->refcount--;
+
+    if (entry->refcount == 0 && entry->evicted) {
+        free(entry->bytes);
+        free(entry);
+    }
+}
+
+/**
+ * @brief Advances the clock hand to the next eviction candidate.
+ * @details Entries marked as referenced get a second chance: the mark is cleared and the hand moves past them. Pinned entries may be
+ * evicted, they are freed by their last release.
+ * @return Returns the candidate, the entry under the hand. The cache must not be empty.
+ * @note Time complexity: O(n) where n is the number of entries, O(1) amortized. Space complexity: O(1).
+ */
+static cached_response_t* clock_candidate() {
+    while (clock_hand->referenced) {
+        clock_hand->referenced = false;
+        clock_hand = clock_hand->clock_next;
+    }
+    return clock_hand;
+}
+
+/**
+ * @brief Gets the number of responses evicted to make room for others.
+ * @return Returns the number of evictions.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t response_cache_get_evictions() {
+    return evictions;
+}
+
+/**
+ * @brief Gets the number of cache hits.
+ * @return Returns the number of lookups that found a current entry.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t response_cache_get_hits() {
+    return hits;
+}
+
+/**
+ * @brief Gets the number of cache misses.
+ * @return Returns the number of lookups that found no current entry.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t response_cache_get_misses() {
+    return misses;
+}
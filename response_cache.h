@@ -0,0 +1,30 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Complete wire bytes (status line, headers and body) of a cacheable response.
+typedef struct cached_response {
+    struct cached_response* next;
+    struct cached_response* clock_prev;   // Ring swept by the clock hand, in insertion order.
+    struct cached_response* clock_next;
+    uint64_t version;
+    int refcount;
+    bool evicted;
+    bool referenced;                      // Looked up since the hand last passed.
+    char* bytes;
+    size_t length;
+    size_t capacity;
+    char key[];
+} cached_response_t;
+
+cached_response_t* response_cache_lookup(const char* key, uint64_t version);
+cached_response_t* response_cache_store(const char* key, uint64_t version, const char* header, size_t header_size, const char* body, size_t body_size);
+void response_cache_release(cached_response_t* entry);
+size_t response_cache_get_hits();
+size_t response_cache_get_misses();
+size_t response_cache_get_evictions();
+
+#endif
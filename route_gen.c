@@ -0,0 +1,173 @@
+/// @file route_gen.c
+/// @brief Build-time generator of the route table.
+/// @details This program reads routes.def and prints routes_gen.h: a table of routes indexed by route_hash, with a seed searched
+/// so that every (method, segment) pair lands in its own slot. The server then dispatches with one hash and one comparison.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "router.h"
+
+#define MAX_ROUTES 256
+#define MAX_NAME 128
+
+typedef struct {
+    char method[MAX_NAME];
+    char segment[MAX_NAME];
+    char exact[MAX_NAME];
+    char prefix[MAX_NAME];
+} route_spec_t;
+
+static route_spec_t routes[MAX_ROUTES];
+static int route_count = 0;
+
+/**
+ * @brief Finds or adds the route entry of a method and segment.
+ * @param method The HTTP method.
+ * @param segment The first path segment.
+ * @return Returns a pointer to the route entry.
+ * @note Time complexity: O(n) where n is the number of routes. Space complexity: O(1).
+ */
+static route_spec_t* route_entry(const char* method, const char* segment) {
+    for (int i = 0; i < route_count; i++) {
+        if (strcmp(routes[i].method, method) == 0 && strcmp(routes[i].segment, segment) == 0) return &routes[i];
+    }
+
+    if (route_count == MAX_ROUTES) {
+        fprintf(stderr, "route_gen: too many routes\n");
+        exit(EXIT_FAILURE);
+    }
+
+    route_spec_t* route = &routes[route_count++];
+    memset(route, 0x00, sizeof(route_spec_t));
+    strcpy(route->method, method);
+    strcpy(route->segment, segment);
+    return route;
+}
+
+/**
+ * @brief Parses the route definitions.
+ * @param file The route definition file.
+ * @param name The name of the file, for error messages.
+ * @return This function does not return a value. It exits on malformed definitions.
+ * @note Time complexity: O(n) where n is the size of the file. Space complexity: O(1).
+ */
+static void parse_routes(FILE* file, const char* name) {
+    char line[512];
+    int line_number = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+
+        char method[MAX_NAME], path[MAX_NAME], handler[MAX_NAME];
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        int fields = sscanf(line, "%127s %127s %127s", method, path, handler);
+        if (fields <= 0) continue;
+        if (fields != 3 || path[0] != '/') {
+            fprintf(stderr, "%s:%d: expected <method> <path> <handler>\n", name, line_number);
+            exit(EXIT_FAILURE);
+        }
+
+        // Split "/read/<key>" into the segment "/read" and a parameter.
+        char* parameter = strchr(path + 1, '/');
+        bool is_prefix = parameter != NULL;
+        if (is_prefix) {
+            size_t parameter_length = strlen(parameter);
+            if (parameter[1] != '<' || parameter[parameter_length - 1] != '>' || strchr(parameter + 1, '/')) {
+                fprintf(stderr, "%s:%d: only /<segment> and /<segment>/<parameter> paths are supported\n", name, line_number);
+                exit(EXIT_FAILURE);
+            }
+            *parameter = '\0';
+        }
+
+        route_spec_t* route = route_entry(method, path);
+        char* slot = is_prefix ? route->prefix : route->exact;
+        if (slot[0]) {
+            fprintf(stderr, "%s:%d: duplicate route %s %s\n", name, line_number, method, path);
+            exit(EXIT_FAILURE);
+        }
+        strcpy(slot, handler);
+    }
+}
+
+/**
+ * @brief Searches for a seed that maps every route to its own slot.
+ * @param table_size The number of slots, a power of two.
+ * @param seed Output for the seed found.
+ * @return Returns true if a seed was found, false otherwise.
+ * @note Time complexity: O(s * n) where s is the number of seeds tried and n the number of routes. Space complexity: O(t).
+ */
+static bool find_seed(uint32_t table_size, uint32_t* seed) {
+    bool* used = calloc(table_size, sizeof(bool));
+
+    for (uint32_t candidate = 1; candidate < 1000000; candidate++) {
+        memset(used, 0x00, table_size * sizeof(bool));
+        bool collision = false;
+
+        for (int i = 0; i < route_count && !collision; i++) {
+            uint32_t slot = route_hash(routes[i].method, routes[i].segment, strlen(routes[i].segment), candidate) & (table_size - 1);
+            collision = used[slot];
+            used[slot] = true;
+        }
+
+        if (!collision) {
+            *seed = candidate;
+            free(used);
+            return true;
+        }
+    }
+
+    free(used);
+    return false;
+}
+
+/**
+ * @brief Entry point of the route generator.
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line arguments. The second argument is the route definition file.
+ * @return Returns 0 on success.
+ * @note Time complexity: O(s * n) where s is the number of seeds tried and n the number of routes. Space complexity: O(n).
+ */
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s routes.def\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE* file = fopen(argv[1], "r");
+    if (!file) {
+        perror("route_gen");
+        return EXIT_FAILURE;
+    }
+    parse_routes(file, argv[1]);
+    fclose(file);
+
+    uint32_t table_size = 4;
+    while (table_size < 2 * (uint32_t)route_count) {
+        table_size *= 2;
+    }
+
+    uint32_t seed;
+    while (!find_seed(table_size, &seed)) {
+        table_size *= 2;
+    }
+
+    printf("// Generated by route_gen from %s, do not edit.\n\n", argv[1]);
+    printf("#define ROUTE_TABLE_SIZE %uu\n", table_size);
+    printf("#define ROUTE_HASH_SEED %uu\n\n", seed);
+    printf("static const route_t route_table[ROUTE_TABLE_SIZE] = {\n");
+
+    for (int i = 0; i < route_count; i++) {
+        route_spec_t* route = &routes[i];
+        uint32_t slot = route_hash(route->method, route->segment, strlen(route->segment), seed) & (table_size - 1);
+
+        printf("    [%u] = {\"%s\", \"%s\", %zu, %s, %s},\n", slot, route->method, route->segment, strlen(route->segment),
+            route->exact[0] ? route->exact : "NULL", route->prefix[0] ? route->prefix : "NULL");
+    }
+
+    printf("};\n");
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "client_session.h"
+
+/// @file router.h
+/// @brief Contains the route table types and the hash shared by the route generator and the server.
+/// @details Routes are declared in routes.def. At build time route_gen turns them into routes_gen.h, a table indexed by a
+/// collision-free hash of the method and the first path segment, so dispatching a request takes a single lookup.
+
+// Receives the part of the path after the route segment, e.g. "key" for "/read/key", or "" for exact routes.
+typedef void (*route_handler_t)(const char* path, client_session_t* client_info);
+
+typedef struct {
+    const char* method;
+    const char* segment;
+    size_t segment_length;
+    route_handler_t exact;
+    route_handler_t prefix;
+} route_t;
+
+/**
+ * @brief Hashes a method and a path segment.
+ * @details FNV-1a over the method, a separating space and the segment, mixed with a seed chosen by route_gen so that no two routes collide.
+ * @param method The HTTP method.
+ * @param segment The first path segment, including its leading slash.
+ * @param segment_length The length of the segment.
+ * @param seed The seed of the route table.
+ * @return Returns the hash value.
+ * @note Time complexity: O(n) where n is the length of the method and segment. Space complexity: O(1).
+ */
+static inline uint32_t route_hash(const char* method, const char* segment, size_t segment_length, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+
+    for (const char* c = method; *c; c++) {
+        hash = (hash ^ (unsigned char)*c) * 16777619u;
+    }
+    hash = (hash ^ ' ') * 16777619u;
+    for (size_t i = 0; i < segment_length; i++) {
+        hash = (hash ^ (unsigned char)segment[i]) * 16777619u;
+    }
+
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+#endif
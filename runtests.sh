@@ -5,8 +5,15 @@
 # example: ./runtests.sh 01-connect     // runs all tests in tests/01-connect/
 #          ./runtests.sh 01-connect 01  // runs tests/01-connect/01.sh
 #          ./runtests.sh 01 01          // runs tests/01-connect/01.sh
-
-EXEC=hw5
+#
+# usage: ./runtests.sh --perf           // compares the benchmarks in perf/ with perf/baseline
+#        ./runtests.sh --perf-update    // records the benchmarks in perf/ as the new baseline
+#
+# The baseline holds absolute numbers that only hold for the host they were recorded on, so it is not committed. Record it on
+# each host with --perf-update before the change to compare, then run --perf with the change.
+
+EXEC=main
+export EXEC
 DUMMY=test
 OUTPUT=output
 DIFF=output.diff
@@ -21,6 +28,13 @@ RESET='\033[0m'
 
 export ASAN_OPTIONS="detect_leaks=false"
 
+PERF_DIR=perf
+PERF_BASELINE=${PERF_DIR}/baseline
+# Runs of each benchmark, the median of which is compared with the baseline.
+PERF_RUNS=${PERF_RUNS:-5}
+# Drop in percent a benchmark may show before it fails, widened to the spread of its runs or of the baseline's runs if that is larger.
+PERF_TOLERANCE=${PERF_TOLERANCE:-10}
+
 
 function free_port
 {
@@ -73,6 +87,77 @@ function reset_server
 }
 
 
+# Runs every benchmark in perf/ against a fresh server. A benchmark prints a single number, higher being better. Its median over
+# PERF_RUNS runs is compared with the baseline, or recorded as the new baseline with --perf-update.
+function run_perf
+{
+    make bench/latency bench/micro || return 1
+
+    FAILURES=0
+    RECORDED="# benchmark, median, spread in percent, recorded with ./runtests.sh --perf-update on $(uname -n)\n"
+    for SCRIPT in $(find ${PERF_DIR} -type f -name "*.sh" | sort); do
+        BENCHMARK=$(basename ${SCRIPT} .sh)
+        printf "${BLUE} Running Perf ${BENCHMARK} ${RESET}\n"
+        reset_server # sets PID
+        if [[ $? -ne 0 ]]; then
+            printf "${RED} Perf ${BENCHMARK} FAILED ${RESET}\n"
+            ((FAILURES++))
+            continue
+        fi
+
+        SAMPLES=()
+        for ((RUN = 0; RUN < PERF_RUNS; RUN++)); do
+            SAMPLES+=($(./${SCRIPT} ${PORT}))
+        done
+        kill -9 ${PID} >/dev/null 2>&1
+        wait ${PID} >/dev/null 2>&1
+
+        if [[ ${#SAMPLES[@]} -ne ${PERF_RUNS} ]] || printf "%s\n" "${SAMPLES[@]}" | grep -qvE '^[0-9]+(\.[0-9]+)?$'; then
+            printf "Benchmark printed: ${SAMPLES[*]}\n"
+            printf "${RED} Perf ${BENCHMARK} FAILED ${RESET}\n"
+            ((FAILURES++))
+            continue
+        fi
+
+        # The spread is the interquartile range of the runs relative to their median, so a single outlier does not widen it.
+        read MEDIAN SPREAD <<< $(printf "%s\n" "${SAMPLES[@]}" | sort -g | awk '{ v[NR] = $1 }
+            function quantile(p,  h, l) { h = 1 + (NR - 1) * p; l = int(h); return v[l] + (h - l) * (v[l + 1] - v[l]) }
+            END { m = quantile(0.5); printf "%.1f %.1f\n", m, (quantile(0.75) - quantile(0.25)) * 100 / m }')
+
+        if [[ "$1" == "--perf-update" ]]; then
+            RECORDED+="${BENCHMARK} ${MEDIAN} ${SPREAD}\n"
+            printf "${BENCHMARK}: ${MEDIAN} (spread ${SPREAD}%%)\n"
+            printf "${GREEN} Perf ${BENCHMARK} RECORDED ${RESET}\n"
+            continue
+        fi
+
+        read BASELINE BASELINE_SPREAD <<< $(awk -v b=${BENCHMARK} '$1 == b { print $2, $3 }' ${PERF_BASELINE} 2>/dev/null)
+        if [[ -z "${BASELINE}" ]]; then
+            printf "${BENCHMARK}: ${MEDIAN}, no baseline, record one with ./runtests.sh --perf-update\n"
+            printf "${RED} Perf ${BENCHMARK} FAILED ${RESET}\n"
+            ((FAILURES++))
+            continue
+        fi
+
+        read CHANGE ALLOWED VERDICT <<< $(awk -v m=${MEDIAN} -v b=${BASELINE} -v s=${SPREAD} -v bs=${BASELINE_SPREAD} -v t=${PERF_TOLERANCE} \
+            'BEGIN { c = (m - b) * 100 / b; s = s > bs ? s : bs; a = t > s ? t : s
+                     printf "%+.1f %.1f %s\n", c, a, c < -a ? "FAILED" : "PASSED" }')
+        printf "${BENCHMARK}: ${MEDIAN}, baseline ${BASELINE} (${CHANGE}%%, fails below -${ALLOWED}%%, spread ${SPREAD}%%)\n"
+        if [[ "${VERDICT}" == "PASSED" ]]; then
+            printf "${GREEN} Perf ${BENCHMARK} PASSED ${RESET}\n"
+        else
+            printf "${RED} Perf ${BENCHMARK} FAILED ${RESET}\n"
+            ((FAILURES++))
+        fi
+    done
+
+    if [[ "$1" == "--perf-update" ]]; then
+        printf "${RECORDED}" >${PERF_BASELINE}
+    fi
+    [[ ${FAILURES} -eq 0 ]]
+}
+
+
 # START OF AUTOGRADER
 
 ulimit -n 100
@@ -104,6 +189,14 @@ if [[ ${PORT} -lt 1025 ]]; then
     exit 1
 fi
 
+if [[ "$1" == "--perf" || "$1" == "--perf-update" ]]; then
+    run_perf $1
+    RET=$?
+    free_port
+    rm -f pid
+    exit ${RET}
+fi
+
 
 for DIR in $(find ${TEST_DIR}/* -type d -name "${TEST_DIR_PAT}"); do
     for NAME in $(find ${DIR}/* -type f -name "${TEST_NAME_PAT}.sh" -exec basename {} \;|cut -d '.' -f1|sort --unique); do
@@ -6,19 +6,57 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
 #include <sys/stat.h>
 #include <sys/epoll.h>
 #include <assert.h>
 #include <string.h>
+#include <time.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <arpa/inet.h>
 #include "network_utils.h"
 #include "http_parser.h"
 #include "http_response.h"
 #include "constants.h"
 #include "http_errors.h"
+#include "http_method_handler.h"
 #include "client_session.h"
 #include "server_config.h"
+#include "wal.h"
+#include "rate_limit.h"
+#include "hot_restart.h"
+#include "overload.h"
+#include "busy_poll.h"
+#include "socket_profile.h"
+#include "cpu_affinity.h"
+#include "tls.h"
+#include "http2.h"
+#include "capture.h"
+#include "asset_pack.h"
+#include "probes.h"
+
+// Sessions whose response waits for the write-ahead log to be synced.
+static client_session_t* pending_responses = NULL;
+
+// Whether the listening sockets are monitored, they are not while accepting is paused.
+static bool listener_monitored = true;
+
+// User the clients of the UNIX socket listener must run as, -1 for any.
+static int unix_uid = -1;
+
+// Whether SIGTERM or SIGINT asked the server to stop.
+static volatile sig_atomic_t stop_requested = 0;
+
+static void finish_response(client_session_t* client_info);
+static void deliver_response(client_session_t* client_info);
+static void flush_pending_responses();
+static void request_stop(int signal);
+static void handle_session_event(client_session_t* client_info, uint32_t events);
+static void configure_listener(int listenfd);
+static int take_listener(int* listenfds, int count, int port, const char* path);
+static bool hand_over(int epfd, int* listenfd, int* tls_listenfd, int* unix_listenfd, int* controlfd);
 
 /**
  * @brief Creates a listening socket on the specified port.
@@ -44,22 +82,90 @@ int create_listening_socket(int port) {
     return listenfd;
 }
 
+/**
+ * @brief Creates a listening UNIX domain socket at the specified path.
+ * @details Clients on the same host reach the server through it without going through the TCP stack. A socket file left behind at
+ * the path is replaced, anything else there makes binding fail.
+ * @param path The path of the socket.
+ * @return Returns the file descriptor of the listening socket.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int create_unix_socket(const char* path) {
+    struct sockaddr_un server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
+
+    server_addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(server_addr.sun_path)) {
+        fprintf(stderr, "UNIX socket path too long\n");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(server_addr.sun_path, path);
+
+    int listenfd = Socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink_socket(path);
+    Bind(listenfd, (struct sockaddr *)&server_addr, sizeof(server_addr));
+    Listen(listenfd, BACKLOG);
+
+    return listenfd;
+}
+
 /**
  * @brief Accepts a new client connection.
- * @details This function accepts a new client connection and adds it to the epoll instance for monitoring.
+ * @details This function accepts a new client connection and adds it to the epoll instance for monitoring. A connection over the
+ * connection limit of its address is answered with 503 if the socket takes the response without blocking, or over TLS not at all,
+ * and closed right away, so idle connections cannot hold sessions and file descriptors beyond the limit. Running out of file
+ * descriptors pauses accepting until a session closes.
+ * Clients of the UNIX socket listener share the limits of the loopback address, which they would otherwise connect from, and
+ * their credentials are kept in the session. A client that does not run as the allowed user is answered with 403.
  * @param epfd The epoll file descriptor.
  * @param listenfd The file descriptor of the listening socket.
+ * @param secure Whether the connection is made to the HTTPS listener and starts with a TLS handshake.
  * @return This function does not return a value.
  * @note Time complexity: O(1). Space complexity: O(1).
  */
-void accept_client(int epfd, int listenfd) {
-    int clientfd = Accept(listenfd);
+void accept_client(int epfd, int listenfd, bool secure) {
+    struct sockaddr_storage client_addr;
+    int clientfd = Accept(listenfd, &client_addr);
+    if (clientfd < 0) {
+        if (errno == EMFILE || errno == ENFILE) {
+            overload_fds_exhausted(session_get_active());
+        }
+        return;
+    }
+
+    bool local = client_addr.ss_family == AF_UNIX;
+    uint32_t address = local ? htonl(INADDR_LOOPBACK) : ((struct sockaddr_in*)&client_addr)->sin_addr.s_addr;
+    client_limit_t* client_limit;
+    int rejection = rate_limit_admit(address, &client_limit);
 
-    client_session_t* client_info = Malloc(sizeof(client_session_t));
-    memset(client_info, 0x00, sizeof(client_session_t));
+    client_session_t* client_info = session_create(clientfd, epfd);
+    if (rejection) {
+        if (!secure) {
+            raise_http_error(rejection, client_info);
+            send(clientfd, client_info->header, client_info->HSIZE, MSG_DONTWAIT | MSG_NOSIGNAL);
+        }
+        session_destroy(client_info);
+        return;
+    }
+    client_info->client_limit = client_limit;
 
-    client_info->fd = clientfd;
-    client_info->epfd = epfd;
+    if (local) {
+        socklen_t length = sizeof(client_info->peer);
+        getsockopt(clientfd, SOL_SOCKET, SO_PEERCRED, &client_info->peer, &length);
+        if (!client_info->rejection && unix_uid >= 0 && client_info->peer.uid != (uid_t)unix_uid) {
+            client_info->rejection = FORBIDDEN;
+        }
+    }
+    PROBE_ACCEPT(client_info, clientfd, local);
+    if (!local) {
+        socket_profile_client(clientfd);
+    }
+    busy_poll_socket(clientfd);
+#ifdef HTTP_TLS
+    if (secure) {
+        tls_start(client_info);
+    }
+#endif
 
     struct epoll_event event;
     memset(&event, 0, sizeof(event));
@@ -70,6 +176,77 @@ void accept_client(int epfd, int listenfd) {
     Epoll_ctl(epfd, EPOLL_CTL_ADD, clientfd, &event);
 }
 
+/**
+ * @brief Checks whether a request has arrived in full.
+ * @details A request is complete once its head has ended and as much of its body has arrived as its Content-Length announces. The
+ * body of a chunked request is decoded as it arrives, so such a request is complete with its head.
+ * @param request The request received so far, terminated by a null byte.
+ * @param length The number of bytes received so far.
+ * @return Returns true if the request is complete, false if more of it is expected.
+ * @note Time complexity: O(n) where n is the length of the request. Space complexity: O(1).
+ */
+static bool request_complete(const char* request, size_t length) {
+    const char* head_end = strstr(request, "\r\n\r\n");
+    if (!head_end) return false;
+    if (is_chunked_transfer(request)) return true;
+
+    int content_length = extract_content_length(request);
+    return content_length <= 0 || length - (size_t)(head_end + 4 - request) >= (size_t)content_length;
+}
+
+/**
+ * @brief Receives data from a client into its request buffer.
+ * @details This function takes a request buffer from the pool on demand and receives into it until the request is complete, growing the
+ * buffer to the next size class whenever it fills up, up to REQUEST_MAX bytes. Only the first receive may block. A request whose rest
+ * has not arrived yet is kept in the buffer and continued on the next call, so a client sending its request in pieces holds up no
+ * other client. A client that closes its side of the connection before its request is complete has the part it sent served. The
+ * remainder of a streamed body is received with a single call since it is decoded straight out of the buffer.
+ * @param client_info Pointer to the client session information.
+ * @param complete Set to false if the request is incomplete and more of it is awaited, true otherwise.
+ * @return Returns the number of bytes of the request received so far, 0 if the client closed the connection, or -1 with errno set if
+ * the receive failed.
+ * @note Time complexity: O(n) where n is the size of the request. Space complexity: O(n).
+ */
+static ssize_t receive_request(client_session_t* client_info, bool* complete) {
+    *complete = true;
+
+    if (client_info->body_streaming_enabled) {
+        // One byte is kept for the terminating null byte.
+        char* request = session_reserve_request(client_info, 1);
+        return Recv(client_info->fd, request, client_info->request_capacity - 1, 0);
+    }
+
+    ssize_t bytes_recieved = client_info->request ? client_info->request_size : 0;
+    int flags = 0;
+    while (true) {
+        // One byte is kept for the terminating null byte.
+        if ((size_t)bytes_recieved + 1 >= client_info->request_capacity) {
+            if (client_info->request_capacity >= REQUEST_MAX) break;
+            client_info->request_size = bytes_recieved;
+            session_reserve_request(client_info, client_info->request_capacity + 1);
+        }
+
+        char* request = client_info->request;
+        ssize_t more = Recv(client_info->fd, request + bytes_recieved, client_info->request_capacity - 1 - bytes_recieved, flags);
+        if (more < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            client_info->request_size = bytes_recieved;
+            *complete = false;
+            break;
+        }
+        if (more <= 0) {
+            if (bytes_recieved == 0) return more;
+            break;
+        }
+
+        bytes_recieved += more;
+        request[bytes_recieved] = '\0';
+        if (request_complete(request, bytes_recieved)) break;
+        flags = MSG_DONTWAIT;
+    }
+
+    return bytes_recieved;
+}
+
 /**
  * @brief Processes a client request.
  * @details This function receives data from the client, processes the request, and sends the appropriate response.
@@ -79,33 +256,111 @@ void accept_client(int epfd, int listenfd) {
  * @note Time complexity: O(n) where n is the size of the request. Space complexity: O(1).
  */
 void process_client_request(client_session_t* client_info) {
-    memset(client_info->request, 0, sizeof(client_info->request));
-
-    ssize_t bytes_recieved = Recv(client_info->fd, client_info->request, RMAX, 0);
+    TRACE_START(client_info);
+    bool complete;
+    ssize_t bytes_recieved = receive_request(client_info, &complete);
 
     if (bytes_recieved <= 0) {
-        close(client_info->fd);
-        free(client_info);
+        if (bytes_recieved < 0) {
+            access_log_set_error(&client_info->log_record, errno);
+        }
+        abort_body_stream(client_info);
+        session_destroy(client_info);
+        return;
+    }
+
+    // The rest of the request is received once it arrives.
+    if (!complete) return;
+
+    access_log_start(&client_info->log_record);
+    TRACE_STAMP(client_info, TRACE_RECV);
+
+    // The rest of a chunked body is decoded straight out of the receive buffer.
+    if (client_info->body_streaming_enabled) {
+        handle_body_stream(client_info->request, bytes_recieved, client_info);
+        if (!client_info->body_streaming_enabled) {
+            finish_response(client_info);
+        }
         return;
     }
 
+    // A connection that starts with the client preface speaks HTTP/2 from then on.
+    if (http2_preface(client_info->request, bytes_recieved)) {
+        http2_start(client_info, bytes_recieved);
+        return;
+    }
+
+    client_info->rejection = admit_request(client_info, client_info->request);
+
     // Upadting the request size and request buffer.
     client_info->request_size = bytes_recieved;
     client_info->request[bytes_recieved] = '\0';
 
-    char method[1024], path[1024];
-    if (parse_request(client_info->request, method, 1024, path, 1024) < 0) {
-        raise_http_error(BAD_REQUEST, client_info);
+    if (!client_info->rejection && http2_upgrade(client_info)) return;
 
-        Send(client_info);
-        close(client_info->fd);
-        free(client_info);
+    serve_request(client_info);
+}
+
+/**
+ * @brief Decides whether a request is served.
+ * @details Rejected and shed requests are answered without parsing or routing them. Health checks are never shed. Every other
+ * request takes a token of its client, the client of the connection for the streams of an HTTP/2 connection.
+ * @param connection Pointer to the session of the connection the request arrived on.
+ * @param request The request.
+ * @return Returns 0 if the request is served, or the status to answer it with instead.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int admit_request(const client_session_t* connection, const char* request) {
+    if (connection->rejection) return connection->rejection;
+
+    if (overload_shedding() && strncmp(request, "GET /ping ", 10) != 0) {
+        overload_count_shed();
+        return SERVICE_UNAVAILABLE;
+    }
+    if (!rate_limit_take(connection->client_limit)) return TOO_MANY_REQUESTS;
+
+    return 0;
+}
+
+/**
+ * @brief Serves a complete request.
+ * @details This function parses the request, generates its response and sends it, or answers with the rejection status of the session.
+ * Requests are captured before they are admitted, so a trace holds the traffic that arrived rather than the traffic that was served.
+ * A file response of an HTTP/1.1 connection is sent in chunks as the socket becomes writable.
+ * @param client_info Pointer to the client session information, holding a null-terminated request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the request. Space complexity: O(n).
+ */
+void serve_request(client_session_t* client_info) {
+    capture_request(client_info->request, client_info->request_size);
+
+    if (client_info->rejection) {
+        raise_http_error(client_info->rejection, client_info);
+        finish_response(client_info);
+        return;
+    }
+
+    // The request line can be no longer than the request itself.
+    size_t line_size = client_info->request_size + 1;
+    char* method = session_scratch(client_info, line_size);
+    char* path = session_scratch(client_info, line_size);
+    if (parse_request(client_info->request, method, line_size, path, line_size) < 0) {
+        raise_http_error(BAD_REQUEST, client_info);
+        finish_response(client_info);
         return;
     }
+    access_log_set_request(&client_info->log_record, method, path);
+    PROBE_REQUEST_PARSED(client_info, method, path);
+    TRACE_STAMP(client_info, TRACE_PARSE);
+    TRACE_REQUEST(client_info, path);
 
     generate_response(method, path, client_info);
+    TRACE_STAMP(client_info, TRACE_HANDLER);
+
+    // Wait for the rest of a chunked request body before responding.
+    if (client_info->body_streaming_enabled) return;
 
-    if (client_info->body_chunking_enabled) {
+    if (client_info->body_chunking_enabled && !client_info->stream) {
         Epoll_ctl(client_info->epfd, EPOLL_CTL_DEL, client_info->fd, NULL);
 
         struct epoll_event event;
@@ -114,22 +369,153 @@ void process_client_request(client_session_t* client_info) {
         event.data.ptr = (void*)client_info;
         Epoll_ctl(client_info->epfd, EPOLL_CTL_ADD, client_info->fd, &event);
     } else {
-        Send(client_info);
-        close(client_info->fd);
-        free(client_info);
+        finish_response(client_info);
+    }
+
+}
+
+/**
+ * @brief Sends a response and closes the connection.
+ * @details A response acknowledging a logged write is deferred until the write-ahead log has been synced at the end of the event loop iteration.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(1).
+ */
+static void finish_response(client_session_t* client_info) {
+    if (client_info->wal_sync_pending) {
+        client_info->next_pending = pending_responses;
+        pending_responses = client_info;
+        return;
     }
 
+    deliver_response(client_info);
 }
 
 /**
- * @brief Runs the server on the specified port.
+ * @brief Sends a response that is ready.
+ * @details The response of an HTTP/2 stream is handed to its connection, any other is sent before the connection is closed.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the response. Space complexity: O(1).
+ */
+static void deliver_response(client_session_t* client_info) {
+    PROBE_RESPONSE_START(client_info);
+    if (client_info->stream) {
+        http2_respond(client_info);
+        return;
+    }
+
+    Send(client_info);
+    session_destroy(client_info);
+}
+
+/**
+ * @brief Syncs the write-ahead log and sends the responses waiting for it.
+ * @details All writes of an event loop iteration share a single write and fdatasync of the log.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the deferred responses. Space complexity: O(1).
+ */
+static void flush_pending_responses() {
+    wal_sync();
+
+    while (pending_responses) {
+        client_session_t* client_info = pending_responses;
+        pending_responses = client_info->next_pending;
+
+        deliver_response(client_info);
+    }
+}
+
+/**
+ * @brief Runs the server with the specified options.
  * @details This function initializes the server, creates an epoll instance, and enters an event loop to handle incoming connections and client requests.
- * @param port The port number on which the server will listen for incoming connections.
+ * The event loop is pinned to its core first, then the storage budget is applied, then, when persistence is enabled, the stored values are recovered from the write-ahead log before
+ * the first connection is accepted. With a control socket, the listening socket is taken over from the server running there if any,
+ * and once a newer server takes it over in turn, the loop ends after the open connections have been finished. SIGTERM and SIGINT end
+ * the loop right away, and the server closes its logs and removes its control socket before it exits.
+ * @param options The server options.
  * @return This function does not return a value.
  * @note Time complexity: O(n) where n is the number of events. Space complexity: O(1).
  */
-void run_server(int port) {
-    int listenfd = create_listening_socket(port);
+void run_server(const server_options_t* options) {
+    // Pin first, so that everything allocated below is placed on the memory of the core's node.
+    if (options->loop_cpu >= 0 && affinity_pin_loop(options->loop_cpu) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    if (options->memory_limit || options->admission) {
+        storage_configure(options->memory_limit ? options->memory_limit : storage_get_memory_limit(), options->admission);
+    }
+
+    rate_limit_configure(options->client_connections, options->client_rate);
+    overload_configure(options->max_delay_us, options->max_sessions);
+    busy_poll_configure(options->busy_poll_us);
+
+    if (options->socket_profile && socket_profile_parse(options->socket_profile) < 0) {
+        fprintf(stderr, "Invalid socket profile: %s\n", options->socket_profile);
+        exit(EXIT_FAILURE);
+    }
+
+    // Take over from a running server before opening the log, which that server syncs when handing over.
+    int listenfds[RESTART_MAX_LISTENERS] = { -1, -1, -1 };
+    int inherited = 0;
+    if (options->control_path) {
+        inherited = restart_take_over(options->control_path, !options->wal_path, listenfds);
+    }
+
+    if (options->wal_path && wal_open(options->wal_path) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    if (options->access_log_path && access_log_open(options->access_log_path) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    if (options->capture_path && capture_open(options->capture_path, options->capture_sample) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    if (options->assets_path && pack_open(options->assets_path) < 0) {
+        exit(EXIT_FAILURE);
+    }
+
+    int listenfd = take_listener(listenfds, inherited, options->port, NULL);
+    if (listenfd < 0) {
+        listenfd = create_listening_socket(options->port);
+    }
+    // Also applied to inherited listeners, so the profile and the core take effect across a hot restart.
+    configure_listener(listenfd);
+
+    int tls_listenfd = -1;
+#ifdef HTTP_TLS
+    if (options->tls_port) {
+        if (tls_init(options->tls_certificate, options->tls_key) < 0) {
+            exit(EXIT_FAILURE);
+        }
+        tls_listenfd = take_listener(listenfds, inherited, options->tls_port, NULL);
+        if (tls_listenfd < 0) {
+            tls_listenfd = create_listening_socket(options->tls_port);
+        }
+        configure_listener(tls_listenfd);
+    }
+#endif
+
+    int unix_listenfd = -1;
+    if (options->unix_path) {
+        unix_uid = options->unix_uid;
+        unix_listenfd = take_listener(listenfds, inherited, 0, options->unix_path);
+        if (unix_listenfd < 0) {
+            unix_listenfd = create_unix_socket(options->unix_path);
+        }
+    }
+
+    // Listeners of the old server that this one is not configured for are closed.
+    for (int i = 0; i < inherited; i++) {
+        if (listenfds[i] >= 0) {
+            close(listenfds[i]);
+        }
+    }
+    int controlfd = options->control_path ? restart_listen(options->control_path) : -1;
 
     /**
      * epoll_create1() system call creates a new epoll instance and returns a file descriptor referring to that instance.
@@ -157,22 +543,235 @@ void run_server(int port) {
 
     Epoll_ctl(epfd, EPOLL_CTL_ADD, listenfd, &event);
 
-     while (1) {
-        int num_events = epoll_wait(epfd, events, MAX_EVENTS, TIME_OUT);
+    if (tls_listenfd >= 0) {
+        event.data.fd = tls_listenfd;
+        Epoll_ctl(epfd, EPOLL_CTL_ADD, tls_listenfd, &event);
+    }
+
+    if (unix_listenfd >= 0) {
+        event.data.fd = unix_listenfd;
+        Epoll_ctl(epfd, EPOLL_CTL_ADD, unix_listenfd, &event);
+    }
+
+    if (controlfd >= 0) {
+        event.data.fd = controlfd;
+        Epoll_ctl(epfd, EPOLL_CTL_ADD, controlfd, &event);
+    }
+
+    // Without SA_RESTART, the signals interrupt the wait for events.
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = request_stop;
+    sigaction(SIGTERM, &stop, NULL);
+    sigaction(SIGINT, &stop, NULL);
+
+    // After a handoff, the open connections are finished for up to DRAIN_TIMEOUT seconds.
+    time_t drain_deadline = 0;
+
+    while (!stop_requested && (!drain_deadline || (session_get_active() > 0 && time(NULL) < drain_deadline))) {
+        // While draining or overloaded, wake up regularly so the loop notices when it is done or the load has dropped.
+        bool waking = drain_deadline || overload_shedding() || !listener_monitored;
+        int num_events = busy_poll_wait(epfd, events, MAX_EVENTS, waking ? IDLE_POLL_MS : TIME_OUT);
+        uint64_t ready_us = overload_now_us();
+
+        if (num_events <= 0) {
+            overload_record_delay(0);
+        }
 
         for (int i = 0; i < num_events; i++) {
-            if (events[i].events == EPOLLIN) {
-                if (events[i].data.fd == listenfd) {
-                    accept_client(epfd, listenfd);
-                } else {
-                    client_session_t* client_info = (client_session_t*) events[i].data.ptr;
-                    process_client_request(client_info);
+            // The queueing delay is how long the last event of the batch waited for the ones handled before it.
+            if (i == num_events - 1) {
+                overload_record_delay(overload_now_us() - ready_us);
+            }
+
+            if (events[i].data.fd == listenfd) {
+                accept_client(epfd, listenfd, false);
+            } else if (tls_listenfd >= 0 && events[i].data.fd == tls_listenfd) {
+                accept_client(epfd, tls_listenfd, true);
+            } else if (unix_listenfd >= 0 && events[i].data.fd == unix_listenfd) {
+                accept_client(epfd, unix_listenfd, false);
+            } else if (controlfd >= 0 && events[i].data.fd == controlfd) {
+                if (hand_over(epfd, &listenfd, &tls_listenfd, &unix_listenfd, &controlfd)) {
+                    drain_deadline = time(NULL) + DRAIN_TIMEOUT;
+                    // The remaining events may refer to the closed sockets, the others are reported again.
+                    break;
                 }
-            } else if (events[i].events == EPOLLOUT) {
-                client_session_t* client_info = (client_session_t*) events[i].data.ptr;
-                Send(client_info);
+            } else {
+                handle_session_event((client_session_t*) events[i].data.ptr, events[i].events);
             }
         }
+
+        if (pending_responses) {
+            flush_pending_responses();
+        }
+
+        // Accepting pauses and resumes on every listener at once, the sessions of all of them count towards the threshold.
+        if (listenfd >= 0 && overload_should_accept(session_get_active()) != listener_monitored) {
+            listener_monitored = !listener_monitored;
+            const int listeners[] = { listenfd, tls_listenfd, unix_listenfd };
+            for (size_t i = 0; i < sizeof(listeners) / sizeof(listeners[0]); i++) {
+                if (listeners[i] < 0) continue;
+                event.events = EPOLLIN;
+                event.data.fd = listeners[i];
+                Epoll_ctl(epfd, listener_monitored ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, listeners[i], &event);
+            }
+        }
+    }
+    wal_close();
+    access_log_close();
+    capture_close();
+    pack_close();
+    storage_free_all();
+    if (listenfd >= 0) {
+        close(listenfd);
     }
-    close(listenfd);
-}
\ No newline at end of file
+    if (tls_listenfd >= 0) {
+        close(tls_listenfd);
+    }
+    if (unix_listenfd >= 0) {
+        close(unix_listenfd);
+    }
+    if (controlfd >= 0) {
+        restart_close(controlfd, options->control_path);
+    }
+}
+
+/**
+ * @brief Asks the event loop to stop, on SIGTERM and SIGINT.
+ * @param signal Unused.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void request_stop(int signal) {
+    stop_requested = 1;
+}
+
+/**
+ * @brief Applies the socket profile and the event loop's core to a TCP listening socket, created or inherited.
+ * @details With the event loop pinned, the listener prefers connections whose packets are processed on its core. Failing to set
+ * that only costs locality.
+ * @param listenfd The listening socket.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void configure_listener(int listenfd) {
+    socket_profile_listener(listenfd);
+
+    int cpu = affinity_loop_cpu();
+    if (cpu >= 0) {
+        setsockopt(listenfd, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+    }
+}
+
+/**
+ * @brief Takes a listening socket handed over by the old server.
+ * @details Listeners are matched by their address, so a server configured with other listeners than the old one gets the right ones.
+ * @param listenfds The listening sockets handed over, the one taken is set to -1.
+ * @param count The number of listening sockets handed over, or -1 if there was no handover.
+ * @param port The port of the TCP listener to take, unused for a UNIX one.
+ * @param path The path of the UNIX listener to take, or NULL for a TCP one.
+ * @return Returns the listening socket, or -1 if the old server did not have it.
+ * @note Time complexity: O(n) where n is the number of listening sockets. Space complexity: O(1).
+ */
+static int take_listener(int* listenfds, int count, int port, const char* path) {
+    for (int i = 0; i < count; i++) {
+        struct sockaddr_un address;
+        socklen_t length = sizeof(address);
+        memset(&address, 0, sizeof(address));
+        if (listenfds[i] < 0 || getsockname(listenfds[i], (struct sockaddr*)&address, &length) < 0) continue;
+
+        bool match = path ? address.sun_family == AF_UNIX && strcmp(address.sun_path, path) == 0
+                          : address.sun_family == AF_INET && ntohs(((struct sockaddr_in*)&address)->sin_port) == port;
+        if (match) {
+            int listenfd = listenfds[i];
+            listenfds[i] = -1;
+            return listenfd;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Hands the listening sockets over to a new server.
+ * @details On success this server stops accepting and refuses further writes, since its stored values have moved to the new server.
+ * The write-ahead log is synced first, so a new server replaying it sees every write.
+ * @param epfd The epoll file descriptor.
+ * @param listenfd The listening socket, set to -1 once handed over.
+ * @param tls_listenfd The HTTPS listening socket or -1, set to -1 once handed over.
+ * @param unix_listenfd The UNIX listening socket or -1, set to -1 once handed over.
+ * @param controlfd The control socket, set to -1 once handed over.
+ * @return Returns true if the new server took over, false otherwise.
+ * @note Time complexity: O(n) where n is the size of the stored values. Space complexity: O(n).
+ */
+static bool hand_over(int epfd, int* listenfd, int* tls_listenfd, int* unix_listenfd, int* controlfd) {
+    int listenfds[RESTART_MAX_LISTENERS] = { *listenfd };
+    int count = 1;
+    if (*tls_listenfd >= 0) {
+        listenfds[count++] = *tls_listenfd;
+    }
+    if (*unix_listenfd >= 0) {
+        listenfds[count++] = *unix_listenfd;
+    }
+
+    wal_sync();
+    if (restart_hand_over(*controlfd, listenfds, count) < 0) return false;
+
+    storage_set_read_only();
+
+    // Paused listeners are not monitored.
+    if (listener_monitored) {
+        Epoll_ctl(epfd, EPOLL_CTL_DEL, *listenfd, NULL);
+    }
+    Epoll_ctl(epfd, EPOLL_CTL_DEL, *controlfd, NULL);
+    close(*listenfd);
+    close(*controlfd);
+    *listenfd = -1;
+    *controlfd = -1;
+
+    if (*tls_listenfd >= 0) {
+        if (listener_monitored) {
+            Epoll_ctl(epfd, EPOLL_CTL_DEL, *tls_listenfd, NULL);
+        }
+        close(*tls_listenfd);
+        *tls_listenfd = -1;
+    }
+    if (*unix_listenfd >= 0) {
+        if (listener_monitored) {
+            Epoll_ctl(epfd, EPOLL_CTL_DEL, *unix_listenfd, NULL);
+        }
+        close(*unix_listenfd);
+        *unix_listenfd = -1;
+    }
+    return true;
+}
+
+/**
+ * @brief Handles an event on a client connection.
+ * @details A connection that is still in its TLS handshake continues it. An HTTP/2 connection handles every event itself, since it is
+ * monitored for reading and writing at once. An HTTP/1.1 connection receives its request, or sends the next chunk of its file, which
+ * is also how a failed connection finds out that it failed.
+ * @param client_info Pointer to the client session information.
+ * @param events The events that occurred.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the request or response. Space complexity: O(n).
+ */
+static void handle_session_event(client_session_t* client_info, uint32_t events) {
+    if (TLS_HANDSHAKING(client_info)) {
+        if (events == EPOLLIN || events == EPOLLOUT) {
+            TLS_HANDSHAKE(client_info);
+        }
+    } else if (client_info->http2) {
+        http2_process(client_info, events);
+    } else if (events == EPOLLIN) {
+        process_client_request(client_info);
+    } else if (events == EPOLLOUT) {
+        Send(client_info);
+    } else if (events & (EPOLLERR | EPOLLHUP)) {
+        // A reset connection fails its next receive or send, either of which closes the session.
+        if (client_info->body_chunking_enabled) {
+            Send(client_info);
+        } else {
+            process_client_request(client_info);
+        }
+    }
+}
@@ -1,20 +1,47 @@
 #ifndef SERVER_CONFIG_H
 #define SERVER_CONFIG_H
 
+#include <stdbool.h>
+#include <stddef.h>
 #include "client_session.h"
 
 /// @file server_config.h
 /// @brief Contains function declarations for server configuration and client handling.
 /// @details This header file includes the declarations of functions used to create a listening socket, accept client connections, process client requests, and run the server.
 
+// Options given on the command line.
+typedef struct {
+    int port;
+    const char* wal_path; // Write-ahead log of the storage, or NULL to keep values in memory only.
+    size_t memory_limit;  // Byte budget of the stored values, or 0 for the default budget.
+    bool admission;       // Whether new keys must pass the admission filter once the budget is exhausted.
+    const char* access_log_path; // Access log, or NULL to not log requests.
+    unsigned client_connections; // Open connections allowed per client address, or 0 for the default.
+    unsigned client_rate;        // Requests per second allowed per client address, or 0 to not limit requests.
+    const char* control_path;    // Control socket for hot restarts, or NULL to always bind the port.
+    unsigned max_delay_us;       // Queueing delay past which requests are shed, or 0 to never shed.
+    size_t max_sessions;         // Open sessions at which accepting pauses, or 0 to always accept.
+    unsigned busy_poll_us;       // Longest spin for events before blocking, or 0 to always block.
+    int loop_cpu;                // Core to pin the event loop to, or -1 to let it float.
+    int tls_port;                // Port of the HTTPS listener, or 0 for none. Only available when built with TLS=1.
+    const char* tls_certificate; // PEM certificate chain of the HTTPS listener.
+    const char* tls_key;         // PEM private key of the HTTPS listener.
+    const char* unix_path;       // UNIX socket listener for clients on the same host, or NULL for none.
+    int unix_uid;                // User the clients of the UNIX socket listener must run as, or -1 for any.
+    const char* capture_path;    // Trace the sampled requests are captured to, or NULL to not capture requests.
+    unsigned capture_sample;     // Captures one in this many requests, or 0 to capture every request.
+    const char* socket_profile;  // TCP socket options of the listener and its connections, see socket_profile.h, or NULL for the defaults.
+    const char* assets_path;     // Asset pack built by pack_gen to serve packed paths from, or NULL to serve only from the filesystem.
+} server_options_t;
+
 /**
- * @brief Runs the server on the specified port.
+ * @brief Runs the server with the specified options.
  * @details This function initializes the server, creates an epoll instance, and enters an event loop to handle incoming connections and client requests.
- * @param port The port number on which the server will listen for incoming connections.
+ * @param options The server options.
  * @return This function does not return a value.
  * @note Time complexity: O(n) where n is the number of events. Space complexity: O(1).
  */
-void run_server(int port);
+void run_server(const server_options_t* options);
 
 /**
  * @brief Creates a listening socket on the specified port.
@@ -25,15 +52,25 @@ void run_server(int port);
  */
 int create_listening_socket(int port);
 
+/**
+ * @brief Creates a listening UNIX domain socket at the specified path.
+ * @details A socket file left behind at the path is replaced.
+ * @param path The path of the socket.
+ * @return Returns the file descriptor of the listening socket.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int create_unix_socket(const char* path);
+
 /**
  * @brief Accepts a new client connection.
  * @details This function accepts a new client connection and adds it to the epoll instance for monitoring.
  * @param epfd The epoll file descriptor.
- * @param listenfd The file descriptor of the listening socket.
+ * @param listenfd The file descriptor of the listening socket, a TCP or a UNIX one.
+ * @param secure Whether the connection is made to the HTTPS listener and starts with a TLS handshake.
  * @return This function does not return a value.
  * @note Time complexity: O(1). Space complexity: O(1).
  */
-void accept_client(int epfd, int listenfd);
+void accept_client(int epfd, int listenfd, bool secure);
 
 /**
  * @brief Processes a client request.
@@ -44,4 +81,23 @@ void accept_client(int epfd, int listenfd);
  */
 void process_client_request(client_session_t* client_info);
 
+/**
+ * @brief Decides whether a request is served.
+ * @details Requests of rejected connections, requests shed under overload and requests beyond the rate of their client are not.
+ * @param connection Pointer to the session of the connection the request arrived on.
+ * @param request The request.
+ * @return Returns 0 if the request is served, or the status to answer it with instead.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int admit_request(const client_session_t* connection, const char* request);
+
+/**
+ * @brief Serves a complete request.
+ * @details This function parses the request, generates its response and sends it, or answers with the rejection status of the session.
+ * @param client_info Pointer to the client session information, holding a null-terminated request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the request. Space complexity: O(n).
+ */
+void serve_request(client_session_t* client_info);
+
 #endif
\ No newline at end of file
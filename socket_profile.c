@@ -0,0 +1,123 @@
+/// @file socket_profile.c
+/// @brief Contains functions for the TCP socket option profile.
+/// @details This file includes the parser of profiles and the functions applying them to the listener and to accepted connections.
+/// Every option is a hint the kernel may refuse, e.g. TCP_FASTOPEN when net.ipv4.tcp_fastopen does not enable it for servers, so
+/// failing to set one on the listener is reported once and failing on a connection is ignored.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include "socket_profile.h"
+
+// Longest profile accepted on the command line.
+#define SOCKET_PROFILE_MAX 256
+
+static int defer_accept_s = 0;
+static int fastopen_queue = 0;
+static int nodelay = 0;
+static bool cork = false;
+static int send_buffer = 0;
+
+/**
+ * @brief Parses a profile and makes it the current one.
+ * @param profile The profile, e.g. "latency" or "defer=1,nodelay,sndbuf=1048576".
+ * @return Returns 0 on success, or -1 if a setting is unknown or its value is invalid.
+ * @note Time complexity: O(n) where n is the length of the profile. Space complexity: O(n).
+ */
+int socket_profile_parse(const char* profile) {
+    char settings[SOCKET_PROFILE_MAX];
+    if (snprintf(settings, sizeof(settings), "%s", profile) >= (int)sizeof(settings)) return -1;
+
+    char* state = NULL;
+    for (char* setting = strtok_r(settings, ",", &state); setting; setting = strtok_r(NULL, ",", &state)) {
+        char* value = strchr(setting, '=');
+        char* end = NULL;
+        long number = 0;
+        if (value) {
+            *value++ = '\0';
+            number = strtol(value, &end, 10);
+            if (end == value || *end != '\0' || number < 0 || number > (1L << 30)) return -1;
+        }
+
+        if (strcmp(setting, "latency") == 0 && !value) {
+            defer_accept_s = 1;
+            fastopen_queue = 256;
+            nodelay = 1;
+        } else if (strcmp(setting, "throughput") == 0 && !value) {
+            defer_accept_s = 1;
+            fastopen_queue = 256;
+            nodelay = 1;
+            cork = true;
+            send_buffer = 4 * 1024 * 1024;
+        } else if (strcmp(setting, "defer") == 0 && value) {
+            defer_accept_s = number;
+        } else if (strcmp(setting, "fastopen") == 0 && value) {
+            fastopen_queue = number;
+        } else if (strcmp(setting, "nodelay") == 0 && !value) {
+            nodelay = 1;
+        } else if (strcmp(setting, "cork") == 0 && !value) {
+            cork = true;
+        } else if (strcmp(setting, "sndbuf") == 0 && value) {
+            send_buffer = number;
+        } else {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Applies the profile to the TCP listener.
+ * @details Accepted connections do not inherit TCP_DEFER_ACCEPT and TCP_FASTOPEN, which only concern the handshake.
+ * @param listenfd The listening socket.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void socket_profile_listener(int listenfd) {
+    if (defer_accept_s && setsockopt(listenfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, &defer_accept_s, sizeof(defer_accept_s)) < 0) {
+        perror("Setting TCP_DEFER_ACCEPT failed");
+    }
+
+    if (fastopen_queue && setsockopt(listenfd, IPPROTO_TCP, TCP_FASTOPEN, &fastopen_queue, sizeof(fastopen_queue)) < 0) {
+        perror("Setting TCP_FASTOPEN failed");
+    }
+}
+
+/**
+ * @brief Applies the profile to an accepted TCP connection.
+ * @details The kernel doubles the send buffer size for its bookkeeping and caps it at net.core.wmem_max. Setting it turns the
+ * buffer's autotuning off, so it is only set when the profile asks for it.
+ * @param fd The client socket.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void socket_profile_client(int fd) {
+    if (nodelay) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+
+    if (send_buffer) {
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer));
+    }
+}
+
+/**
+ * @brief Corks or uncorks a connection, if the profile corks responses.
+ * @details While corked, only full segments are sent, so a response header is sent together with the start of the body that
+ * follows it. Uncorking sends what is left right away, also with TCP_NODELAY off.
+ * @param fd The client socket.
+ * @param corked Whether to cork the connection.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void socket_profile_cork(int fd, bool corked) {
+    if (!cork) return;
+
+    int value = corked;
+    setsockopt(fd, IPPROTO_TCP, TCP_CORK, &value, sizeof(value));
+}
@@ -0,0 +1,22 @@
+#ifndef SOCKET_PROFILE_H
+#define SOCKET_PROFILE_H
+
+#include <stdbool.h>
+
+/// @file socket_profile.h
+/// @brief Contains function declarations for the TCP socket option profile.
+/// @details A profile is a comma-separated list of settings applied to the TCP listener and the connections it accepts:
+/// - `defer=<seconds>` sets TCP_DEFER_ACCEPT, so a connection only wakes the server once its request has arrived.
+/// - `fastopen=<queue>` sets TCP_FASTOPEN, so returning clients can send their request with the SYN.
+/// - `nodelay` sets TCP_NODELAY on accepted connections, so the end of a response is not held back waiting for an ACK.
+/// - `cork` corks a connection while the header and first chunk of a file body are sent, so they leave in full segments.
+/// - `sndbuf=<bytes>` sizes the send buffer of accepted connections, for bulk transfers.
+/// `latency` stands for `defer=1,fastopen=256,nodelay` and `throughput` for `defer=1,fastopen=256,nodelay,cork,sndbuf=4194304`, and
+/// later settings add to them. Without a profile the kernel defaults apply.
+
+int socket_profile_parse(const char* profile);
+void socket_profile_listener(int listenfd);
+void socket_profile_client(int fd);
+void socket_profile_cork(int fd, bool corked);
+
+#endif
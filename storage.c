@@ -1,6 +1,8 @@
 /// @file storage.c
 /// @brief Contains functions for managing storage.
 /// @details This file includes functions to initialize, save, read, clear, and free storage, as well as to get the total memory usage.
+/// Named values are kept within a byte budget. Cold values are evicted with the CLOCK policy, and an optional TinyLFU admission filter
+/// keeps new keys from displacing values that are used more often.
 
 #include <stdlib.h>
 #include <string.h>
@@ -9,47 +11,125 @@
 
 #include "storage.h"
 #include "network_utils.h"
+#include "constants.h"
 
 
 
-#define MAX_CLIENT_STORAGE_SIZE 1024
-#define SERVER_MEMORY_LIMIT (MAX_CLIENT_STORAGE_SIZE * 1000)
+// The initial capacity of a value streamed in, which is also the size assumed for the value of a new key when deciding on its admission.
+#define TYPICAL_VALUE_SIZE 1024
+
+// The default byte budget, large enough for several of the largest chunked uploads.
+#define SERVER_MEMORY_LIMIT (64 * 1024 * 1024)
+
+#define STORAGE_BUCKETS 256
+
+// The count-min sketch estimating key frequencies for admission. Its counters are halved after SKETCH_SAMPLE increments,
+// so the estimates follow recent use.
+#define SKETCH_DEPTH 4
+#define SKETCH_WIDTH 4096
+#define SKETCH_COUNTER_MAX 15
+#define SKETCH_SAMPLE (10 * SKETCH_WIDTH)
 
 static size_t total_allocated_memory = 0;
+static size_t memory_limit = SERVER_MEMORY_LIMIT;
+static bool admission_enabled = false;
+static bool read_only = false;
+
+static size_t hits = 0;
+static size_t misses = 0;
+static size_t evictions = 0;
+static size_t rejections = 0;
+
+// Incremented on every change of a stored value, which makes storage versions unique across keys.
+static uint64_t write_sequence = 0;
+
+// Values stored through /write and /write/<key>, chained per bucket. The default value has the empty key.
+// Every entry is also on the circular list swept by the clock hand, and is marked as referenced whenever it is looked up.
+typedef struct storage_entry {
+    struct storage_entry* next;
+    struct storage_entry* clock_next;
+    storage_t* storage;
+    size_t hash;
+    bool referenced;
+    char key[];
+} storage_entry_t;
+
+static storage_entry_t* storage_buckets[STORAGE_BUCKETS];
+
+// The entry before the next eviction candidate, or NULL if there are no entries.
+static storage_entry_t* clock_hand = NULL;
+
+static uint8_t sketch[SKETCH_DEPTH][SKETCH_WIDTH];
+static size_t sketch_increments = 0;
+
+static storage_value_t* value_create(size_t capacity);
+static storage_entry_t* clock_candidate(const storage_t* keep);
+static void storage_evict(storage_entry_t* victim);
+static void enforce_budget(const storage_t* keep);
+static size_t entry_overhead(size_t key_length);
+static void sketch_increment(size_t hash);
+static unsigned sketch_estimate(size_t hash);
+
+/**
+ * @brief Allocates a stored value.
+ * @details The value starts out with a single reference, held by its creator, and counts against the total allocated memory until it is freed.
+ * @param capacity The number of bytes the value can hold.
+ * @return Returns a pointer to the empty value.
+ * @note Time complexity: O(1). Space complexity: O(n) where n is the capacity.
+ */
+static storage_value_t* value_create(size_t capacity) {
+    storage_value_t* value = Malloc(sizeof(storage_value_t) + capacity);
+    value->refcount = 1;
+    value->length = 0;
+    value->capacity = capacity;
+    total_allocated_memory += capacity;
+    return value;
+}
 
 /**
  * @brief Initializes the storage.
- * @details This function allocates memory for the storage and initializes its length to 0. It also updates the total allocated memory.
+ * @details This function allocates memory for the storage and an empty value. The value is sized when it is written.
+ * Every change of the stored value, including its creation, gives the storage a new version.
  * @return Returns a pointer to the initialized storage.
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 storage_t* storage_init() {
     storage_t* storage = (storage_t*)Malloc(sizeof(storage_t));
 
-    storage->data = Malloc(MAX_CLIENT_STORAGE_SIZE);
-
-    storage->length = 0;
-    total_allocated_memory += MAX_CLIENT_STORAGE_SIZE;
+    storage->value = value_create(0);
+    storage->version = ++write_sequence;
     return storage;
 }
 
 /**
  * @brief Saves data to the storage.
- * @details This function copies the provided data to the storage buffer and updates the length of the storage.
+ * @details This function copies the provided data to the storage buffer and updates the length of the storage. The buffer is only
+ * overwritten in place if no reader holds it and it fits the data without wasting more than half of it, otherwise a value of the
+ * size of the data replaces it and the readers keep the old one. Other values are evicted if the new value exceeds the byte budget.
  * @param storage Pointer to the storage.
  * @param data The data to be saved.
  * @param length The length of the data.
- * @return Returns 0 on success, or -1 if the data exceeds the storage capacity.
- * @note Time complexity: O(n) where n is the length of the data. Space complexity: O(1).
+ * @return Returns 0 on success, or -1 if the data is larger than a request can carry.
+ * @note Time complexity: O(n) where n is the length of the data. Space complexity: O(n).
  */
 int storage_save(storage_t* storage, const char* data, size_t length) {
-    if (length > MAX_CLIENT_STORAGE_SIZE) {
-        printf("Data exceeds storage capacity\n");
+    if (length > REQUEST_MAX) {
         return -1;
     }
 
-    memcpy(storage->data, data, length);
-    storage->length = length;
+    storage_value_t* value = storage->value;
+    if (value->refcount > 1 || value->capacity < length || value->capacity / 2 > length) {
+        storage_value_release(value);
+        value = storage->value = value_create(length);
+    }
+
+    if (length > 0) {
+        memcpy(value->data, data, length);
+    }
+    value->length = length;
+    storage->version = ++write_sequence;
+
+    enforce_budget(storage);
     return 0;
 }
 
@@ -63,16 +143,41 @@ int storage_save(storage_t* storage, const char* data, size_t length) {
  * @note Time complexity: O(n) where n is the length of the data. Space complexity: O(1).
  */
 ssize_t storage_read(storage_t* storage, char* buffer, size_t buffer_size) {
-    if (storage->length == 0) {
-        printf("No data in storage\n");
+    if (storage->value->length == 0) {
         return -1;
     }
 
-    size_t bytes_to_copy = (storage->length < buffer_size) ? storage->length : buffer_size;
-    memcpy(buffer, storage->data, bytes_to_copy);
+    size_t bytes_to_copy = (storage->value->length < buffer_size) ? storage->value->length : buffer_size;
+    memcpy(buffer, storage->value->data, bytes_to_copy);
     return bytes_to_copy;
 }
 
+/**
+ * @brief Pins the current value of the storage.
+ * @details The pinned value stays valid and unchanged until it is released, even if the storage is written to or freed in the meantime.
+ * @param storage Pointer to the storage.
+ * @return Returns the pinned value. It must be released with storage_value_release.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+storage_value_t* storage_pin(storage_t* storage) {
+    storage->value->refcount++;
+    return storage->value;
+}
+
+/**
+ * @brief Releases a reference to a stored value.
+ * @details The value is freed once its last reference is released.
+ * @param value Pointer to the value.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void storage_value_release(storage_value_t* value) {
+    if (--value->refcount == 0) {
+        total_allocated_memory -= value->capacity;
+        free(value);
+    }
+}
+
 /**
  * @brief Clears the storage.
  * @details This function sets the storage length to 0 and clears the data in the storage buffer.
@@ -81,26 +186,21 @@ ssize_t storage_read(storage_t* storage, char* buffer, size_t buffer_size) {
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 void storage_clear(storage_t* storage) {
-    if (storage && storage->data) {
-        memset(storage->data, 0, storage->length);
-        storage->length = 0;
+    if (storage) {
+        storage_save(storage, NULL, 0);
     }
 }
 
 /**
  * @brief Frees the storage.
- * @details This function frees the memory allocated for the storage and updates the total allocated memory.
+ * @details This function releases the stored value and frees the storage.
  * @param storage Pointer to the storage.
  * @return This function does not return a value.
  * @note Time complexity: O(1). Space complexity: O(1).
  */
 void storage_free(storage_t* storage) {
-    printf("Here in free storage\n");
     if (storage) {
-        if (storage->data) {
-            free(storage->data);
-            total_allocated_memory -= MAX_CLIENT_STORAGE_SIZE;
-        }
+        storage_value_release(storage->value);
         free(storage);
     }
 }
@@ -113,4 +213,386 @@ void storage_free(storage_t* storage) {
  */
 size_t storage_get_memory_usage() {
     return total_allocated_memory;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Starts streaming a new value into storage.
+ * @details This function resets the stream so that data can be appended to it piece by piece as it arrives.
+ * The stored value is left untouched until the stream is committed.
+ * @param stream Pointer to the stream.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void storage_stream_begin(storage_stream_t* stream) {
+    stream->value = NULL;
+}
+
+/**
+ * @brief Appends data to a value being streamed into storage.
+ * @details This function copies the data to the end of the stream, doubling the stream buffer when it runs out of space.
+ * @param stream Pointer to the stream.
+ * @param data The data to be appended.
+ * @param length The length of the data.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) amortized where n is the length of the data. Space complexity: O(n).
+ */
+void storage_stream_append(storage_stream_t* stream, const char* data, size_t length) {
+    if (!stream->value) {
+        stream->value = value_create(TYPICAL_VALUE_SIZE);
+    }
+
+    storage_value_t* value = stream->value;
+    if (value->length + length > value->capacity) {
+        size_t capacity = value->capacity;
+        while (capacity < value->length + length) {
+            capacity *= 2;
+        }
+
+        // The value is not shared before it is committed, so it can still be moved.
+        total_allocated_memory += capacity - value->capacity;
+        value = stream->value = Realloc(value, sizeof(storage_value_t) + capacity);
+        value->capacity = capacity;
+    }
+
+    memcpy(value->data + value->length, data, length);
+    value->length += length;
+}
+
+/**
+ * @brief Publishes a streamed value as the stored value.
+ * @details This function hands the stream buffer over to the storage and releases the previously stored value. The buffer is first
+ * shrunk to the length of the value, giving back what doubling it left unused. Other values are evicted if the new value exceeds the
+ * byte budget.
+ * @param storage Pointer to the storage.
+ * @param stream Pointer to the stream. It is left empty.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the value, if realloc has to move it. Space complexity: O(1).
+ */
+void storage_stream_commit(storage_t* storage, storage_stream_t* stream) {
+    if (!stream->value) {
+        storage_save(storage, NULL, 0);
+        return;
+    }
+
+    storage_value_t* value = stream->value;
+    if (value->capacity > value->length) {
+        total_allocated_memory -= value->capacity - value->length;
+        value = Realloc(value, sizeof(storage_value_t) + value->length);
+        value->capacity = value->length;
+    }
+
+    storage_value_release(storage->value);
+    storage->value = value;
+    storage->version = ++write_sequence;
+
+    storage_stream_begin(stream);
+    enforce_budget(storage);
+}
+
+/**
+ * @brief Discards a value being streamed into storage.
+ * @details This function frees the stream buffer, leaving the stored value unchanged.
+ * @param stream Pointer to the stream.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void storage_stream_abort(storage_stream_t* stream) {
+    if (stream->value) {
+        storage_value_release(stream->value);
+    }
+    storage_stream_begin(stream);
+}
+
+
+/**
+ * @brief Finds the storage of a named value.
+ * @details This function looks the key up in the table of named values, optionally creating an empty storage for it. A new storage
+ * that does not fit into the byte budget makes room by evicting cold values. With admission enabled, it is only admitted if its key
+ * has been used more often than the value that would be evicted first. Once storage is read-only, no storage is handed out for writing.
+ * @param key The name of the value, or "" for the default value.
+ * @param create Whether to create the storage if the key is not found, which callers only ask for to write the value.
+ * @return Returns a pointer to the storage, or NULL if the key is not found and `create` is false, the key was not admitted, or
+ * storage is read-only and `create` is true.
+ * @note Time complexity: O(n) where n is the length of the key, on average. Space complexity: O(1).
+ */
+storage_t* storage_lookup(const char* key, bool create) {
+    if (create && read_only) return NULL;
+
+    size_t hash = 5381;
+    for (const char* c = key; *c; c++) {
+        hash = hash * 33 + (unsigned char)*c;
+    }
+    storage_entry_t** bucket = &storage_buckets[hash % STORAGE_BUCKETS];
+
+    if (admission_enabled) {
+        sketch_increment(hash);
+    }
+
+    for (storage_entry_t* entry = *bucket; entry; entry = entry->next) {
+        if (entry->hash == hash && strcmp(entry->key, key) == 0) {
+            entry->referenced = true;
+            hits++;
+            return entry->storage;
+        }
+    }
+
+    misses++;
+    if (!create) return NULL;
+
+    size_t key_length = strlen(key);
+    if (admission_enabled && total_allocated_memory + entry_overhead(key_length) + TYPICAL_VALUE_SIZE > memory_limit) {
+        storage_entry_t* victim = clock_candidate(NULL);
+        if (victim && sketch_estimate(hash) <= sketch_estimate(victim->hash)) {
+            rejections++;
+            return NULL;
+        }
+    }
+
+    storage_entry_t* entry = Malloc(sizeof(storage_entry_t) + key_length + 1);
+    memcpy(entry->key, key, key_length + 1);
+    entry->storage = storage_init();
+    entry->hash = hash;
+    entry->referenced = false;
+    entry->next = *bucket;
+    *bucket = entry;
+    total_allocated_memory += entry_overhead(key_length);
+
+    // New entries go right behind the hand, so they are the last to be considered for eviction.
+    if (clock_hand) {
+        entry->clock_next = clock_hand->clock_next;
+        clock_hand->clock_next = entry;
+    } else {
+        entry->clock_next = entry;
+    }
+    clock_hand = entry;
+
+    enforce_budget(entry->storage);
+    return entry->storage;
+}
+
+/**
+ * @brief Configures the byte budget of the named values.
+ * @param limit The maximum number of bytes held by values, including the bookkeeping of their keys.
+ * @param admission Whether new keys have to pass the TinyLFU admission filter when the budget is exhausted.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of values evicted to meet the new budget. Space complexity: O(1).
+ */
+void storage_configure(size_t limit, bool admission) {
+    memory_limit = limit;
+    admission_enabled = admission;
+    enforce_budget(NULL);
+}
+
+/**
+ * @brief Makes storage read-only, refusing every later write.
+ * @details This is used once the stored values have been handed over to another process.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void storage_set_read_only() {
+    read_only = true;
+}
+
+/**
+ * @brief Checks whether storage is read-only.
+ * @return Returns true if writes are refused, false otherwise.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool storage_is_read_only() {
+    return read_only;
+}
+
+/**
+ * @brief Gets the byte budget of the named values.
+ * @return Returns the byte budget.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t storage_get_memory_limit() {
+    return memory_limit;
+}
+
+/**
+ * @brief Frees all named values.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of values. Space complexity: O(1).
+ */
+void storage_free_all() {
+    while (clock_hand) {
+        storage_evict(clock_hand->clock_next);
+    }
+    evictions = 0;
+}
+
+/**
+ * @brief Gets the number of lookups that found their key.
+ * @return Returns the number of hits.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t storage_get_hits() {
+    return hits;
+}
+
+/**
+ * @brief Gets the number of lookups that did not find their key.
+ * @return Returns the number of misses.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t storage_get_misses() {
+    return misses;
+}
+
+/**
+ * @brief Gets the number of values evicted to stay within the byte budget.
+ * @return Returns the number of evictions.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t storage_get_evictions() {
+    return evictions;
+}
+
+/**
+ * @brief Gets the number of new keys refused by the admission filter.
+ * @return Returns the number of rejections.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t storage_get_rejections() {
+    return rejections;
+}
+
+/**
+ * @brief Advances the clock hand to the next eviction candidate.
+ * @details Entries marked as referenced get a second chance: the mark is cleared and the hand moves past them. The hand is left on the
+ * entry before the candidate, so the candidate can be unlinked.
+ * @param keep A storage that must not be evicted, or NULL.
+ * @return Returns the candidate, or NULL if there is no entry that may be evicted.
+ * @note Time complexity: O(n) where n is the number of entries, O(1) amortized. Space complexity: O(1).
+ */
+static storage_entry_t* clock_candidate(const storage_t* keep) {
+    if (!clock_hand) return NULL;
+
+    // The first round clears every mark, so the second finds a candidate unless only `keep` is left.
+    storage_entry_t* start = clock_hand;
+    for (int rounds = 0; rounds < 2; ) {
+        storage_entry_t* candidate = clock_hand->clock_next;
+
+        if (candidate->storage != keep && !candidate->referenced) {
+            return candidate;
+        }
+
+        candidate->referenced = false;
+        clock_hand = candidate;
+        if (clock_hand == start) rounds++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Evicts the entry right after the clock hand.
+ * @param victim The entry after the clock hand.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the length of the victim's bucket. Space complexity: O(1).
+ */
+static void storage_evict(storage_entry_t* victim) {
+    if (victim == clock_hand) {
+        clock_hand = NULL;
+    } else {
+        clock_hand->clock_next = victim->clock_next;
+    }
+
+    storage_entry_t** link = &storage_buckets[victim->hash % STORAGE_BUCKETS];
+    while (*link != victim) {
+        link = &(*link)->next;
+    }
+    *link = victim->next;
+
+    total_allocated_memory -= entry_overhead(strlen(victim->key));
+    storage_free(victim->storage);
+    free(victim);
+    evictions++;
+}
+
+/**
+ * @brief Evicts cold values until the byte budget is met.
+ * @details Values still being streamed in count against the budget but cannot be evicted, so the budget may be exceeded while they are pending.
+ * @param keep A storage that must not be evicted, or NULL.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of entries. Space complexity: O(1).
+ */
+static void enforce_budget(const storage_t* keep) {
+    while (total_allocated_memory > memory_limit) {
+        storage_entry_t* victim = clock_candidate(keep);
+        if (!victim) break;
+        storage_evict(victim);
+    }
+}
+
+/**
+ * @brief Computes the bytes taken by an entry besides its value.
+ * @param key_length The length of the entry's key.
+ * @return Returns the size of the entry and its storage.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static size_t entry_overhead(size_t key_length) {
+    return sizeof(storage_entry_t) + key_length + 1 + sizeof(storage_t);
+}
+
+/**
+ * @brief Counts a use of a key in the frequency sketch.
+ * @details Every row of the sketch has its own counter for the key. Once SKETCH_SAMPLE uses have been counted, all counters are halved.
+ * @param hash The hash of the key.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1) amortized. Space complexity: O(1).
+ */
+static void sketch_increment(size_t hash) {
+    uint64_t mixed = (uint64_t)hash * 0x9E3779B97F4A7C15u;
+    uint32_t h1 = (uint32_t)mixed, h2 = (uint32_t)(mixed >> 32) | 1;
+
+    for (int row = 0; row < SKETCH_DEPTH; row++) {
+        uint8_t* counter = &sketch[row][(h1 + row * h2) & (SKETCH_WIDTH - 1)];
+        if (*counter < SKETCH_COUNTER_MAX) (*counter)++;
+    }
+
+    if (++sketch_increments >= SKETCH_SAMPLE) {
+        for (int row = 0; row < SKETCH_DEPTH; row++) {
+            for (int i = 0; i < SKETCH_WIDTH; i++) {
+                sketch[row][i] >>= 1;
+            }
+        }
+        sketch_increments /= 2;
+    }
+}
+
+/**
+ * @brief Estimates how often a key has been used recently.
+ * @param hash The hash of the key.
+ * @return Returns the smallest counter of the key across the rows of the sketch.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static unsigned sketch_estimate(size_t hash) {
+    uint64_t mixed = (uint64_t)hash * 0x9E3779B97F4A7C15u;
+    uint32_t h1 = (uint32_t)mixed, h2 = (uint32_t)(mixed >> 32) | 1;
+
+    unsigned estimate = SKETCH_COUNTER_MAX;
+    for (int row = 0; row < SKETCH_DEPTH; row++) {
+        unsigned counter = sketch[row][(h1 + row * h2) & (SKETCH_WIDTH - 1)];
+        if (counter < estimate) estimate = counter;
+    }
+    return estimate;
+}
+
+/**
+ * @brief Visits every named value.
+ * @details This function calls `visit` once for every key in the table of named values, in no particular order.
+ * @param visit The function to call with the key, the storage of the key and `ctx`.
+ * @param ctx A pointer passed through to `visit`.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the number of keys. Space complexity: O(1).
+ */
+void storage_foreach(void (*visit)(const char* key, storage_t* storage, void* ctx), void* ctx) {
+    for (size_t i = 0; i < STORAGE_BUCKETS; i++) {
+        for (storage_entry_t* entry = storage_buckets[i]; entry; entry = entry->next) {
+            visit(entry->key, entry->storage, ctx);
+        }
+    }
+}
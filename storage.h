@@ -1,20 +1,54 @@
 #ifndef STORAGE_H
 #define STORAGE_H
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <unistd.h>
 
+// A stored value. Readers pin it and can keep sending it after a write has replaced it, it is freed with its last reference.
 typedef struct {
-    char* data;
+    size_t refcount;
     size_t length;
+    size_t capacity;
+    char data[];
+} storage_value_t;
+
+typedef struct {
+    storage_value_t* value;
+    uint64_t version;
 } storage_t;
 
+// A value being streamed into storage, published by storage_stream_commit.
+typedef struct {
+    storage_value_t* value;
+} storage_stream_t;
+
 // Initialize per-client storage
 storage_t* storage_init();
 int storage_save(storage_t* storage, const char* data, size_t length);
 ssize_t storage_read(storage_t* storage, char* buffer, size_t buffer_size);
+storage_value_t* storage_pin(storage_t* storage);
+void storage_value_release(storage_value_t* value);
 void storage_clear(storage_t* storage);
 void storage_free(storage_t* storage);
 size_t storage_get_memory_usage();
 
+storage_t* storage_lookup(const char* key, bool create);
+void storage_configure(size_t limit, bool admission);
+size_t storage_get_memory_limit();
+void storage_set_read_only();
+bool storage_is_read_only();
+void storage_free_all();
+size_t storage_get_hits();
+size_t storage_get_misses();
+size_t storage_get_evictions();
+size_t storage_get_rejections();
+void storage_foreach(void (*visit)(const char* key, storage_t* storage, void* ctx), void* ctx);
+
+void storage_stream_begin(storage_stream_t* stream);
+void storage_stream_append(storage_stream_t* stream, const char* data, size_t length);
+void storage_stream_commit(storage_t* storage, storage_stream_t* stream);
+void storage_stream_abort(storage_stream_t* stream);
+
 #endif
\ No newline at end of file
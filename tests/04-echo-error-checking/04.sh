@@ -5,7 +5,7 @@
 PORT=$@
 
 EOL=$'\r\n'
-REQUEST1=$'GET /echo HTTP/1.1'${EOL}$'Header1: '`printf "%1070s" | tr " " "U"`${EOL}${EOL}
+REQUEST1=$'GET /echo HTTP/1.1'${EOL}$'Header1: '`printf "%70000s" | tr " " "U"`${EOL}${EOL}
 
 REQUEST2=$'GET /echo HTTP/1.1\r
 Header1: Value1\r
@@ -1,10 +1,10 @@
 #! /bin/bash
 
-# this test: posting more than 1024 bytes of random data
+# this test: posting more random data than the largest request the server takes
 
 PORT=$@
 
-SIZE=1361
+SIZE=70000
 RAND_DATA=`dd if=/dev/urandom bs=$SIZE count=1 status=none | base64 | head -c $SIZE`
 
 EOL=$'\r\n'
@@ -11,8 +11,8 @@ SDATA=`printf "%2048s" | tr " " "a" | head -c $SSIZE`
 MSIZE=1024
 MDATA=`printf "%2048s" | tr " " "b" | head -c $MSIZE`
 
-LSIZE=1700
-LDATA=`printf "%2048s" | tr " " "c" | head -c $LSIZE`
+LSIZE=70000
+LDATA=`printf "%70000s" | tr " " "c" | head -c $LSIZE`
 
 REQUEST1=$'POST /write HTTP/1.1'${EOL}$'Content-Length: '${SSIZE}${EOL}${EOL}${SDATA}
 REQUEST2=$'POST /write HTTP/1.1'${EOL}$'Content-Length: '${MSIZE}${EOL}${EOL}${MDATA}
@@ -0,0 +1,20 @@
+#!/bin/bash
+
+PORT=$@
+
+REQUEST1=$'POST /write HTTP/1.1\r
+Transfer-Encoding: chunked\r
+\r
+7\r
+This is\r
+11;ext=1\r
+ the data to save\r
+0\r
+\r
+'
+
+REQUEST2=$'GET /read HTTP/1.1\r\n\r\n'
+
+printf "$REQUEST1" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$REQUEST2" | nc -N 127.0.0.1 $PORT
@@ -0,0 +1,32 @@
+#!/bin/bash
+
+# this test: streaming a chunked body larger than 1024 bytes
+# in several pieces, with a trailer
+
+PORT=$@
+
+EOL=$'\r\n'
+DATA1=`dd if=/dev/urandom bs=3000 count=1 status=none | base64 -w 0 | head -c 3000`
+DATA2=`dd if=/dev/urandom bs=2500 count=1 status=none | base64 -w 0 | head -c 2500`
+SIZE=$((${#DATA1} + ${#DATA2}))
+
+REQUEST1=$'POST /write HTTP/1.1'${EOL}$'Transfer-Encoding: chunked'${EOL}${EOL}
+REQUEST2=$'GET /read HTTP/1.1'${EOL}${EOL}
+RESPONSE=$'HTTP/1.1 200 OK'${EOL}$'Content-Length: '${SIZE}${EOL}${EOL}
+
+{
+    printf "%s" "${REQUEST1}"
+    sleep 0.2
+    printf "bb8${EOL}${DATA1}${EOL}9c"
+    sleep 0.2
+    printf "4${EOL}${DATA2}${EOL}0${EOL}"
+    sleep 0.2
+    printf "Trailer: Value${EOL}${EOL}"
+} | nc -N 127.0.0.1 $PORT >actual
+printf "\n" >>actual
+printf "$REQUEST2" | nc -N 127.0.0.1 $PORT >>actual
+
+printf "%s" "${RESPONSE}${DATA1}${DATA2}" >expected
+printf "\n" >>expected
+printf "%s" "${RESPONSE}${DATA1}${DATA2}" >>expected
+diff expected actual
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+# malformed chunk sizes should get 400 and leave the stored data alone
+
+PORT=$@
+
+EOL=$'\r\n'
+REQUEST1=$'POST /write HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'hello'
+REQUEST2=$'POST /write HTTP/1.1'${EOL}$'Transfer-Encoding: chunked'${EOL}${EOL}$'zz'${EOL}$'hello'${EOL}$'0'${EOL}${EOL}
+REQUEST3=$'POST /write HTTP/1.1'${EOL}$'Transfer-Encoding: chunked'${EOL}${EOL}$'5'${EOL}$'helloX'${EOL}$'0'${EOL}${EOL}
+REQUEST4=$'GET /read HTTP/1.1'${EOL}${EOL}
+
+printf "$REQUEST1" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$REQUEST2" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$REQUEST3" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$REQUEST4" | nc -N 127.0.0.1 $PORT
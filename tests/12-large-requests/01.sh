@@ -0,0 +1,10 @@
+#!/bin/bash
+
+# request head larger than 4096 bytes should still be served
+
+PORT=$@
+
+EOL=$'\r\n'
+REQUEST=$'GET /tests/07-files/index.html HTTP/1.1'${EOL}$'X-Padding: '`printf "%6000s" | tr " " "p"`${EOL}${EOL}
+
+printf "$REQUEST" | nc -N 127.0.0.1 $PORT
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# bodies and echoed headers larger than 1024 bytes are served, also when the body arrives after the head
+
+PORT=$@
+
+EOL=$'\r\n'
+DATA=`printf "%2000s" | tr " " "w"`
+HEADER=`printf "%1500s" | tr " " "e"`
+
+printf "POST /write HTTP/1.1${EOL}Content-Length: 2000${EOL}${EOL}${DATA}" | nc -N 127.0.0.1 $PORT | head -n 2
+printf "GET /read HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $PORT | tail -n 1 | wc -c
+
+{ printf "POST /write HTTP/1.1${EOL}Content-Length: 2000${EOL}${EOL}"; sleep 0.2; printf "${DATA}"; } | nc -N 127.0.0.1 $PORT | head -n 1
+
+printf "GET /echo HTTP/1.1${EOL}X-Large: ${HEADER}${EOL}${EOL}" | nc -N 127.0.0.1 $PORT | head -n 2
@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# once warmed up, serving requests should not allocate at all
+
+PORT=$@
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+ECHO=$'GET /echo HTTP/1.1'${EOL}$'Header1: Value1'${EOL}${EOL}
+WRITE=$'POST /write HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'hello'
+READ=$'GET /read HTTP/1.1'${EOL}${EOL}
+FILE=$'GET /tests/07-files/index.html HTTP/1.1'${EOL}${EOL}
+STATS=$'GET /stats HTTP/1.1'${EOL}${EOL}
+
+function run_requests
+{
+    for _ in $(seq 1 $1); do
+        for REQUEST in "$PING" "$ECHO" "$WRITE" "$READ" "$FILE"; do
+            printf "$REQUEST" | nc -N 127.0.0.1 $PORT >/dev/null
+        done
+    done
+}
+
+function allocations
+{
+    printf "$STATS" | nc -N 127.0.0.1 $PORT | grep -a '^allocations:' | cut -d ' ' -f 2
+}
+
+run_requests 2
+BEFORE=$(allocations)
+run_requests 10
+AFTER=$(allocations)
+
+printf "steady-state allocations: $((AFTER - BEFORE))\n"
@@ -0,0 +1,18 @@
+#!/bin/bash
+
+# values written under different keys are kept apart
+
+PORT=$@
+
+EOL=$'\r\n'
+REQUEST1=$'POST /write/alpha HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'first'
+REQUEST2=$'POST /write/beta HTTP/1.1'${EOL}$'Content-Length: 6'${EOL}${EOL}$'second'
+REQUEST3=$'GET /read/alpha HTTP/1.1'${EOL}${EOL}
+REQUEST4=$'GET /read/beta HTTP/1.1'${EOL}${EOL}
+REQUEST5=$'GET /read HTTP/1.1'${EOL}${EOL}
+REQUEST6=$'GET /read/gamma HTTP/1.1'${EOL}${EOL}
+
+for REQUEST in "$REQUEST1" "$REQUEST2" "$REQUEST3" "$REQUEST4" "$REQUEST5" "$REQUEST6"; do
+    printf "$REQUEST" | nc -N 127.0.0.1 $PORT
+    printf "\n"
+done
@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# invalid keys and routes without a key should get 400
+
+PORT=$@
+
+EOL=$'\r\n'
+REQUEST1=$'POST /write/'`printf "%100s" | tr " " "k"`$' HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'hello'
+REQUEST2=$'POST /write/a/b HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'hello'
+REQUEST3=$'POST /write/ HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'hello'
+REQUEST4=$'POST /ping HTTP/1.1'${EOL}${EOL}
+
+for REQUEST in "$REQUEST1" "$REQUEST2" "$REQUEST3" "$REQUEST4"; do
+    printf "$REQUEST" | nc -N 127.0.0.1 $PORT
+    printf "\n"
+done
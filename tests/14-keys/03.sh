@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# a value larger than the body buffer is read back whole, and can be replaced by a small one
+
+PORT=$@
+
+EOL=$'\r\n'
+BIG=$(head -c 3000 /dev/zero | tr '\0' 'x')
+WRITE_BIG=$'POST /write/big HTTP/1.1'${EOL}$'Transfer-Encoding: chunked'${EOL}${EOL}$'bb8'${EOL}${BIG}${EOL}$'0'${EOL}${EOL}
+WRITE_SMALL=$'POST /write/big HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'small'
+READ=$'GET /read/big HTTP/1.1'${EOL}${EOL}
+
+function summary
+{
+    RESPONSE=$(nc -N 127.0.0.1 $PORT)
+    printf "%s\n" "$RESPONSE" | head -n 2
+    printf "x bytes: %s\n" $(printf "%s" "$RESPONSE" | tr -cd 'x' | wc -c)
+}
+
+printf "$WRITE_BIG" | summary
+printf "$READ" | summary
+printf "$READ" | summary
+printf "$WRITE_SMALL" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$READ" | nc -N 127.0.0.1 $PORT
@@ -0,0 +1,15 @@
+#!/bin/bash
+
+# cached /read responses must follow writes
+
+PORT=$@
+
+EOL=$'\r\n'
+WRITE1=$'POST /write HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'first'
+WRITE2=$'POST /write HTTP/1.1'${EOL}$'Content-Length: 6'${EOL}${EOL}$'second'
+READ=$'GET /read HTTP/1.1'${EOL}${EOL}
+
+for REQUEST in "$READ" "$READ" "$WRITE1" "$READ" "$READ" "$WRITE2" "$READ"; do
+    printf "$REQUEST" | nc -N 127.0.0.1 $PORT
+    printf "\n"
+done
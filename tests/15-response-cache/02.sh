@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# cached files must follow changes on disk, repeated requests should hit the cache
+
+rm -f cached.txt
+
+PORT=$@
+
+EOL=$'\r\n'
+FILE=$'GET /cached.txt HTTP/1.1'${EOL}${EOL}
+STATS=$'GET /stats HTTP/1.1'${EOL}${EOL}
+
+function hits
+{
+    printf "$STATS" | nc -N 127.0.0.1 $PORT | grep -a '^response cache hits:' | cut -d ' ' -f 4
+}
+
+printf "version one" >cached.txt
+BEFORE=$(hits)
+printf "$FILE" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$FILE" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$FILE" | nc -N 127.0.0.1 $PORT
+printf "\n"
+AFTER=$(hits)
+
+printf "version two" >cached.txt
+printf "$FILE" | nc -N 127.0.0.1 $PORT
+printf "\n"
+
+rm -f cached.txt
+printf "$FILE" | nc -N 127.0.0.1 $PORT
+printf "\n"
+
+printf "cache hits: $((AFTER - BEFORE))\n"
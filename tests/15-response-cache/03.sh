@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# a full response cache evicts cold responses to make room for hot ones, and reads of missing keys are not cached
+
+PORT=$@
+TRACE=cache-fill.jsonl
+EOL=$'\r\n'
+
+make -s bench/replay || exit 1
+
+function stats
+{
+    curl -sS http://127.0.0.1:$PORT/stats | grep -E '^response cache (hits|evictions):'
+}
+
+# Reads of missing keys leave nothing behind to evict.
+awk 'BEGIN { for (i = 0; i < 3000; i++) printf "{\"at_us\":0,\"request\":\"GET /read/missing-%d HTTP/1.1\\r\\n\\r\\n\"}\n", i }' > $TRACE
+./bench/replay $PORT $TRACE | grep -E '^answered:'
+stats
+
+# 5000 values of 1000 bytes, more than the cache holds once they are read.
+VALUE=$(head -c 1000 /dev/zero | tr '\0' 'v')
+awk -v v=$VALUE 'BEGIN { for (i = 0; i < 5000; i++) printf "{\"at_us\":0,\"request\":\"POST /write/cold-%d HTTP/1.1\\r\\nContent-Length: 1000\\r\\n\\r\\n%s\"}\n", i, v }' > $TRACE
+./bench/replay $PORT $TRACE | grep -E '^answered:'
+awk 'BEGIN { for (i = 0; i < 5000; i++) printf "{\"at_us\":0,\"request\":\"GET /read/cold-%d HTTP/1.1\\r\\n\\r\\n\"}\n", i }' > $TRACE
+./bench/replay $PORT $TRACE | grep -E '^answered:'
+stats | grep -E -c 'evictions: [1-9]'
+
+# A key read after the cache filled up is still cached.
+printf "POST /write/hot HTTP/1.1${EOL}Content-Length: 3${EOL}${EOL}hot" | nc -N 127.0.0.1 $PORT >/dev/null
+HITS=$(curl -sS http://127.0.0.1:$PORT/stats | awk '/^response cache hits:/ { print $4 }')
+curl -sS http://127.0.0.1:$PORT/read/hot -w "\n"
+curl -sS http://127.0.0.1:$PORT/read/hot -w "\n"
+curl -sS http://127.0.0.1:$PORT/stats | awk -v before=$HITS '/^response cache hits:/ { print "hits:", $4 - before }'
+
+rm -f $TRACE
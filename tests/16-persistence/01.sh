@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# values written with a write-ahead log must survive a crash of the server
+
+PORT=$@
+source tests/lib.sh
+LOG=persist.log
+
+rm -f $LOG
+
+EOL=$'\r\n'
+WRITE=$'POST /write HTTP/1.1'${EOL}$'Content-Length: 7'${EOL}${EOL}$'durable'
+WRITE_KEY=$'POST /write/color HTTP/1.1'${EOL}$'Content-Length: 4'${EOL}${EOL}$'blue'
+OVERWRITE_KEY=$'POST /write/color HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'green'
+WRITE_CHUNKED=$'POST /write/big HTTP/1.1'${EOL}$'Transfer-Encoding: chunked'${EOL}${EOL}$'5'${EOL}$'hello'${EOL}$'0'${EOL}${EOL}
+READ=$'GET /read HTTP/1.1'${EOL}${EOL}
+READ_KEY=$'GET /read/color HTTP/1.1'${EOL}${EOL}
+READ_CHUNKED=$'GET /read/big HTTP/1.1'${EOL}${EOL}
+
+start_server -w $LOG
+printf "$WRITE" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+printf "$WRITE_KEY" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+printf "$OVERWRITE_KEY" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+printf "$WRITE_CHUNKED" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+stop_server
+
+start_server -w $LOG
+printf "$READ" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+printf "$READ_KEY" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+printf "$READ_CHUNKED" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+stop_server
+
+rm -f $LOG
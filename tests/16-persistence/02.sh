@@ -0,0 +1,36 @@
+#!/bin/bash
+
+# a torn record at the end of the log is cut off on recovery, the intact records are kept
+
+PORT=$@
+source tests/lib.sh
+LOG=persist.log
+
+rm -f $LOG
+
+EOL=$'\r\n'
+WRITE=$'POST /write HTTP/1.1'${EOL}$'Content-Length: 6'${EOL}${EOL}$'intact'
+WRITE_AGAIN=$'POST /write HTTP/1.1'${EOL}$'Content-Length: 5'${EOL}${EOL}$'after'
+READ=$'GET /read HTTP/1.1'${EOL}${EOL}
+
+start_server -w $LOG
+printf "$WRITE" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+stop_server
+
+# A record header cut off by a crash.
+printf '\x01\x02\x03\x04\x05\x00' >>$LOG
+
+start_server -w $LOG
+printf "$READ" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+printf "$WRITE_AGAIN" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+stop_server
+
+start_server -w $LOG
+printf "$READ" | nc -N 127.0.0.1 $SERVER_PORT
+printf "\n"
+stop_server
+
+rm -f $LOG
@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# values beyond the byte budget evict the coldest values, recently read values get a second chance
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+# Values are padded to about a kilobyte each, so a few of them fill the budget.
+PAD=`printf "%1000s" | tr " " "."`
+STATS=$'GET /stats HTTP/1.1'${EOL}${EOL}
+
+function write
+{
+    VALUE=$2$PAD
+    printf "POST /write/$1 HTTP/1.1${EOL}Content-Length: ${#VALUE}${EOL}${EOL}$VALUE" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+}
+
+function read
+{
+    printf "GET /read/$1 HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT | tail -n 1 | tr -d "."
+    printf "\n"
+}
+
+start_server -m 8192
+
+for i in 0 1 2 3 4 5; do
+    write key$i value$i
+done
+read key0
+for i in 6 7 8 9; do
+    write key$i value$i
+done
+
+read key0
+read key1
+read key9
+printf "$STATS" | nc -N 127.0.0.1 $SERVER_PORT | grep -a '^storage evictions:'
+
+stop_server
@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# with admission, a burst of new keys does not displace values that are used more often
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+# Values are padded to about a kilobyte each, so a few of them fill the budget.
+PAD=`printf "%1000s" | tr " " "."`
+STATS=$'GET /stats HTTP/1.1'${EOL}${EOL}
+
+function write
+{
+    VALUE=$2$PAD
+    printf "POST /write/$1 HTTP/1.1${EOL}Content-Length: ${#VALUE}${EOL}${EOL}$VALUE" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+}
+
+function read
+{
+    printf "GET /read/$1 HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT | tail -n 1 | tr -d "."
+    printf "\n"
+}
+
+start_server -a -m 8192
+
+for i in 0 1 2 3 4 5 6; do
+    write hot$i value$i >/dev/null
+    read hot$i >/dev/null
+done
+
+# A scan of keys written once each is refused.
+for i in 0 1 2; do
+    write scan$i once
+done
+
+# A key that keeps being written is admitted.
+write frequent again
+write frequent again
+write frequent again
+
+for i in 0 1 2 3 4 5 6; do
+    read hot$i
+done
+printf "$STATS" | nc -N 127.0.0.1 $SERVER_PORT | grep -a '^storage \(evictions\|admission rejections\):'
+
+stop_server
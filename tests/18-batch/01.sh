@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# a batch stores all its pairs, a multi-get returns them in one response
+
+PORT=$@
+
+EOL=$'\r\n'
+PAIRS=$'3 5\nonehello'$'3 5\ntwoworld'$'0 7\ndefault'
+BATCH=$'POST /batch HTTP/1.1'${EOL}"Content-Length: ${#PAIRS}"${EOL}${EOL}${PAIRS}
+MGET=$'GET /mget/one/two/missing/ HTTP/1.1'${EOL}${EOL}
+READ=$'GET /read HTTP/1.1'${EOL}${EOL}
+
+printf "$BATCH" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$MGET" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$READ" | nc -N 127.0.0.1 $PORT
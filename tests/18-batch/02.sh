@@ -0,0 +1,22 @@
+#!/bin/bash
+
+# a malformed batch is rejected as a whole and stores nothing
+
+PORT=$@
+
+EOL=$'\r\n'
+PAIRS=$'3 5\nonehello'$'3 x\ntwoworld'
+BATCH=$'POST /batch HTTP/1.1'${EOL}"Content-Length: ${#PAIRS}"${EOL}${EOL}${PAIRS}
+SLASH_PAIRS=$'3 5\na/bhello'
+SLASH_BATCH=$'POST /batch HTTP/1.1'${EOL}"Content-Length: ${#SLASH_PAIRS}"${EOL}${EOL}${SLASH_PAIRS}
+TRUNCATED_PAIRS=$'3 50\nonehello'
+TRUNCATED_BATCH=$'POST /batch HTTP/1.1'${EOL}"Content-Length: ${#TRUNCATED_PAIRS}"${EOL}${EOL}${TRUNCATED_PAIRS}
+MGET=$'GET /mget/one HTTP/1.1'${EOL}${EOL}
+
+printf "$BATCH" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$SLASH_BATCH" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$TRUNCATED_BATCH" | nc -N 127.0.0.1 $PORT
+printf "\n"
+printf "$MGET" | nc -N 127.0.0.1 $PORT
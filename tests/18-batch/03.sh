@@ -0,0 +1,37 @@
+#!/bin/bash
+
+# batches of too many pairs and mget requests of too many keys or too large a response are answered with 413
+
+PORT=$@
+
+EOL=$'\r\n'
+
+function batch
+{
+    PAIRS=$(for ((i = 0; i < $1; i++)); do printf '1 1\nkv'; done)
+    env printf '%s' "POST /batch HTTP/1.1${EOL}Content-Length: ${#PAIRS}${EOL}${EOL}${PAIRS}" | nc -N 127.0.0.1 $PORT > batch.out
+    head -n 1 batch.out
+    grep -c "^200$" batch.out
+}
+
+function mget
+{
+    KEYS=$(for ((i = 1; i < $2; i++)); do printf "$1/"; done)$1
+    env printf '%s' "GET /mget/${KEYS} HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $PORT > mget.out
+    head -n 2 mget.out
+}
+
+batch 1024
+batch 1025
+
+mget k 256
+mget k 257
+
+# A 5000 byte value, repeated 250 times in a response, makes it larger than a megabyte.
+VALUE=$(printf '%5000s' | tr ' ' 'v')
+env printf '%s' "POST /write/big HTTP/1.1${EOL}Transfer-Encoding: chunked${EOL}${EOL}1388${EOL}${VALUE}${EOL}0${EOL}${EOL}" \
+    | nc -N 127.0.0.1 $PORT | head -n 1
+mget big 100
+mget big 250
+
+rm -f batch.out mget.out
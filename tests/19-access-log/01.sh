@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# every answered request gets an access log line, written in the background
+
+PORT=$@
+source tests/lib.sh
+LOG=access.log
+
+rm -f $LOG
+
+EOL=$'\r\n'
+
+start_server -l $LOG
+printf "GET /ping HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+printf "POST /write HTTP/1.1${EOL}Content-Length: 5${EOL}${EOL}hello" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+printf "GET /missing\"file HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+printf "GET /stats HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT | grep -a '^access log drops:'
+
+# The writer flushes whenever the ring runs empty.
+sleep 0.5
+stop_server
+
+# Time and latency vary from run to run, and so does the size of /stats.
+grep -v '"/stats"' $LOG | sed -e 's/"time":[0-9]*,//' -e 's/,"latency_us":[0-9]*//'
+rm -f $LOG
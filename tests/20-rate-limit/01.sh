@@ -0,0 +1,22 @@
+#!/bin/bash
+
+# a client that runs out of request tokens is answered with 429 until its bucket refills
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+start_server -r 1
+
+# The first request of a burst is allowed, the rest of the burst is refused.
+for i in 1 2 3; do
+    printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+done
+
+# A second later the bucket is full again.
+sleep 1.2
+printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+
+stop_server
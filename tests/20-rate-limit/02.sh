@@ -0,0 +1,25 @@
+#!/bin/bash
+
+# a client over its connection limit is answered with 503 until one of its connections closes
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+start_server -c 2
+
+# Two idle connections use up the limit.
+sleep 1 | nc -N 127.0.0.1 $SERVER_PORT >/dev/null &
+IDLE1=$!
+sleep 1 | nc -N 127.0.0.1 $SERVER_PORT >/dev/null &
+IDLE2=$!
+sleep 0.3
+
+printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+
+wait $IDLE1 $IDLE2
+printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+
+stop_server
@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# idle connections over the connection limit are closed at once instead of being kept open
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+start_server -c 1
+
+# The first idle connection uses up the limit, the ones after it never send a request.
+sleep 3 | nc -N 127.0.0.1 $SERVER_PORT >/dev/null &
+IDLE=$!
+sleep 0.3
+for i in 1 2 3; do
+    sleep 3 | nc -N 127.0.0.1 $SERVER_PORT >idle$i.out &
+    OVER[$i]=$!
+done
+
+# The connections over the limit close long before the idle one would.
+TRIES=0
+for i in 1 2 3; do
+    while kill -0 ${OVER[$i]} 2>/dev/null && [[ $TRIES -lt 20 ]]; do
+        ((TRIES++))
+        sleep 0.1
+    done
+done
+for i in 1 2 3; do
+    kill -0 ${OVER[$i]} 2>/dev/null && echo "connection $i still open" || echo "connection $i closed"
+    head -n 1 idle$i.out
+done
+
+wait $IDLE
+printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+printf "GET /stats HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT | grep "rate limit rejections"
+
+stop_server
+rm -f idle1.out idle2.out idle3.out
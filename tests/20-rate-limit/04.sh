@@ -0,0 +1,40 @@
+#!/bin/bash
+
+# a server out of file descriptors leaves further connections waiting instead of exiting or spinning on them
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+# Only the server is started with the lower limit.
+ulimit -Sn 16
+start_server
+ulimit -Sn 100
+
+# More idle connections than the server has file descriptors for.
+IDLE=()
+for i in $(seq 1 20); do
+    exec {FD}<>/dev/tcp/127.0.0.1/$SERVER_PORT
+    IDLE+=($FD)
+done
+sleep 0.5
+
+# The user and system time of the server in clock ticks.
+cpu_ticks() {
+    awk '{ print $14 + $15 }' /proc/$SERVER/stat
+}
+BEFORE=$(cpu_ticks)
+sleep 1
+AFTER=$(cpu_ticks)
+# Spinning on the pending connections would take about a full second, that is 100 ticks.
+[[ $((AFTER - BEFORE)) -lt 20 ]] && echo "cpu while out of file descriptors: low" || echo "cpu while out of file descriptors: $((AFTER - BEFORE)) ticks"
+
+kill -0 $SERVER 2>/dev/null && echo "server running" || echo "server exited"
+for FD in ${IDLE[@]}; do
+    exec {FD}>&-
+done
+printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+
+stop_server
@@ -0,0 +1,49 @@
+#!/bin/bash
+
+# a new server takes the port and the stored values over, while the old one finishes its open connections
+
+PORT=$@
+source tests/lib.sh
+CONTROL=restart.sock
+
+rm -f $CONTROL
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+function write
+{
+    printf "POST /write/$1 HTTP/1.1${EOL}Content-Length: ${#2}${EOL}${EOL}$2" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+}
+
+function read
+{
+    printf "GET /read/$1 HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT | tail -n 1
+    printf "\n"
+}
+
+start_server -R $CONTROL
+OLD=$SERVER
+
+write kept value
+
+# A client that is still sending its request when the new server starts, in two pieces.
+{ sleep 1; printf "GET /ping HTTP/1.1${EOL}"; sleep 0.2; printf "${EOL}"; } | nc -N 127.0.0.1 $SERVER_PORT > slow.out &
+SLOW=$!
+sleep 0.3
+
+./${EXEC:-main} -R $CONTROL $SERVER_PORT &
+NEW=$!
+
+# The old server exits on its own once the slow client has been answered.
+wait $SLOW
+wait $OLD
+echo "old server exited: $?"
+head -n 1 slow.out
+
+read kept
+write new value
+read new
+
+{ kill -9 $NEW; wait $NEW; } 2>/dev/null || true
+rm -f $CONTROL slow.out
@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# only the owner may use the control socket, a process that connects to it and sends nothing does not hold the server up, and a
+# stopped server removes the socket
+
+PORT=$@
+source tests/lib.sh
+CONTROL=restart.sock
+
+rm -f $CONTROL
+
+start_server -R $CONTROL
+stat -c "control socket mode: %a" $CONTROL
+
+sleep 2 | nc -U $CONTROL >/dev/null &
+SILENT=$!
+sleep 0.3
+curl -sS --max-time 1 http://127.0.0.1:$SERVER_PORT/ping -w " %{http_code}\n"
+wait $SILENT
+
+kill -TERM $SERVER
+wait $SERVER
+echo "server exited: $?"
+[[ -e $CONTROL ]] && echo "control socket left behind" || echo "control socket removed"
+
+rm -f $CONTROL
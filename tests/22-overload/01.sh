@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# accepting pauses at the session threshold, and connections waiting meanwhile are served once sessions finish
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+STATS=$'GET /stats HTTP/1.1'${EOL}${EOL}
+
+start_server -s 2
+
+# Two idle connections reach the threshold.
+sleep 1 | nc -N 127.0.0.1 $SERVER_PORT >/dev/null &
+IDLE1=$!
+sleep 1 | nc -N 127.0.0.1 $SERVER_PORT >/dev/null &
+IDLE2=$!
+sleep 0.3
+
+# This request waits in the backlog until the idle connections close.
+printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT > waiting.out &
+WAITING=$!
+sleep 0.3
+printf "served while paused: %s\n" "$(head -c 15 waiting.out)"
+
+wait $IDLE1 $IDLE2 $WAITING
+printf "served after resuming: %s\n" "$(head -c 15 waiting.out)"
+
+printf "$STATS" | nc -N 127.0.0.1 $SERVER_PORT | grep -a '^accept pauses:' | sed 's/: [1-9][0-9]*$/: at least one/'
+
+rm -f waiting.out
+
+stop_server
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# accepting pauses on the UNIX domain socket too, and its waiting clients are served once sessions finish
+
+PORT=$@
+source tests/lib.sh
+SOCKET=unix.sock
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+start_server -s 2 -u $SOCKET
+
+# Two idle connections reach the threshold.
+sleep 1 | nc -N 127.0.0.1 $SERVER_PORT >/dev/null &
+IDLE1=$!
+sleep 1 | nc -N 127.0.0.1 $SERVER_PORT >/dev/null &
+IDLE2=$!
+sleep 0.3
+
+# This request waits in the backlog of the UNIX socket until the idle connections close.
+printf "$PING" | nc -N -U $SOCKET > waiting.out &
+WAITING=$!
+sleep 0.3
+printf "served while paused: %s\n" "$(head -c 15 waiting.out)"
+
+wait $IDLE1 $IDLE2 $WAITING
+printf "served after resuming: %s\n" "$(head -c 15 waiting.out)"
+
+rm -f waiting.out
+
+stop_server
+rm -f $SOCKET
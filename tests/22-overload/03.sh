@@ -0,0 +1,47 @@
+#!/bin/bash
+
+# with a tiny queueing delay threshold, a burst of requests gets some of them shed with 503, while health checks are always served
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+STATS=$'GET /stats HTTP/1.1'${EOL}${EOL}
+
+start_server -d 1
+
+# The server is stopped while the requests are sent, so it finds all of them ready at once when it continues, and the last ones
+# wait for the ones before them. Every fourth request is a health check.
+CONNECTIONS=()
+for i in $(seq 1 40); do
+    exec {FD}<>/dev/tcp/127.0.0.1/$SERVER_PORT
+    CONNECTIONS+=($FD)
+done
+sleep 0.2
+kill -STOP $SERVER
+for i in ${!CONNECTIONS[@]}; do
+    if ((i % 4 == 0)); then
+        printf "$PING" >&${CONNECTIONS[i]}
+    else
+        printf "$STATS" >&${CONNECTIONS[i]}
+    fi
+done
+kill -CONT $SERVER
+
+SHED=0
+PINGS_FAILED=0
+for i in ${!CONNECTIONS[@]}; do
+    read -r STATUS <&${CONNECTIONS[i]}
+    if ((i % 4 == 0)); then
+        [[ $STATUS == "HTTP/1.1 200 OK"* ]] || ((PINGS_FAILED++))
+    else
+        [[ $STATUS == "HTTP/1.1 503"* ]] && ((SHED++))
+    fi
+    exec {CONNECTIONS[i]}>&-
+done
+
+((SHED > 0)) && echo "requests shed: at least one" || echo "requests shed: none"
+echo "health checks not answered with 200: $PINGS_FAILED"
+
+stop_server
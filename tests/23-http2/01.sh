@@ -0,0 +1,16 @@
+#!/bin/bash
+
+# requests of clients with prior knowledge are served over HTTP/2, files larger than the flow control window included
+
+PORT=$@
+URL=http://127.0.0.1:$PORT
+
+curl -sS --http2-prior-knowledge $URL/ping -w " %{http_code} HTTP/%{http_version}\n"
+curl -sS --http2-prior-knowledge $URL/write -d "This is the data to save" -w " %{http_code}\n"
+curl -sS --http2-prior-knowledge $URL/read -w " %{http_code}\n"
+curl -sS --http2-prior-knowledge $URL/tests/23-http2/missing.html -o /dev/null -w "%{http_code}\n"
+
+dd if=/dev/urandom of=large.bin bs=1k count=200 2>/dev/null
+curl -sS --http2-prior-knowledge $URL/large.bin -o large.out -w "%{http_code} %{size_download}\n"
+cmp large.bin large.out && printf "large file intact\n"
+rm -f large.bin large.out
@@ -0,0 +1,10 @@
+#!/bin/bash
+
+# a request asking to upgrade to h2c is answered over HTTP/2, requests with a body stay on HTTP/1.1
+
+PORT=$@
+URL=http://127.0.0.1:$PORT
+
+curl -sS --http2 $URL/write -d "Written over HTTP/1.1" -w " %{http_code} HTTP/%{http_version}\n"
+curl -sS --http2 $URL/read -w " %{http_code} HTTP/%{http_version}\n"
+curl -sS --http2 $URL/tests/07-files/index.html -o /dev/null -w "%{http_code} HTTP/%{http_version}\n"
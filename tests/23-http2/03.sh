@@ -0,0 +1,35 @@
+#!/bin/bash
+
+# streams sent together on one connection are answered in the order they complete
+
+PORT=$@
+
+PREFACE='PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n'
+SETTINGS='\x00\x00\x00\x04\x00\x00\x00\x00\x00'
+# GET /ping on stream 1, POST /write/h2 on stream 3 with its body in a DATA frame, and GET /read/h2 on stream 5.
+PING='\x00\x00\x09\x01\x05\x00\x00\x00\x01\x82\x86\x04\x05/ping'
+WRITE='\x00\x00\x0d\x01\x04\x00\x00\x00\x03\x83\x86\x04\x09/write/h2'
+BODY='\x00\x00\x05\x00\x01\x00\x00\x00\x03hello'
+READ='\x00\x00\x0c\x01\x05\x00\x00\x00\x05\x82\x86\x04\x08/read/h2'
+
+# Every frame received is printed on a line of its own: type, flags, stream and payload.
+function frames
+{
+    od -An -tx1 -v | tr -s ' \n' '\n' | grep . | awk '
+        function number(hex,    value, k) {
+            value = 0
+            for (k = 1; k <= length(hex); k++) value = value * 16 + index("0123456789abcdef", substr(hex, k, 1)) - 1
+            return value
+        }
+        { bytes[n++] = $1 }
+        END {
+            for (i = 0; i + 9 <= n; i += 9 + size) {
+                size = number(bytes[i] bytes[i + 1] bytes[i + 2])
+                line = "type " bytes[i + 3] " flags " bytes[i + 4] " stream " number(bytes[i + 5] bytes[i + 6] bytes[i + 7] bytes[i + 8]) ":"
+                for (j = 0; j < size; j++) line = line " " bytes[i + 9 + j]
+                print line
+            }
+        }'
+}
+
+printf "${PREFACE}${SETTINGS}${PING}${WRITE}${BODY}${READ}" | nc -N 127.0.0.1 $PORT | frames
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+# a client flooding its connection with PING frames while never reading holds up no other connection, and is disconnected
+
+PORT=$@
+source tests/lib.sh
+
+PREFACE='PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n'
+SETTINGS='\x00\x00\x00\x04\x00\x00\x00\x00\x00'
+PING='\x00\x00\x08\x06\x00\x00\x00\x00\x00pingping'
+
+# 2000000 PING frames, whose acknowledgements fill the socket buffers many times over.
+FLOOD=$(mktemp flood.XXXXXX)
+FORMAT=
+for I in {1..1000}; do FORMAT+=$PING; done
+env printf "$FORMAT" > $FLOOD
+
+start_server
+
+exec 3<>/dev/tcp/127.0.0.1/$SERVER_PORT
+env printf "$PREFACE$SETTINGS" >&3
+( for I in {1..2000}; do cat $FLOOD || break; done >&3 ) 2>/dev/null &
+FLOODER=$!
+sleep 1
+
+curl -sS --max-time 3 http://127.0.0.1:$SERVER_PORT/ping -w " %{http_code}\n"
+curl -sS --max-time 3 --http2-prior-knowledge http://127.0.0.1:$SERVER_PORT/ping -w " %{http_code} HTTP/%{http_version}\n"
+
+TRIES=0
+while kill -0 $FLOODER 2>/dev/null && [[ $TRIES -lt 50 ]]; do
+    ((TRIES++))
+    sleep 0.1
+done
+kill -0 $FLOODER 2>/dev/null && echo "flooding connection still open" || echo "flooding connection closed"
+
+{ kill -9 $FLOODER; wait $FLOODER; } 2>/dev/null
+exec 3<&-
+stop_server
+rm -f $FLOOD
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# clients on the same host are served on the UNIX domain socket by the same handlers and storage as TCP clients
+
+PORT=$@
+source tests/lib.sh
+SOCKET=unix.sock
+
+start_server -u $SOCKET
+
+curl -sS --unix-socket $SOCKET http://localhost/ping -w " %{http_code}\n"
+curl -sS --unix-socket $SOCKET http://localhost/write/local -d "written locally" -w " %{http_code}\n"
+curl -sS http://127.0.0.1:$SERVER_PORT/read/local -w " %{http_code}\n"
+curl -sS --unix-socket $SOCKET --http2-prior-knowledge http://localhost/read/local -w " %{http_code} HTTP/%{http_version}\n"
+
+stop_server
+rm -f $SOCKET
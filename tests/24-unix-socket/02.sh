@@ -0,0 +1,18 @@
+#!/bin/bash
+
+# with an allowed user, clients of the UNIX domain socket running as another user are answered with 403
+
+PORT=$@
+source tests/lib.sh
+SOCKET=unix.sock
+
+function serve
+{
+    start_server -u $SOCKET -U $1
+    curl -sS --unix-socket $SOCKET http://localhost/ping -w " %{http_code}\n"
+    stop_server
+    rm -f $SOCKET
+}
+
+serve $(id -u)
+serve $(( $(id -u) + 1 ))
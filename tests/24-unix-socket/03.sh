@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# a file at the socket path that is not a socket is left alone, and the server exits instead of replacing it
+
+PORT=$@
+source tests/lib.sh
+SOCKET=unix.sock
+
+echo "not a socket" > $SOCKET
+./${EXEC:-main} -u $SOCKET $SERVER_PORT 2>/dev/null
+echo "server exited: $?"
+echo "file kept: $(cat $SOCKET)"
+
+rm -f $SOCKET
@@ -0,0 +1,33 @@
+#!/bin/bash
+
+# sampled requests are captured to a trace in the background, and bench/replay sends the trace to a fresh server
+
+PORT=$@
+source tests/lib.sh
+TRACE=capture.jsonl
+
+rm -f $TRACE
+make -s bench/replay || exit 1
+
+EOL=$'\r\n'
+
+start_server -t $TRACE
+printf "GET /ping HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+printf "POST /write/replayed HTTP/1.1${EOL}Content-Length: 11${EOL}${EOL}\"one\" value" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+printf "GET /missing HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+printf "GET /stats HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT | grep -a '^capture drops:'
+
+# The writer flushes whenever the ring runs empty.
+sleep 0.5
+stop_server
+
+# Arrival times vary from run to run.
+grep -v '/stats' $TRACE | sed -e 's/"at_us":[0-9]*,//'
+
+# The write is replayed too, so the fresh server answers the read.
+start_server
+./bench/replay $SERVER_PORT $TRACE 10 | grep -E '^(requests|answered|2xx|4xx|5xx|failed):'
+curl -sS http://127.0.0.1:$SERVER_PORT/read/replayed -w " %{http_code}\n"
+stop_server
+
+rm -f $TRACE
@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# files packed with pack_gen are served from the pack, also after they are gone from disk, and gzip variants go to clients that accept them
+
+PORT=$@
+source tests/lib.sh
+PACK=assets.pak
+ASSETS=pack-assets
+
+rm -rf $PACK $ASSETS
+make -s pack_gen || exit 1
+
+mkdir -p $ASSETS/css
+printf "small asset\n" > $ASSETS/small.txt
+printf "body { color: red; }\n" > $ASSETS/css/site.css
+seq 1 200000 > $ASSETS/large.txt
+LARGE_MD5=$(md5sum < $ASSETS/large.txt)
+
+./pack_gen -z $PACK ./$ASSETS | sed -e 's/, [0-9]* bytes$//'
+
+rm -rf $ASSETS
+
+start_server -A $PACK
+
+curl -sS http://127.0.0.1:$SERVER_PORT/$ASSETS/small.txt -w "%{http_code}\n"
+curl -sS http://127.0.0.1:$SERVER_PORT/$ASSETS/css/site.css -w "%{http_code}\n"
+
+# Large bodies are sent from the pack's file, plain or compressed.
+[[ $(curl -sS http://127.0.0.1:$SERVER_PORT/$ASSETS/large.txt | md5sum) == $LARGE_MD5 ]] && echo "large plain matches"
+[[ $(curl -sS --compressed http://127.0.0.1:$SERVER_PORT/$ASSETS/large.txt | md5sum) == $LARGE_MD5 ]] && echo "large gzip matches"
+curl -sS -D - -o /dev/null -H "Accept-Encoding: gzip" http://127.0.0.1:$SERVER_PORT/$ASSETS/large.txt | grep -i -E '^(content-encoding|vary):' | tr -d '\r'
+curl -sS -D - -o /dev/null http://127.0.0.1:$SERVER_PORT/$ASSETS/large.txt | grep -i -c '^content-encoding:'
+
+# Codings are matched whole, and a weight of zero refuses them, also when "*" would accept them.
+for ACCEPT in "gzip;q=0" "x-gzip" "gzip;q=0, *" "identity, *;q=0.5" "GZIP ; Q=0.001" "deflate, gzip;q=0.000"; do
+    echo "$ACCEPT: $(curl -sS -D - -o /dev/null -H "Accept-Encoding: $ACCEPT" http://127.0.0.1:$SERVER_PORT/$ASSETS/large.txt \
+        | grep -i -c '^content-encoding: gzip')"
+done
+
+# HTTP/2 streams are answered from the pack too.
+curl -sS --http2-prior-knowledge http://127.0.0.1:$SERVER_PORT/$ASSETS/small.txt -w "%{http_version} %{http_code}\n"
+[[ $(curl -sS --http2-prior-knowledge --compressed http://127.0.0.1:$SERVER_PORT/$ASSETS/large.txt | md5sum) == $LARGE_MD5 ]] && echo "h2 large gzip matches"
+
+# Paths that are not packed still go to the filesystem.
+curl -sS -o /dev/null http://127.0.0.1:$SERVER_PORT/$ASSETS/missing.txt -w "%{http_code}\n"
+curl -sS -o /dev/null http://127.0.0.1:$SERVER_PORT/tests/26-asset-pack/01.sh -w "%{http_code}\n"
+
+stop_server
+
+rm -f $PACK
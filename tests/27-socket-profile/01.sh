@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# responses are unchanged under the socket option profiles, also with the header corked onto a file body, and invalid profiles are refused
+
+PORT=$@
+source tests/lib.sh
+FILE=profile.bin
+
+head -c 300000 /dev/urandom > $FILE
+FILE_MD5=$(md5sum < $FILE)
+
+for PROFILE in latency throughput "defer=2,nodelay,cork,sndbuf=65536"; do
+    echo "== $PROFILE"
+    start_server -P $PROFILE
+    curl -sS http://127.0.0.1:$SERVER_PORT/ping -w " %{http_code}\n"
+    [[ $(curl -sS http://127.0.0.1:$SERVER_PORT/$FILE | md5sum) == $FILE_MD5 ]] && echo "file matches"
+    curl -sS --http2-prior-knowledge http://127.0.0.1:$SERVER_PORT/ping -w " %{http_version}\n"
+    stop_server
+done
+
+for PROFILE in fast "defer" "sndbuf=-1" "nodelay=1" "sndbuf=64k"; do
+    ./${EXEC:-main} -P "$PROFILE" $SERVER_PORT 2>&1
+    echo "exit $?"
+done
+
+rm -f $FILE
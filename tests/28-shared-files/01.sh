@@ -0,0 +1,41 @@
+#!/bin/bash
+
+# concurrent downloads of a large file share one open descriptor, and a file replaced meanwhile is opened afresh
+
+PORT=$@
+source tests/lib.sh
+FILE=shared.bin
+
+head -c 20000000 /dev/urandom > $FILE
+FILE_MD5=$(md5sum < $FILE)
+
+start_server
+
+# Slow clients keep the first download going while the others start.
+for i in 1 2 3 4; do
+    curl -sS --limit-rate 20M http://127.0.0.1:$SERVER_PORT/$FILE -o shared.$i &
+done
+wait $(jobs -p | grep -v "^$SERVER$")
+for i in 1 2 3 4; do
+    [[ $(md5sum < shared.$i) == $FILE_MD5 ]] && echo "download $i matches"
+done
+curl -sS http://127.0.0.1:$SERVER_PORT/stats | grep '^shared file opens:'
+
+# A download started after the file was replaced gets the new file, while the one in flight finishes the old one.
+curl -sS --limit-rate 20M http://127.0.0.1:$SERVER_PORT/$FILE -o shared.old &
+OLD=$!
+sleep 0.3
+head -c 3000000 /dev/urandom > $FILE.new
+NEW_MD5=$(md5sum < $FILE.new)
+mv $FILE.new $FILE
+[[ $(curl -sS http://127.0.0.1:$SERVER_PORT/$FILE | md5sum) == $NEW_MD5 ]] && echo "replaced file matches"
+wait $OLD
+[[ $(md5sum < shared.old) == $FILE_MD5 ]] && echo "download in flight matches"
+curl -sS http://127.0.0.1:$SERVER_PORT/stats | grep '^shared file opens:'
+
+# Nothing is left open once the downloads are done.
+ls -l /proc/$SERVER/fd | grep -c "$FILE"
+
+stop_server
+
+rm -f $FILE shared.1 shared.2 shared.3 shared.4 shared.old
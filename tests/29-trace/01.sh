@@ -0,0 +1,31 @@
+#!/bin/bash
+
+# with tracing compiled in (make TRACE=1), /trace counts every finished request in the histogram of each stage
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+# The objects of the test build are kept apart from the ones runtests.sh built.
+BUILD=$(mktemp -d trace-build.XXXXXX)
+cp *.c *.h routes.def makefile $BUILD
+make -s -C $BUILD main TRACE=1 >/dev/null || { rm -rf $BUILD; exit 1; }
+EXEC=$BUILD/main
+
+start_server
+
+for i in 1 2 3 4 5; do
+    printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+done
+printf "POST /write/traced HTTP/1.1${EOL}Content-Length: 5${EOL}${EOL}hello" | nc -N 127.0.0.1 $SERVER_PORT >/dev/null
+
+# Latencies vary from run to run, so only the request count of every histogram is kept.
+printf "GET /trace HTTP/1.1${EOL}${EOL}" | nc -N 127.0.0.1 $SERVER_PORT | tr -d '\r' | awk '
+    /^window:/ { print "window:", $(NF - 1), $NF }
+    /^[a-z]+: p50/ { count = 0; for (i = 1; i <= NF; i++) if (split($i, bucket, ":") == 2 && bucket[1] ~ /^[0-9]+$/) count += bucket[2]
+                     print $1, count }'
+
+stop_server
+rm -rf $BUILD
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# a server pinned to a core serves requests from it, and one asked for a core that does not exist exits with an error
+
+PORT=$@
+source tests/lib.sh
+
+EOL=$'\r\n'
+PING=$'GET /ping HTTP/1.1'${EOL}${EOL}
+
+start_server -C 0
+grep '^Cpus_allowed_list:' /proc/$SERVER/status | tr -d '\t'
+printf "$PING" | nc -N 127.0.0.1 $SERVER_PORT | head -n 1
+stop_server
+
+./${EXEC:-main} -C 99999 $SERVER_PORT 2>&1 >/dev/null &
+PINNED=$!
+TRIES=0
+while kill -0 $PINNED 2>/dev/null && [[ $TRIES -lt 20 ]]; do
+    ((TRIES++))
+    sleep 0.1
+done
+if kill -0 $PINNED 2>/dev/null; then
+    echo "server with core 99999 still running"
+    { kill -9 $PINNED; wait $PINNED; } 2>/dev/null
+else
+    wait $PINNED
+    echo "server with core 99999 exited: $?"
+fi
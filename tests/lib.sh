@@ -0,0 +1,34 @@
+#!/bin/bash
+
+# Helpers of the tests that run a server of their own, with options of their choosing, next to the one runtests.sh starts on PORT.
+# Source it from the repository root after setting PORT.
+
+# Port of the test's own server.
+SERVER_PORT=$((PORT + 1))
+
+# Starts the test's own server with the given options and waits until it accepts connections, on its UNIX domain socket too if it
+# has one. Sets SERVER.
+function start_server
+{
+    ./${EXEC:-main} "$@" $SERVER_PORT &
+    SERVER=$!
+
+    local SOCKET=
+    local ARGS=("$@")
+    for ((I = 0; I < ${#ARGS[@]}; I++)); do
+        [[ ${ARGS[I]} == -u ]] && SOCKET=${ARGS[I + 1]}
+    done
+
+    TRIES=0
+    until nc -z 127.0.0.1 $SERVER_PORT && [[ -z $SOCKET || -S $SOCKET ]]; do
+        ((TRIES++))
+        [[ $TRIES -gt 20 ]] && exit 1
+        sleep 0.1
+    done
+}
+
+# Stops the test's own server, without a job report.
+function stop_server
+{
+    { kill -9 $SERVER; wait $SERVER; } 2>/dev/null || true
+}
@@ -0,0 +1,143 @@
+/// @file tls.c
+/// @brief Contains functions for the HTTPS listener.
+/// @details This file includes functions to set up the OpenSSL context, to run the handshake of a connection without blocking the event
+/// loop, and to hand the connection over to kTLS. It is only built with -DHTTP_TLS.
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#include "network_utils.h"
+#include "tls.h"
+
+static SSL_CTX* context = NULL;
+
+static void watch(client_session_t* client_info, uint32_t events);
+static void set_blocking(int fd, bool blocking);
+
+/**
+ * @brief Sets up the TLS context.
+ * @details The context is limited to TLS 1.2 with AES-GCM, which the kernel can take over in both directions, and asks OpenSSL to
+ * enable kTLS at the end of every handshake.
+ * @param certificate_path The PEM certificate chain.
+ * @param key_path The PEM private key.
+ * @return Returns 0 on success, or -1 if the certificate or key could not be loaded.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+int tls_init(const char* certificate_path, const char* key_path) {
+    context = SSL_CTX_new(TLS_server_method());
+    if (!context
+        || !SSL_CTX_set_min_proto_version(context, TLS1_2_VERSION)
+        || !SSL_CTX_set_max_proto_version(context, TLS1_2_VERSION)
+        || !SSL_CTX_set_cipher_list(context, "ECDHE+AESGCM")
+        || SSL_CTX_use_certificate_chain_file(context, certificate_path) != 1
+        || SSL_CTX_use_PrivateKey_file(context, key_path, SSL_FILETYPE_PEM) != 1) {
+        fprintf(stderr, "Setting up TLS failed\n");
+        ERR_print_errors_fp(stderr);
+        return -1;
+    }
+
+    SSL_CTX_set_options(context, SSL_OP_ENABLE_KTLS);
+    return 0;
+}
+
+/**
+ * @brief Starts the handshake of an accepted HTTPS connection.
+ * @details The socket is non-blocking for the duration of the handshake, so a slow client cannot stall the event loop.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void tls_start(client_session_t* client_info) {
+    client_info->ssl = SSL_new(context);
+    SSL_set_fd(client_info->ssl, client_info->fd);
+    SSL_set_accept_state(client_info->ssl);
+    set_blocking(client_info->fd, false);
+    client_info->tls_handshaking = true;
+}
+
+/**
+ * @brief Continues the handshake of an HTTPS connection when its socket is ready.
+ * @details Once the handshake is complete, the connection is only kept if the kernel took over both directions, since the rest of the
+ * server sends and receives on the socket directly. It is then served like a plain connection.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void tls_handshake(client_session_t* client_info) {
+    static bool reported = false;
+    int result = SSL_do_handshake(client_info->ssl);
+
+    if (result == 1) {
+        if (!BIO_get_ktls_send(SSL_get_wbio(client_info->ssl)) || !BIO_get_ktls_recv(SSL_get_rbio(client_info->ssl))) {
+            if (!reported) {
+                fprintf(stderr, "kTLS could not be enabled, is the tls kernel module loaded?\n");
+                reported = true;
+            }
+            session_destroy(client_info);
+            return;
+        }
+
+        client_info->tls_handshaking = false;
+        set_blocking(client_info->fd, true);
+        watch(client_info, EPOLLIN);
+        return;
+    }
+
+    switch (SSL_get_error(client_info->ssl, result)) {
+        case SSL_ERROR_WANT_READ:
+            watch(client_info, EPOLLIN);
+            break;
+        case SSL_ERROR_WANT_WRITE:
+            watch(client_info, EPOLLOUT);
+            break;
+        default:
+            ERR_clear_error();
+            session_destroy(client_info);
+            break;
+    }
+}
+
+/**
+ * @brief Frees the TLS state of a connection.
+ * @details No close_notify is sent, responses are delimited by their length or by closing the connection.
+ * @param client_info Pointer to the client session information.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void tls_end(client_session_t* client_info) {
+    if (!client_info->ssl) return;
+
+    SSL_free(client_info->ssl);
+    client_info->ssl = NULL;
+}
+
+/**
+ * @brief Sets the events a connection is monitored for.
+ * @param client_info Pointer to the client session information.
+ * @param events The events.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void watch(client_session_t* client_info, uint32_t events) {
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.ptr = client_info;
+    Epoll_ctl(client_info->epfd, EPOLL_CTL_MOD, client_info->fd, &event);
+}
+
+/**
+ * @brief Switches a socket between blocking and non-blocking mode.
+ * @param fd The socket.
+ * @param blocking Whether the socket should block.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void set_blocking(int fd, bool blocking) {
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK);
+}
@@ -0,0 +1,29 @@
+#ifndef TLS_H
+#define TLS_H
+
+#include "client_session.h"
+
+/// @file tls.h
+/// @brief Contains function declarations for the HTTPS listener.
+/// @details TLS is compiled in with -DHTTP_TLS (make TLS=1) and uses OpenSSL for the handshake only. Once a connection has
+/// completed its handshake, its session keys are handed to the kernel with kTLS, and from then on the socket is used like a plain one:
+/// the kernel encrypts what is sent, including files sent with sendfile, and decrypts what is received.
+
+#ifdef HTTP_TLS
+
+int tls_init(const char* certificate_path, const char* key_path);
+void tls_start(client_session_t* client_info);
+void tls_handshake(client_session_t* client_info);
+void tls_end(client_session_t* client_info);
+
+#define TLS_HANDSHAKING(session) ((session)->tls_handshaking)
+#define TLS_HANDSHAKE(session) tls_handshake(session)
+
+#else
+
+#define TLS_HANDSHAKING(session) false
+#define TLS_HANDSHAKE(session) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,229 @@
+/// @file trace.c
+/// @brief Contains functions for tracing requests.
+/// @details This file includes functions to timestamp the stages of a request, to fold finished requests into per-stage log2 histograms,
+/// to keep the slowest requests of the current window, and to dump both. It is only built with -DHTTP_TRACE.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "trace.h"
+
+// Latencies are bucketed by the position of their highest bit in nanoseconds, bucket 40 is about 18 minutes.
+#define TRACE_BUCKETS 41
+
+// Number of slowest requests kept per window.
+#define TRACE_SLOWEST 8
+
+static const char* stage_names[TRACE_STAGES] = { "recv", "parse", "route", "handler", "send" };
+
+static uint64_t histograms[TRACE_STAGES][TRACE_BUCKETS];
+static uint64_t total_histogram[TRACE_BUCKETS];
+
+static trace_t slowest[TRACE_SLOWEST];
+static size_t slowest_count = 0;
+static uint64_t window_start = 0;
+static uint64_t window_requests = 0;
+
+static uint64_t now_ns();
+static int bucket_of(uint64_t ns);
+static size_t dump_histogram(const char* name, const uint64_t* histogram, char* buffer, size_t size);
+static uint64_t stage_duration(const trace_t* trace, int stage);
+
+/**
+ * @brief Starts tracing a request.
+ * @details Later calls for the same request leave the trace alone, so it can be called for every piece of a request.
+ * @param trace The trace of the request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void trace_start(trace_t* trace) {
+    if (trace->start != 0) return;
+
+    memset(trace, 0, sizeof(*trace));
+    trace->start = now_ns();
+    if (window_start == 0) window_start = trace->start;
+}
+
+/**
+ * @brief Records the end of a stage.
+ * @param trace The trace of the request.
+ * @param stage The stage that just ended.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void trace_stamp(trace_t* trace, trace_stage_t stage) {
+    trace->stamps[stage] = now_ns();
+}
+
+/**
+ * @brief Records the path of a request, truncated to TRACE_PATH_MAX bytes.
+ * @param trace The trace of the request.
+ * @param path The requested path.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void trace_request(trace_t* trace, const char* path) {
+    snprintf(trace->path, sizeof(trace->path), "%s", path);
+}
+
+/**
+ * @brief Folds a finished request into the histograms and the slowest requests of the window.
+ * @details Requests that were not answered are ignored. Stages a request skipped, like routing for a malformed request, are not counted.
+ * @param trace The trace of the request.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+void trace_finish(trace_t* trace) {
+    if (trace->start == 0 || trace->stamps[TRACE_SEND] == 0) return;
+
+    for (int stage = 0; stage < TRACE_STAGES; stage++) {
+        if (trace->stamps[stage]) {
+            histograms[stage][bucket_of(stage_duration(trace, stage))]++;
+        }
+    }
+
+    uint64_t total = trace->stamps[TRACE_SEND] - trace->start;
+    total_histogram[bucket_of(total)]++;
+    window_requests++;
+
+    // Replace the fastest of the kept requests once the list is full.
+    size_t slot = slowest_count;
+    if (slowest_count == TRACE_SLOWEST) {
+        slot = 0;
+        for (size_t i = 1; i < TRACE_SLOWEST; i++) {
+            if (slowest[i].stamps[TRACE_SEND] - slowest[i].start < slowest[slot].stamps[TRACE_SEND] - slowest[slot].start) {
+                slot = i;
+            }
+        }
+        if (total <= slowest[slot].stamps[TRACE_SEND] - slowest[slot].start) return;
+    } else {
+        slowest_count++;
+    }
+    slowest[slot] = *trace;
+}
+
+/**
+ * @brief Dumps the histograms and the slowest requests of the current window, and starts a new window.
+ * @details Histogram lines list the approximate p50, p99 and maximum, followed by the count of every non-empty bucket as
+ * "<log2 of the upper bound in ns>:<count>". The histograms cover every request since startup.
+ * @param buffer The buffer to print into.
+ * @param size The size of the buffer.
+ * @return Returns the number of bytes printed, at most size - 1.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+size_t trace_dump(char* buffer, size_t size) {
+    uint64_t now = now_ns();
+    size_t used = snprintf(buffer, size, "window: %llu ms, %llu requests\n",
+        (unsigned long long)(window_start ? (now - window_start) / 1000000 : 0), (unsigned long long)window_requests);
+
+    for (int stage = 0; stage < TRACE_STAGES && used < size; stage++) {
+        used += dump_histogram(stage_names[stage], histograms[stage], buffer + used, size - used);
+    }
+    if (used < size) {
+        used += dump_histogram("total", total_histogram, buffer + used, size - used);
+    }
+
+    for (size_t i = 0; i < slowest_count && used < size; i++) {
+        const trace_t* trace = &slowest[i];
+        used += snprintf(buffer + used, size - used, "slow: %s total %llu us",
+            trace->path[0] ? trace->path : "-", (unsigned long long)(trace->stamps[TRACE_SEND] - trace->start) / 1000);
+
+        for (int stage = 0; stage < TRACE_STAGES && used < size; stage++) {
+            if (trace->stamps[stage]) {
+                used += snprintf(buffer + used, size - used, " %s %llu us", stage_names[stage],
+                    (unsigned long long)stage_duration(trace, stage) / 1000);
+            }
+        }
+        if (used < size) {
+            used += snprintf(buffer + used, size - used, "\n");
+        }
+    }
+
+    slowest_count = 0;
+    window_requests = 0;
+    window_start = now;
+
+    return used < size ? used : size - 1;
+}
+
+/**
+ * @brief Gets the duration of a stage.
+ * @param trace The trace of a request.
+ * @param stage A stage the request went through.
+ * @return Returns the time from the end of the latest earlier stage, or the start of the request, to the end of the stage.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint64_t stage_duration(const trace_t* trace, int stage) {
+    uint64_t previous = trace->start;
+    for (int earlier = stage - 1; earlier >= 0; earlier--) {
+        if (trace->stamps[earlier]) {
+            previous = trace->stamps[earlier];
+            break;
+        }
+    }
+    return trace->stamps[stage] - previous;
+}
+
+/**
+ * @brief Prints one histogram line.
+ * @param name The name of the histogram.
+ * @param histogram The bucket counts.
+ * @param buffer The buffer to print into.
+ * @param size The size of the buffer.
+ * @return Returns the number of bytes snprintf wanted to print.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static size_t dump_histogram(const char* name, const uint64_t* histogram, char* buffer, size_t size) {
+    uint64_t count = 0;
+    for (int i = 0; i < TRACE_BUCKETS; i++) {
+        count += histogram[i];
+    }
+
+    // The upper bound of the bucket holding each percentile, in microseconds.
+    uint64_t p50 = 0, p99 = 0, max = 0, seen = 0;
+    for (int i = 0; i < TRACE_BUCKETS; i++) {
+        if (histogram[i] == 0) continue;
+        seen += histogram[i];
+        uint64_t bound = ((uint64_t)1 << i) / 1000;
+        if (!p50 && seen * 2 >= count) p50 = bound ? bound : 1;
+        if (!p99 && seen * 100 >= count * 99) p99 = bound ? bound : 1;
+        max = bound ? bound : 1;
+    }
+
+    size_t used = snprintf(buffer, size, "%s: p50 <%llu us, p99 <%llu us, max <%llu us |", name,
+        (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)max);
+
+    for (int i = 0; i < TRACE_BUCKETS && used < size; i++) {
+        if (histogram[i]) {
+            used += snprintf(buffer + used, size - used, " %d:%llu", i, (unsigned long long)histogram[i]);
+        }
+    }
+    if (used < size) {
+        used += snprintf(buffer + used, size - used, "\n");
+    }
+
+    return used;
+}
+
+/**
+ * @brief Finds the histogram bucket of a latency.
+ * @param ns The latency in nanoseconds.
+ * @return Returns the smallest i with ns < 2^i, capped at the last bucket.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static int bucket_of(uint64_t ns) {
+    int bucket = ns ? 64 - __builtin_clzll(ns) : 0;
+    return bucket < TRACE_BUCKETS ? bucket : TRACE_BUCKETS - 1;
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return Returns the current time in nanoseconds.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static uint64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+}
@@ -0,0 +1,56 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// @file trace.h
+/// @brief Contains the request tracing macros and function declarations.
+/// @details Tracing is compiled in with -DHTTP_TRACE (make TRACE=1). Each request then records a CLOCK_MONOTONIC timestamp at every
+/// stage boundary, per-stage latencies are kept in log2 histograms, and the slowest requests of each window are kept for /trace.
+/// Without HTTP_TRACE the macros expand to nothing and the session carries no trace state.
+
+// The stages of a request, each ending at the timestamp of the same index.
+typedef enum {
+    TRACE_RECV,     // Receiving the request.
+    TRACE_PARSE,    // Parsing the request line.
+    TRACE_ROUTE,    // Looking the route up.
+    TRACE_HANDLER,  // Running the handler.
+    TRACE_SEND,     // Sending the response, including waiting for the write-ahead log.
+    TRACE_STAGES
+} trace_stage_t;
+
+#define TRACE_PATH_MAX 64
+
+// Size of the buffer /trace dumps into.
+#define TRACE_DUMP_MAX 8192
+
+typedef struct {
+    uint64_t start;
+    uint64_t stamps[TRACE_STAGES];
+    char path[TRACE_PATH_MAX];
+} trace_t;
+
+#ifdef HTTP_TRACE
+
+void trace_start(trace_t* trace);
+void trace_stamp(trace_t* trace, trace_stage_t stage);
+void trace_request(trace_t* trace, const char* path);
+void trace_finish(trace_t* trace);
+size_t trace_dump(char* buffer, size_t size);
+
+#define TRACE_START(session) trace_start(&(session)->trace)
+#define TRACE_STAMP(session, stage) trace_stamp(&(session)->trace, (stage))
+#define TRACE_REQUEST(session, path) trace_request(&(session)->trace, (path))
+#define TRACE_FINISH(session) trace_finish(&(session)->trace)
+
+#else
+
+#define TRACE_START(session) ((void)0)
+#define TRACE_STAMP(session, stage) ((void)0)
+#define TRACE_REQUEST(session, path) ((void)0)
+#define TRACE_FINISH(session) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,422 @@
+/// @file wal.c
+/// @brief Contains functions for the write-ahead log of the storage.
+/// @details This file includes functions to append stored values to a checksummed log, to sync the log once per batch of writes,
+/// to replay the log into storage on startup, and to compact the log into a snapshot of the stored values.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "constants.h"
+#include "storage.h"
+#include "network_utils.h"
+#include "wal.h"
+
+// The log is compacted once it holds at least WAL_COMPACT_MIN bytes and has grown WAL_COMPACT_RATIO times past the last snapshot.
+#define WAL_COMPACT_MIN (1024 * 1024)
+#define WAL_COMPACT_RATIO 4
+
+// Batch buffers grown past this size by a snapshot are not kept around.
+#define WAL_BATCH_KEEP (64 * 1024)
+
+// Every record is a header followed by the key and the value. The checksum covers the lengths, the key and the value,
+// so a torn or corrupted record at the end of the log is detected on replay.
+typedef struct {
+    uint32_t checksum;
+    uint32_t key_length;
+    uint32_t value_length;
+} wal_record_t;
+
+static int wal_fd = -1;
+static char* wal_path = NULL;
+
+// Records appended since the last sync.
+static char* batch = NULL;
+static size_t batch_length = 0;
+static size_t batch_capacity = 0;
+
+static off_t log_size = 0;
+static off_t snapshot_size = 0;
+
+static uint32_t crc_table[256];
+
+static void crc_init();
+static uint32_t crc_update(uint32_t crc, const void* data, size_t length);
+static off_t wal_replay(const char* log, off_t size);
+static void batch_record(const char* key, const char* data, size_t length);
+static void snapshot_record(const char* key, storage_t* storage, void* ctx);
+static int write_all(int fd, const char* data, size_t length);
+static void wal_compact();
+
+/**
+ * @brief Opens the write-ahead log and recovers the stored values from it.
+ * @details This function replays every intact record of the log into storage, in order, so the last value written to a key wins.
+ * A torn or corrupted tail left behind by a crash is cut off, and later records are appended after the last intact one.
+ * @param path The path of the log. It is created if it does not exist.
+ * @return Returns 0 on success, or -1 if the log could not be opened.
+ * @note Time complexity: O(n) where n is the size of the log. Space complexity: O(m) where m is the size of the recovered values.
+ */
+int wal_open(const char* path) {
+    crc_init();
+
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        perror("Opening write-ahead log failed");
+        return -1;
+    }
+
+    struct stat log_stat;
+    if (fstat(fd, &log_stat) < 0) {
+        perror("Reading write-ahead log failed");
+        close(fd);
+        return -1;
+    }
+
+    off_t valid_size = 0;
+    if (log_stat.st_size > 0) {
+        char* log = mmap(NULL, log_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (log == MAP_FAILED) {
+            perror("Reading write-ahead log failed");
+            close(fd);
+            return -1;
+        }
+
+        valid_size = wal_replay(log, log_stat.st_size);
+        munmap(log, log_stat.st_size);
+    }
+
+    if (valid_size < log_stat.st_size) {
+        if (ftruncate(fd, valid_size) < 0 || fdatasync(fd) < 0) {
+            perror("Truncating write-ahead log failed");
+            close(fd);
+            return -1;
+        }
+    }
+
+    size_t path_length = strlen(path);
+    wal_path = Malloc(path_length + 1);
+    memcpy(wal_path, path, path_length + 1);
+
+    wal_fd = fd;
+    log_size = valid_size;
+    snapshot_size = valid_size;
+    return 0;
+}
+
+/**
+ * @brief Checks whether persistence is enabled.
+ * @return Returns true if the write-ahead log is open, false otherwise.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool wal_enabled() {
+    return wal_fd >= 0;
+}
+
+/**
+ * @brief Appends a stored value to the log.
+ * @details This function only adds the record to the current batch. The value is durable once wal_sync has returned.
+ * @param key The key of the value, or "" for the default value.
+ * @param data The stored value.
+ * @param length The length of the value.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) amortized where n is the length of the value. Space complexity: O(n).
+ */
+void wal_append(const char* key, const char* data, size_t length) {
+    batch_record(key, data, length);
+}
+
+/**
+ * @brief Checks whether records are waiting to be synced.
+ * @return Returns true if the current batch is not empty, false otherwise.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+bool wal_pending() {
+    return batch_length > 0;
+}
+
+/**
+ * @brief Makes the current batch of records durable.
+ * @details This function writes all records appended since the last sync with a single write and syncs them with a single fdatasync,
+ * so the cost of the sync is shared by every write of the batch. The log is compacted afterwards if it has grown enough.
+ * The server exits if the log cannot be written, since the writes of the batch could not be acknowledged.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the batch. Space complexity: O(1).
+ */
+void wal_sync() {
+    if (batch_length == 0) return;
+
+    if (write_all(wal_fd, batch, batch_length) < 0 || fdatasync(wal_fd) < 0) {
+        perror("Writing write-ahead log failed");
+        exit(EXIT_FAILURE);
+    }
+
+    log_size += batch_length;
+    batch_length = 0;
+
+    if (log_size >= WAL_COMPACT_MIN && log_size > WAL_COMPACT_RATIO * snapshot_size) {
+        wal_compact();
+    }
+}
+
+/**
+ * @brief Closes the write-ahead log.
+ * @details This function syncs the pending records before closing the log.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the batch. Space complexity: O(1).
+ */
+void wal_close() {
+    if (wal_fd < 0) return;
+
+    wal_sync();
+    close(wal_fd);
+    wal_fd = -1;
+
+    free(wal_path);
+    free(batch);
+    wal_path = NULL;
+    batch = NULL;
+    batch_capacity = 0;
+}
+
+/**
+ * @brief Writes a snapshot of the stored values to a file.
+ * @details The snapshot uses the record format of the log, so it can be loaded with wal_import. Records waiting to be synced are kept.
+ * @param fd The file to write to.
+ * @return Returns 0 on success, or -1 on error.
+ * @note Time complexity: O(n) where n is the size of the stored values. Space complexity: O(n).
+ */
+int wal_export(int fd) {
+    crc_init();
+
+    size_t pending = batch_length;
+    storage_foreach(snapshot_record, NULL);
+
+    if (batch_length == pending) return 0;
+
+    int result = write_all(fd, batch + pending, batch_length - pending);
+    batch_length = pending;
+
+    if (batch_length == 0 && batch_capacity > WAL_BATCH_KEEP) {
+        free(batch);
+        batch = NULL;
+        batch_capacity = 0;
+    }
+    return result;
+}
+
+/**
+ * @brief Loads a snapshot written by wal_export into storage.
+ * @param fd The file holding the snapshot.
+ * @return Returns 0 on success, or -1 if the snapshot could not be read.
+ * @note Time complexity: O(n) where n is the size of the snapshot. Space complexity: O(m) where m is the size of the loaded values.
+ */
+int wal_import(int fd) {
+    crc_init();
+
+    struct stat snapshot_stat;
+    if (fstat(fd, &snapshot_stat) < 0) return -1;
+    if (snapshot_stat.st_size == 0) return 0;
+
+    char* snapshot = mmap(NULL, snapshot_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (snapshot == MAP_FAILED) return -1;
+
+    wal_replay(snapshot, snapshot_stat.st_size);
+    munmap(snapshot, snapshot_stat.st_size);
+    return 0;
+}
+
+/**
+ * @brief Replays the records of a log into storage.
+ * @param log The contents of the log.
+ * @param size The size of the log.
+ * @return Returns the size of the intact prefix of the log.
+ * @note Time complexity: O(n) where n is the size of the log. Space complexity: O(m) where m is the size of the recovered values.
+ */
+static off_t wal_replay(const char* log, off_t size) {
+    off_t offset = 0;
+    char key[KEY_MAX + 1];
+
+    while (size - offset >= (off_t)sizeof(wal_record_t)) {
+        wal_record_t record;
+        memcpy(&record, log + offset, sizeof(record));
+
+        const char* payload = log + offset + sizeof(record);
+        off_t record_size = sizeof(record) + (off_t)record.key_length + (off_t)record.value_length;
+        if (record.key_length > KEY_MAX || record_size > size - offset) break;
+
+        uint32_t checksum = crc_update(0, &record.key_length, sizeof(record) - sizeof(record.checksum));
+        checksum = crc_update(checksum, payload, record.key_length + (size_t)record.value_length);
+        if (checksum != record.checksum) break;
+
+        memcpy(key, payload, record.key_length);
+        key[record.key_length] = '\0';
+
+        storage_stream_t value;
+        storage_stream_begin(&value);
+        if (record.value_length > 0) {
+            storage_stream_append(&value, payload + record.key_length, record.value_length);
+        }
+        // A key refused by the admission filter is skipped, as it would have been when it was first written.
+        storage_t* storage = storage_lookup(key, true);
+        if (storage) {
+            storage_stream_commit(storage, &value);
+        } else {
+            storage_stream_abort(&value);
+        }
+
+        offset += record_size;
+    }
+
+    return offset;
+}
+
+/**
+ * @brief Adds a record to the current batch.
+ * @param key The key of the value.
+ * @param data The value.
+ * @param length The length of the value.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) amortized where n is the length of the value. Space complexity: O(n).
+ */
+static void batch_record(const char* key, const char* data, size_t length) {
+    wal_record_t record;
+    record.key_length = strlen(key);
+    record.value_length = length;
+
+    size_t record_size = sizeof(record) + record.key_length + length;
+    if (batch_length + record_size > batch_capacity) {
+        size_t capacity = batch_capacity ? batch_capacity : 4096;
+        while (capacity < batch_length + record_size) {
+            capacity *= 2;
+        }
+        batch = Realloc(batch, capacity);
+        batch_capacity = capacity;
+    }
+
+    record.checksum = crc_update(0, &record.key_length, sizeof(record) - sizeof(record.checksum));
+    record.checksum = crc_update(record.checksum, key, record.key_length);
+    record.checksum = crc_update(record.checksum, data, length);
+
+    char* out = batch + batch_length;
+    memcpy(out, &record, sizeof(record));
+    memcpy(out + sizeof(record), key, record.key_length);
+    memcpy(out + sizeof(record) + record.key_length, data, length);
+    batch_length += record_size;
+}
+
+/**
+ * @brief Adds the current value of a key to a snapshot.
+ * @param key The key of the value.
+ * @param storage The storage of the value.
+ * @param ctx Unused.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) amortized where n is the length of the value. Space complexity: O(n).
+ */
+static void snapshot_record(const char* key, storage_t* storage, void* ctx) {
+    if (storage->value->length > 0) {
+        batch_record(key, storage->value->data, storage->value->length);
+    }
+}
+
+/**
+ * @brief Replaces the log with a snapshot of the stored values.
+ * @details The snapshot holds one record per non-empty value. It is written and synced next to the log and then renamed over it,
+ * so a crash at any point leaves either the old log or the complete snapshot behind. If the snapshot fails, the old log is kept.
+ * @return This function does not return a value.
+ * @note Time complexity: O(n) where n is the size of the stored values. Space complexity: O(n).
+ */
+static void wal_compact() {
+    size_t path_length = strlen(wal_path);
+    char snapshot_path[path_length + sizeof(".tmp")];
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s.tmp", wal_path);
+
+    storage_foreach(snapshot_record, NULL);
+
+    int fd = open(snapshot_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0 || write_all(fd, batch, batch_length) < 0 || fdatasync(fd) < 0 || rename(snapshot_path, wal_path) < 0) {
+        perror("Compacting write-ahead log failed");
+        if (fd >= 0) {
+            close(fd);
+            unlink(snapshot_path);
+        }
+        batch_length = 0;
+        return;
+    }
+
+    // Make the rename itself durable.
+    char* slash = strrchr(wal_path, '/');
+    if (slash) *slash = '\0';
+    int dirfd = open(slash ? (slash == wal_path ? "/" : wal_path) : ".", O_RDONLY | O_DIRECTORY);
+    if (slash) *slash = '/';
+    if (dirfd >= 0) {
+        fsync(dirfd);
+        close(dirfd);
+    }
+
+    close(wal_fd);
+    wal_fd = fd;
+    log_size = batch_length;
+    snapshot_size = batch_length;
+    batch_length = 0;
+
+    if (batch_capacity > WAL_BATCH_KEEP) {
+        free(batch);
+        batch = NULL;
+        batch_capacity = 0;
+    }
+}
+
+/**
+ * @brief Writes a buffer to a file, retrying partial writes.
+ * @param fd The file descriptor.
+ * @param data The data to be written.
+ * @param length The length of the data.
+ * @return Returns 0 on success, or -1 on error.
+ * @note Time complexity: O(n) where n is the length of the data. Space complexity: O(1).
+ */
+static int write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) return -1;
+        data += written;
+        length -= written;
+    }
+    return 0;
+}
+
+/**
+ * @brief Builds the lookup table of the CRC-32 checksum.
+ * @return This function does not return a value.
+ * @note Time complexity: O(1). Space complexity: O(1).
+ */
+static void crc_init() {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+        }
+        crc_table[i] = crc;
+    }
+}
+
+/**
+ * @brief Extends a CRC-32 checksum with more data.
+ * @param crc The checksum of the preceding data, or 0.
+ * @param data The data.
+ * @param length The length of the data.
+ * @return Returns the checksum of the preceding data followed by the data.
+ * @note Time complexity: O(n) where n is the length of the data. Space complexity: O(1).
+ */
+static uint32_t crc_update(uint32_t crc, const void* data, size_t length) {
+    const unsigned char* bytes = data;
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc = crc_table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
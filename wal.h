@@ -0,0 +1,21 @@
+#ifndef WAL_H
+#define WAL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/// @file wal.h
+/// @brief Contains function declarations for the write-ahead log of the storage.
+/// @details When persistence is enabled, every stored value is appended to a checksummed log. Records are batched in memory and
+/// written and synced together once per event loop iteration, and the log is replayed into storage on startup.
+
+int wal_open(const char* path);
+bool wal_enabled();
+void wal_append(const char* key, const char* data, size_t length);
+bool wal_pending();
+void wal_sync();
+void wal_close();
+int wal_export(int fd);
+int wal_import(int fd);
+
+#endif